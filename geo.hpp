@@ -25,11 +25,213 @@
  * hierarchies used in Object Oriented Programming.
  */
 
+#ifndef GEO_HPP
+#define GEO_HPP
+
 #include <cmath>
+#include <type_traits>
 
 namespace Geo {
 
-/** @brief Two dimensional space point */
+/**
+ * @brief Two dimensional space coordinates
+ *
+ * Non-polymorphic value type used by the shapes to store their reference
+ * point. It's trivially copyable and has standard layout, so an array of
+ * coordinates could be treated as interleaved X and Y values.
+ */
+class Coord2D final {
+private:
+  double x;
+  double y;
+
+public:
+  /** @brief Construct coordinates at the origin */
+  constexpr Coord2D() : x(0), y(0) {}
+  /**
+   * @brief Construct 2D coordinates from X and Y values
+   * @param px X coordinate value
+   * @param py Y coordinate value
+   */
+  constexpr Coord2D(double px, double py) : x(px), y(py) {}
+
+  /** @brief Retrieves X coordinate value */
+  constexpr double getX(void) const { return x; }
+  /** @brief Retrieves Y coordinate value */
+  constexpr double getY(void) const { return y; }
+};
+
+/**
+ * @brief Three dimensional space coordinates
+ *
+ * Non-polymorphic value type used by the 3D shapes. Like Coord2D it could
+ * be treated as interleaved X, Y and Z values when stored in an array.
+ */
+class Coord3D final {
+private:
+  double x;
+  double y;
+  double z;
+
+public:
+  /** @brief Construct coordinates at the origin */
+  constexpr Coord3D() : x(0), y(0), z(0) {}
+  /**
+   * @brief Construct 3D coordinates from X, Y and Z values
+   * @param px X coordinate value
+   * @param py Y coordinate value
+   * @param pz Z coordinate value
+   */
+  constexpr Coord3D(double px, double py, double pz) : x(px), y(py), z(pz) {}
+
+  /** @brief Retrieves X coordinate value */
+  constexpr double getX(void) const { return x; }
+  /** @brief Retrieves Y coordinate value */
+  constexpr double getY(void) const { return y; }
+  /** @brief Retrieves Z coordinate value */
+  constexpr double getZ(void) const { return z; }
+  /** @brief Retrieves projection of the coordinates on the XY plane */
+  constexpr Coord2D getXY(void) const { return Coord2D(x, y); }
+};
+
+static_assert(std::is_trivially_copyable<Coord2D>::value &&
+              std::is_standard_layout<Coord2D>::value &&
+              sizeof(Coord2D) == 2 * sizeof(double),
+              "Coord2D must be layout compatible with double[2]");
+static_assert(std::is_trivially_copyable<Coord3D>::value &&
+              std::is_standard_layout<Coord3D>::value &&
+              sizeof(Coord3D) == 3 * sizeof(double),
+              "Coord3D must be layout compatible with double[3]");
+
+/**
+ * @brief Formulas for shapes' measures
+ *
+ * Shared by the class hierarchy below and by the other representations of
+ * shapes (static, columnar, etc.), so all of them calculate the same values.
+ * Formulas are templates, so they could be evaluated in single precision,
+ * but only in floating point.
+ */
+namespace Formula {
+
+/**
+ * @brief Result type of the formulas
+ *
+ * Deduced arguments of integral type (e.g. circleArea(2)) would compute
+ * in integers and truncate the constants, so they are rejected.
+ */
+template <class T> struct Real {
+  static_assert(std::is_floating_point<T>::value, "Geo::Formula: arguments must be floating point");
+  using type = T;
+};
+
+/** @brief Circle's area \f$πr^2\f$ */
+template <class T> constexpr typename Real<T>::type circleArea(T r) { return T(M_PI) * r * r; }
+/** @brief Circle's perimeter \f$2πr\f$ */
+template <class T> constexpr typename Real<T>::type circlePerimeter(T r) { return 2 * T(M_PI) * r; }
+/** @brief Rectangle's area */
+template <class T> constexpr typename Real<T>::type rectangleArea(T w, T h) { return w * h; }
+/** @brief Rectangle's perimeter */
+template <class T> constexpr typename Real<T>::type rectanglePerimeter(T w, T h) { return 2 * w + 2 * h; }
+/** @brief Square's area */
+template <class T> constexpr typename Real<T>::type squareArea(T s) { return s * s; }
+/** @brief Square's perimeter */
+template <class T> constexpr typename Real<T>::type squarePerimeter(T s) { return s * 4; }
+/** @brief Sphere's surface area \f$4πr^2\f$ */
+template <class T> constexpr typename Real<T>::type sphereArea(T r) { return 4 * T(M_PI) * r * r; }
+/** @brief Sphere's volume \f$\frac{4}{3}πr^3\f$ */
+template <class T> constexpr typename Real<T>::type sphereVolume(T r) { return T(4.0/3.0 * M_PI) * r * r * r; }
+/** @brief Cube's surface area \f$6a^2\f$ */
+template <class T> constexpr typename Real<T>::type cubeArea(T a) { return squareArea(a) * 6; }
+/** @brief Cube's volume \f$a^3\f$ */
+template <class T> constexpr typename Real<T>::type cubeVolume(T a) { return a * a * a; }
+/** @brief Radius of rectangle's circumscribed circle \f$\frac{\sqrt{w^2+h^2}}{2}\f$ */
+template <class T> inline typename Real<T>::type rectangleCircumradius(T w, T h) { return std::sqrt(w * w + h * h) / 2; }
+/** @brief Radius of square's circumscribed circle \f$\frac{\sqrt{2}}{2}s\f$ */
+template <class T> constexpr typename Real<T>::type squareCircumradius(T s) { return T(M_SQRT1_2) * s; }
+/** @brief Radius of cube's circumscribed sphere \f$\frac{\sqrt{3}}{2}a\f$ */
+template <class T> constexpr typename Real<T>::type cubeCircumradius(T a) { return T(0.86602540378443864676) * a; }
+/** @brief Area of rectangle with corners rounded by radius \f$r\f$ \f$wh - (4 - π)r^2\f$ */
+template <class T> constexpr typename Real<T>::type roundedRectangleArea(T w, T h, T r) { return w * h - T(4 - M_PI) * r * r; }
+/** @brief Perimeter of rectangle with corners rounded by radius \f$r\f$ \f$2w + 2h - (8 - 2π)r\f$ */
+template <class T> constexpr typename Real<T>::type roundedRectanglePerimeter(T w, T h, T r) { return 2 * w + 2 * h - T(8 - 2 * M_PI) * r; }
+/** @brief Surface area of cube with edge \f$a\f$ and edges and vertices rounded by radius \f$r\f$ */
+template <class T> constexpr typename Real<T>::type roundedCubeArea(T a, T r) {
+  return 6 * (a - 2 * r) * (a - 2 * r) + 6 * T(M_PI) * (a - 2 * r) * r + 4 * T(M_PI) * r * r;
+}
+/** @brief Volume of cube with edge \f$a\f$ and edges and vertices rounded by radius \f$r\f$ */
+template <class T> constexpr typename Real<T>::type roundedCubeVolume(T a, T r) {
+  return (a - 2 * r) * (a - 2 * r) * (a - 2 * r) + 6 * (a - 2 * r) * (a - 2 * r) * r +
+         3 * T(M_PI) * (a - 2 * r) * r * r + T(4.0/3.0 * M_PI) * r * r * r;
+}
+
+}
+
+/**
+ * @brief Axis-aligned bounding box in two dimensions
+ *
+ * Like the coordinates it's a trivially copyable value type, so boxes of
+ * many shapes could be kept in arrays or columns.
+ */
+struct BoundingBox2D {
+  /** @brief Corner with minimal coordinates */
+  Coord2D min;
+  /** @brief Corner with maximal coordinates */
+  Coord2D max;
+
+  /** @brief Checks whether the box overlaps other box (touching counts) */
+  constexpr bool overlaps(const BoundingBox2D & o) const {
+    return min.getX() <= o.max.getX() && o.min.getX() <= max.getX() &&
+           min.getY() <= o.max.getY() && o.min.getY() <= max.getY();
+  }
+  /** @brief Checks whether the box contains a point */
+  constexpr bool contains(const Coord2D & p) const {
+    return min.getX() <= p.getX() && p.getX() <= max.getX() &&
+           min.getY() <= p.getY() && p.getY() <= max.getY();
+  }
+};
+
+/** @brief Axis-aligned bounding box in three dimensions */
+struct BoundingBox3D {
+  /** @brief Corner with minimal coordinates */
+  Coord3D min;
+  /** @brief Corner with maximal coordinates */
+  Coord3D max;
+
+  /** @brief Checks whether the box overlaps other box (touching counts) */
+  constexpr bool overlaps(const BoundingBox3D & o) const {
+    return min.getX() <= o.max.getX() && o.min.getX() <= max.getX() &&
+           min.getY() <= o.max.getY() && o.min.getY() <= max.getY() &&
+           min.getZ() <= o.max.getZ() && o.min.getZ() <= max.getZ();
+  }
+  /** @brief Checks whether the box contains a point */
+  constexpr bool contains(const Coord3D & p) const {
+    return min.getX() <= p.getX() && p.getX() <= max.getX() &&
+           min.getY() <= p.getY() && p.getY() <= max.getY() &&
+           min.getZ() <= p.getZ() && p.getZ() <= max.getZ();
+  }
+};
+
+/** @brief Bounding circle given by center and radius */
+struct BoundingCircle {
+  /** @brief Center */
+  Coord2D center;
+  /** @brief Radius */
+  double radius;
+};
+
+/** @brief Bounding sphere given by center and radius */
+struct BoundingSphere {
+  /** @brief Center */
+  Coord3D center;
+  /** @brief Radius */
+  double radius;
+};
+
+/**
+ * @brief Two dimensional space point
+ *
+ * Polymorphic point kept for compatibility. Shapes store Coord2D instead.
+ */
 class Point2D {
 private:
   double x;
@@ -42,17 +244,28 @@ public:
    * @param py Y coordinate value
    */
   Point2D(double px, double py) : x(px), y(py) {}
+  /**
+   * @brief Construct 2D point from coordinates
+   * @param c 2D coordinates
+   */
+  Point2D(const Coord2D & c) : x(c.getX()), y(c.getY()) {}
 
   /** @brief Retrieves point's X coordinate value */
   virtual double getX() { return x; }
   /** @brief Retrieves point's Y coordinate value */
   virtual double getY() { return y; }
+  /** @brief Retrieves point's coordinates as value */
+  Coord2D getCoord(void) const { return Coord2D(x, y); }
 
   /** @brief Destructor. Does nothing */
   virtual ~Point2D() {}
 };
 
-/** @brief Three dimensional space point */
+/**
+ * @brief Three dimensional space point
+ *
+ * Polymorphic point kept for compatibility. Shapes store Coord3D instead.
+ */
 class Point3D: public Point2D {
 private:
   double z;
@@ -65,9 +278,19 @@ public:
    * @param pz Z coordinate value
    */
   Point3D(double px, double py, double pz) : Point2D(px, py), z(pz) {}
+  /**
+   * @brief Construct 3D point from coordinates
+   * @param c 3D coordinates
+   */
+  Point3D(const Coord3D & c) : Point2D(c.getX(), c.getY()), z(c.getZ()) {}
 
   /** @brief Retrieves point's Z coordinate value */
   double getZ() { return z; }
+  /** @brief Retrieves point's coordinates as value */
+  Coord3D getCoord3D(void) const {
+    Coord2D xy = getCoord();
+    return Coord3D(xy.getX(), xy.getY(), z);
+  }
 };
 
 /** @brief Generic shape */
@@ -84,33 +307,54 @@ public:
 /** @brief Generic two dimensional shape */
 class Shape2D: public Shape {
 private:
-  Point2D ref_point;
+  Coord2D ref_point;
 
 public:
   /**
    * @brief Construct 2D shape from 2D reference point
    * @param p 2D point
    */
-  explicit Shape2D(Point2D * p) : ref_point(*p) {}
+  explicit Shape2D(Point2D * p) : ref_point(p->getCoord()) {}
+  /**
+   * @brief Construct 2D shape from 2D coordinates
+   * @param c 2D coordinates
+   */
+  explicit Shape2D(const Coord2D & c) : ref_point(c) {}
   /**
    * @brief Construct 2D shape from coordinates
    * @param px X coordinate value
    * @param py Y coordinate value
    */
   Shape2D(double px, double py) : ref_point(px, py) {}
+
+  /** @brief Retrieves shape's reference point */
+  const Coord2D & getRefPoint(void) const { return ref_point; }
+
+  /** @brief Prototype for calculation of shape's axis-aligned bounding box */
+  virtual BoundingBox2D boundingBox(void) = 0;
+  /** @brief Prototype for calculation of shape's bounding circle */
+  virtual BoundingCircle boundingCircle(void) = 0;
 };
 
 /** @brief Generic three dimensional shape */
 class Shape3D: public Shape {
 private:
-  Point3D ref_point;
+  Coord3D ref_point;
 
 public:
   /**
    * @brief Construct 3D shape from 3D point
    * @param p 3D point
    */
-  explicit Shape3D(Point3D * p) : ref_point(* p) {}
+  explicit Shape3D(Point3D * p) : ref_point(p->getCoord3D()) {}
+  /**
+   * @brief Construct 3D shape from 3D coordinates
+   * @param c 3D coordinates
+   */
+  explicit Shape3D(const Coord3D & c) : ref_point(c) {}
+
+  /** @brief Retrieves shape's reference point */
+  const Coord3D & getRefPoint(void) const { return ref_point; }
 
   /**
    * @brief Shape's perimeter
@@ -124,10 +368,14 @@ public:
    * @brief Prototype for calculation of shape's volume
    */
   virtual double volume(void) = 0;
+  /** @brief Prototype for calculation of shape's axis-aligned bounding box */
+  virtual BoundingBox3D boundingBox(void) = 0;
+  /** @brief Prototype for calculation of shape's bounding sphere */
+  virtual BoundingSphere boundingSphere(void) = 0;
 };
 
 /** @brief Circle shape */
-class Circle: public Shape2D {
+class Circle final: public Shape2D {
 private:
   double radius;
 
@@ -138,6 +386,12 @@ public:
    * @param r Radius
    */
   Circle(Point2D * p, double r) : Shape2D(p), radius(r) {}
+  /**
+   * @brief Construct circle shape from 2D coordinates and radius
+   * @param c 2D coordinates
+   * @param r Radius
+   */
+  Circle(const Coord2D & c, double r) : Shape2D(c), radius(r) {}
   /**
    * @brief Construct circle from coordinates and radius
    * @param px X coordinate value
@@ -158,7 +412,7 @@ public:
    * The area enclosed by a circle of radius <em>r</em> is \f$πr^2\f$
    * @return Circle's area
    */
-  double area(void) { return M_PI * radius * radius; }
+  double area(void) { return Formula::circleArea(radius); }
   /**
    * @brief Calculates circle's perimeter
    *
@@ -166,11 +420,27 @@ public:
    * It's calculated as \f$2πr\f$
    * @return Circle's perimeter
    */
-  double perimeter(void) { return 2 * M_PI * radius; }
+  double perimeter(void) { return Formula::circlePerimeter(radius); }
+  /**
+   * @brief Calculates circle's bounding box
+   *
+   * The reference point is circle's center.
+   * @return Square with side \f$2r\f$ around the center
+   */
+  BoundingBox2D boundingBox(void) {
+    const Coord2D & c = getRefPoint();
+    return BoundingBox2D { Coord2D(c.getX() - radius, c.getY() - radius),
+                           Coord2D(c.getX() + radius, c.getY() + radius) };
+  }
+  /**
+   * @brief Calculates circle's bounding circle
+   * @return The circle itself
+   */
+  BoundingCircle boundingCircle(void) { return BoundingCircle { getRefPoint(), radius }; }
 };
 
 /** @brief Rectangle shape */
-class Rectangle: public Shape2D {
+class Rectangle final: public Shape2D {
 private:
   double width;
   double height;
@@ -182,6 +452,13 @@ public:
    * @param h Height
    */
   Rectangle(Point2D * p, double w, double h) : Shape2D(p), width(w), height(h) {}
+  /**
+   * @brief Construct rectangle shape from 2D coordinates, width and height
+   * @param c 2D coordinates
+   * @param w Width
+   * @param h Height
+   */
+  Rectangle(const Coord2D & c, double w, double h) : Shape2D(c), width(w), height(h) {}
   /**
    * @brief Construct rectangle from coordinates, width and height
    * @param px X coordinate value
@@ -208,16 +485,35 @@ public:
    * Rectangle's area is calculate by multiplying width by height.
    * @return Rectangle's area
    */
-  double area(void) { return width * height; }
+  double area(void) { return Formula::rectangleArea(width, height); }
   /**
    * @brief Calculates rectangle's perimeter
    * @return Rectangle's perimeter
    */
-  double perimeter(void) { return 2 * width + 2 * height; }
+  double perimeter(void) { return Formula::rectanglePerimeter(width, height); }
+  /**
+   * @brief Calculates rectangle's bounding box
+   *
+   * The reference point is rectangle's corner with minimal coordinates.
+   * @return The rectangle itself
+   */
+  BoundingBox2D boundingBox(void) {
+    const Coord2D & c = getRefPoint();
+    return BoundingBox2D { c, Coord2D(c.getX() + width, c.getY() + height) };
+  }
+  /**
+   * @brief Calculates rectangle's bounding circle
+   * @return Circumscribed circle with center in the middle of the rectangle
+   */
+  BoundingCircle boundingCircle(void) {
+    const Coord2D & c = getRefPoint();
+    return BoundingCircle { Coord2D(c.getX() + width / 2, c.getY() + height / 2),
+                            Formula::rectangleCircumradius(width, height) };
+  }
 };
 
 /** @brief Square shape */
-class Square: public Shape2D {
+class Square final: public Shape2D {
 private:
   double side;
 
@@ -228,6 +524,12 @@ public:
    * @param s Side value
    */
   Square(Point2D * p, double s) : Shape2D(p), side(s) {}
+  /**
+   * @brief Constructs square shape from 2D coordinates and side
+   * @param c 2D coordinates
+   * @param s Side value
+   */
+  Square(const Coord2D & c, double s) : Shape2D(c), side(s) {}
   /**
    * @brief Constructs square shape from coordinates and side
    * @param x X coordinate value
@@ -246,16 +548,35 @@ public:
    * @brief Calculates square's area
    * @return Square's area
    */
-  double area(void) { return side * side; }
+  double area(void) { return Formula::squareArea(side); }
   /**
    * @brief Calculates square's perimeter
    * @return Square's perimeter
    */
-  double perimeter(void) { return side * 4; }
+  double perimeter(void) { return Formula::squarePerimeter(side); }
+  /**
+   * @brief Calculates square's bounding box
+   *
+   * The reference point is square's corner with minimal coordinates.
+   * @return The square itself
+   */
+  BoundingBox2D boundingBox(void) {
+    const Coord2D & c = getRefPoint();
+    return BoundingBox2D { c, Coord2D(c.getX() + side, c.getY() + side) };
+  }
+  /**
+   * @brief Calculates square's bounding circle
+   * @return Circumscribed circle with center in the middle of the square
+   */
+  BoundingCircle boundingCircle(void) {
+    const Coord2D & c = getRefPoint();
+    return BoundingCircle { Coord2D(c.getX() + side / 2, c.getY() + side / 2),
+                            Formula::squareCircumradius(side) };
+  }
 };
 
 /** @brief Sphere object */
-class Sphere: public Shape3D {
+class Sphere final: public Shape3D {
 private:
   Circle cr;
 public:
@@ -265,6 +586,12 @@ public:
    * @param r Radius
    */
   Sphere(Point3D * cntr, double r) : Shape3D(cntr), cr(cntr->getX(), cntr->getY(), r) {}
+  /**
+   * @brief Constructs sphere shape from 3D coordinates and radius for circle
+   * @param cntr Sphere's central point
+   * @param r Radius
+   */
+  Sphere(const Coord3D & cntr, double r) : Shape3D(cntr), cr(cntr.getXY(), r) {}
 
   /**
    * @brief Retrieves sphere's radius
@@ -278,7 +605,7 @@ public:
    * Sphere's surface area is calculated by the formula \f$4πr^2\f$
    * @return Sphere's area
    */
-  double area(void) { return 4 * M_PI * cr.getRadius() * cr.getRadius(); }
+  double area(void) { return Formula::sphereArea(cr.getRadius()); }
   /**
    * @brief Calculates sphere's perimeter
    *
@@ -292,7 +619,22 @@ public:
    * Sphere's enclosed volume is calculated by the formula \f$\frac{4}{3}πr^3\f$
    * @return Sphere's volume
    */
-  double volume(void) { return 4.0/3.0 * M_PI * cr.getRadius() * cr.getRadius() * cr.getRadius(); }
+  double volume(void) { return Formula::sphereVolume(cr.getRadius()); }
+  /**
+   * @brief Calculates sphere's bounding box
+   * @return Cube with edge \f$2r\f$ around the center
+   */
+  BoundingBox3D boundingBox(void) {
+    const Coord3D & c = getRefPoint();
+    const double r = cr.getRadius();
+    return BoundingBox3D { Coord3D(c.getX() - r, c.getY() - r, c.getZ() - r),
+                           Coord3D(c.getX() + r, c.getY() + r, c.getZ() + r) };
+  }
+  /**
+   * @brief Calculates sphere's bounding sphere
+   * @return The sphere itself
+   */
+  BoundingSphere boundingSphere(void) { return BoundingSphere { getRefPoint(), cr.getRadius() }; }
 };
 
 /** @brief Cube shape
@@ -301,7 +643,7 @@ public:
  * such an operation is ambiguous. Perimeter by sides or by sides and shape
  * diagonals?
  */
-class Cube: public Shape3D {
+class Cube final: public Shape3D {
 private:
   Square sq;
 public:
@@ -311,6 +653,12 @@ public:
    * @param s Side value
    */
   Cube(Point3D * p, double s) : Shape3D(p), sq(p->getX(), p->getY(), s) {}
+  /**
+   * @brief Constructs cube shape from 3D coordinates and side for square
+   * @param c 3D coordinates
+   * @param s Side value
+   */
+  Cube(const Coord3D & c, double s) : Shape3D(c), sq(c.getXY(), s) {}
 
   /**
    * @brief Retrieves cube's edge value from the side of the aggregated square
@@ -325,7 +673,7 @@ public:
    * so it's calculated by the formula \f$6a^2\f$
    * @return Cube's area
    */
-  double area(void) { return sq.area() * 6; }
+  double area(void) { return Formula::cubeArea(sq.getSide()); }
 
   /**
    * @brief Calculates cube's volume
@@ -334,8 +682,30 @@ public:
    * by the formula \f$a^3\f$
    * @return Cube's volume
    */
-  double volume(void) { return sq.getSide() * sq.getSide() * sq.getSide(); }
+  double volume(void) { return Formula::cubeVolume(sq.getSide()); }
+  /**
+   * @brief Calculates cube's bounding box
+   *
+   * The reference point is cube's corner with minimal coordinates.
+   * @return The cube itself
+   */
+  BoundingBox3D boundingBox(void) {
+    const Coord3D & c = getRefPoint();
+    const double a = sq.getSide();
+    return BoundingBox3D { c, Coord3D(c.getX() + a, c.getY() + a, c.getZ() + a) };
+  }
+  /**
+   * @brief Calculates cube's bounding sphere
+   * @return Circumscribed sphere with center in the middle of the cube
+   */
+  BoundingSphere boundingSphere(void) {
+    const Coord3D & c = getRefPoint();
+    const double a = sq.getSide();
+    return BoundingSphere { Coord3D(c.getX() + a / 2, c.getY() + a / 2, c.getZ() + a / 2),
+                            Formula::cubeCircumradius(a) };
+  }
 };
 
 }
 
+#endif
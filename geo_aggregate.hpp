@@ -0,0 +1,366 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_aggregate.hpp
+ * Mergeable aggregates over shape stores: counts, sums and ranges of the
+ * measures, top-K shapes by a measure and quantile sketch of a measure.
+ * Aggregates of parts of a dataset (shards, chunks) merge into the
+ * aggregate of the whole dataset and could be serialized for exchange
+ * between processes.
+ */
+
+#ifndef GEO_AGGREGATE_HPP
+#define GEO_AGGREGATE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "geo_store.hpp"
+
+namespace Geo {
+
+/** @brief Writer of binary messages (native byte order) */
+class MessageWriter {
+private:
+  std::string buf;
+
+public:
+  /** @brief Appends plain value */
+  template <class T>
+  MessageWriter & put(const T & v) {
+    static_assert(std::is_trivially_copyable<T>::value, "Only plain values could be written");
+    buf.append(reinterpret_cast<const char *>(&v), sizeof(v));
+    return *this;
+  }
+  /** @brief Appends string */
+  MessageWriter & put(const std::string & s) {
+    put(std::uint64_t(s.size()));
+    buf += s;
+    return *this;
+  }
+  /** @brief Retrieves message */
+  const std::string & str(void) const { return buf; }
+};
+
+/** @brief Reader of binary messages written by MessageWriter */
+class MessageReader {
+private:
+  const std::string & buf;
+  std::size_t pos;
+
+  void need(std::size_t n) const {
+    if (buf.size() - pos < n)
+      throw std::runtime_error("Geo::MessageReader: truncated message");
+  }
+
+public:
+  /** @brief Construct reader of message */
+  explicit MessageReader(const std::string & m) : buf(m), pos(0) {}
+
+  /** @brief Reads plain value */
+  template <class T>
+  T get(void) {
+    static_assert(std::is_trivially_copyable<T>::value, "Only plain values could be read");
+    need(sizeof(T));
+    T v;
+    std::memcpy(&v, buf.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return v;
+  }
+  /** @brief Reads string */
+  std::string getString(void) {
+    const std::uint64_t n = get<std::uint64_t>();
+    need(n);
+    std::string s = buf.substr(pos, n);
+    pos += n;
+    return s;
+  }
+};
+
+/**
+ * @brief Quantile sketch with relative accuracy
+ *
+ * Positive values are counted in logarithmic buckets, so any quantile is
+ * estimated within the given relative error, and sketches merge exactly by
+ * adding bucket counts.
+ */
+class QuantileSketch {
+private:
+  double accuracy;
+  double log_gamma;
+  std::uint64_t zero_count;
+  std::uint64_t total;
+  std::map<int, std::uint64_t> buckets;
+
+public:
+  /**
+   * @brief Construct empty sketch
+   * @param relative_accuracy Relative error of quantiles (e.g. 0.01 for 1%)
+   */
+  explicit QuantileSketch(double relative_accuracy = 0.01)
+    : accuracy(relative_accuracy), log_gamma(std::log((1 + relative_accuracy) / (1 - relative_accuracy))),
+      zero_count(0), total(0) {}
+
+  /** @brief Adds value (values not greater than zero are counted as zero) */
+  void add(double v) {
+    ++total;
+    if (!(v > 0))
+      ++zero_count;
+    else
+      ++buckets[int(std::ceil(std::log(v) / log_gamma))];
+  }
+
+  /** @brief Adds values of another sketch with the same accuracy */
+  void merge(const QuantileSketch & o) {
+    total += o.total;
+    zero_count += o.zero_count;
+    for (const auto & b : o.buckets)
+      buckets[b.first] += b.second;
+  }
+
+  /** @brief Retrieves number of values */
+  std::uint64_t count(void) const { return total; }
+
+  /**
+   * @brief Estimates quantile
+   * @param q Quantile in [0, 1]
+   * @return Estimated value (NaN for empty sketch)
+   */
+  double quantile(double q) const {
+    if (total == 0)
+      return std::numeric_limits<double>::quiet_NaN();
+    const std::uint64_t rank = std::uint64_t(std::max(0.0, std::min(1.0, q)) * double(total - 1));
+    if (rank < zero_count)
+      return 0;
+    std::uint64_t seen = zero_count;
+    for (const auto & b : buckets) {
+      seen += b.second;
+      if (rank < seen)
+        return 2 * std::exp(log_gamma * b.first) / (std::exp(log_gamma) + 1);
+    }
+    return 2 * std::exp(log_gamma * buckets.rbegin()->first) / (std::exp(log_gamma) + 1);
+  }
+
+  /** @brief Serializes sketch */
+  void write(MessageWriter & w) const {
+    w.put(accuracy).put(zero_count).put(total).put(std::uint64_t(buckets.size()));
+    for (const auto & b : buckets)
+      w.put(std::int32_t(b.first)).put(b.second);
+  }
+  /** @brief Deserializes sketch */
+  static QuantileSketch read(MessageReader & r) {
+    QuantileSketch s(r.get<double>());
+    s.zero_count = r.get<std::uint64_t>();
+    s.total = r.get<std::uint64_t>();
+    for (std::uint64_t n = r.get<std::uint64_t>(); n > 0; --n) {
+      const int k = r.get<std::int32_t>();
+      s.buckets[k] = r.get<std::uint64_t>();
+    }
+    return s;
+  }
+};
+
+/** @brief Shape with its value of a measure (entry of top-K) */
+struct RankedShape {
+  /** @brief Value of the ranking measure */
+  double value;
+  /** @brief Shape type */
+  ShapeType type;
+  /** @brief Values of the columns X, Y, Z, A and B */
+  double v[ShapeStore::column_count];
+
+  /** @brief Orders by value, then by attributes, so ranking is deterministic */
+  bool operator>(const RankedShape & o) const {
+    if (value != o.value)
+      return value > o.value;
+    if (type != o.type)
+      return type > o.type;
+    return std::lexicographical_compare(o.v, o.v + ShapeStore::column_count, v, v + ShapeStore::column_count);
+  }
+};
+
+/**
+ * @brief Mergeable aggregate of shapes
+ *
+ * Counts shapes by type, sums and ranges each measure, keeps K shapes with
+ * the largest value of a ranking measure and sketches its distribution.
+ */
+class Aggregate {
+private:
+  Measure rank_measure;
+  std::size_t k;
+  std::uint64_t counts[shape_type_count];
+  double sums[measure_count];
+  double mins[measure_count];
+  double maxs[measure_count];
+  /* Min-heap, so the smallest of the top K is replaced */
+  std::vector<RankedShape> heap;
+  QuantileSketch sketch;
+
+  void offer(const RankedShape & s) {
+    if (k == 0)
+      return;
+    if (heap.size() < k) {
+      heap.push_back(s);
+      std::push_heap(heap.begin(), heap.end(), std::greater<RankedShape>());
+    } else if (s > heap.front()) {
+      std::pop_heap(heap.begin(), heap.end(), std::greater<RankedShape>());
+      heap.back() = s;
+      std::push_heap(heap.begin(), heap.end(), std::greater<RankedShape>());
+    }
+  }
+
+public:
+  /**
+   * @brief Construct empty aggregate
+   * @param m Measure for ranking and quantiles
+   * @param top Number of largest shapes to keep
+   * @param accuracy Relative accuracy of quantiles
+   */
+  explicit Aggregate(Measure m = Measure::Area, std::size_t top = 10, double accuracy = 0.01)
+    : rank_measure(m), k(top), sketch(accuracy) {
+    std::fill(counts, counts + shape_type_count, 0);
+    std::fill(sums, sums + measure_count, 0.0);
+    std::fill(mins, mins + measure_count, std::numeric_limits<double>::infinity());
+    std::fill(maxs, maxs + measure_count, -std::numeric_limits<double>::infinity());
+  }
+
+  /**
+   * @brief Adds shape
+   * @param t Shape type
+   * @param v Values of the columns X, Y, Z, A and B
+   */
+  void add(ShapeType t, const double * v) {
+    ++counts[unsigned(t)];
+    RankedShape r = RankedShape();
+    for (unsigned m = 0; m < measure_count; ++m) {
+      const double mv = Geo::measure(Measure(m), t, v[unsigned(ShapeStore::Column::A)],
+                                     v[unsigned(ShapeStore::Column::B)]);
+      sums[m] += mv;
+      mins[m] = std::min(mins[m], mv);
+      maxs[m] = std::max(maxs[m], mv);
+      if (Measure(m) == rank_measure)
+        r.value = mv;
+    }
+    sketch.add(r.value);
+    if (k > 0 && (heap.size() < k || r.value >= heap.front().value)) {
+      r.type = t;
+      std::copy(v, v + ShapeStore::column_count, r.v);
+      offer(r);
+    }
+  }
+
+  /** @brief Adds all shapes of a store */
+  void add(const ShapeStore & store) {
+    const double * cols[ShapeStore::column_count];
+    for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+      cols[c] = store.column(ShapeStore::Column(c));
+    for (std::size_t i = 0; i < store.size(); ++i) {
+      double v[ShapeStore::column_count];
+      for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+        v[c] = cols[c][i];
+      add(store.type(i), v);
+    }
+  }
+
+  /** @brief Adds aggregate of other shapes with the same parameters */
+  void merge(const Aggregate & o) {
+    for (unsigned t = 0; t < shape_type_count; ++t)
+      counts[t] += o.counts[t];
+    for (unsigned m = 0; m < measure_count; ++m) {
+      sums[m] += o.sums[m];
+      mins[m] = std::min(mins[m], o.mins[m]);
+      maxs[m] = std::max(maxs[m], o.maxs[m]);
+    }
+    for (const RankedShape & r : o.heap)
+      offer(r);
+    sketch.merge(o.sketch);
+  }
+
+  /** @brief Retrieves number of shapes */
+  std::uint64_t count(void) const {
+    std::uint64_t n = 0;
+    for (std::uint64_t c : counts)
+      n += c;
+    return n;
+  }
+  /** @brief Retrieves number of shapes of a type */
+  std::uint64_t count(ShapeType t) const { return counts[unsigned(t)]; }
+  /** @brief Retrieves sum of a measure */
+  double sum(Measure m) const { return sums[unsigned(m)]; }
+  /** @brief Retrieves minimum of a measure */
+  double min(Measure m) const { return mins[unsigned(m)]; }
+  /** @brief Retrieves maximum of a measure */
+  double max(Measure m) const { return maxs[unsigned(m)]; }
+  /** @brief Retrieves measure for ranking and quantiles */
+  Measure rankMeasure(void) const { return rank_measure; }
+  /** @brief Estimates quantile of the ranking measure */
+  double quantile(double q) const { return sketch.quantile(q); }
+
+  /** @brief Retrieves shapes with the largest ranking measure in descending order */
+  std::vector<RankedShape> top(void) const {
+    std::vector<RankedShape> r(heap);
+    std::sort(r.begin(), r.end(), std::greater<RankedShape>());
+    return r;
+  }
+
+  /** @brief Serializes aggregate */
+  void write(MessageWriter & w) const {
+    w.put(std::uint8_t(rank_measure)).put(std::uint64_t(k));
+    for (std::uint64_t c : counts)
+      w.put(c);
+    for (unsigned m = 0; m < measure_count; ++m)
+      w.put(sums[m]).put(mins[m]).put(maxs[m]);
+    w.put(std::uint64_t(heap.size()));
+    for (const RankedShape & r : heap)
+      w.put(r);
+    sketch.write(w);
+  }
+  /** @brief Deserializes aggregate */
+  static Aggregate read(MessageReader & r) {
+    const Measure m = Measure(r.get<std::uint8_t>());
+    Aggregate a(m, std::size_t(r.get<std::uint64_t>()));
+    for (std::uint64_t & c : a.counts)
+      c = r.get<std::uint64_t>();
+    for (unsigned i = 0; i < measure_count; ++i) {
+      a.sums[i] = r.get<double>();
+      a.mins[i] = r.get<double>();
+      a.maxs[i] = r.get<double>();
+    }
+    for (std::uint64_t n = r.get<std::uint64_t>(); n > 0; --n)
+      a.heap.push_back(r.get<RankedShape>());
+    std::make_heap(a.heap.begin(), a.heap.end(), std::greater<RankedShape>());
+    a.sketch = QuantileSketch::read(r);
+    return a;
+  }
+};
+
+}
+
+#endif
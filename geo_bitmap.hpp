@@ -0,0 +1,459 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_bitmap.hpp
+ * Compressed bitmaps and bitmap indexes over the columnar store from
+ * geo_store.hpp. Bitmaps follow the Roaring design: 32-bit row numbers are
+ * split by their high 16 bits in containers, which keep the low 16 bits
+ * either as sorted array (when sparse) or as 65536-bit set (when dense).
+ */
+
+#ifndef GEO_BITMAP_HPP
+#define GEO_BITMAP_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "geo_store.hpp"
+
+namespace Geo {
+
+/** @brief Compressed bitmap of 32-bit values (Roaring-style) */
+class Bitmap {
+private:
+  /* Arrays with more values are converted to bitsets */
+  static constexpr std::uint32_t array_max = 4096;
+  static constexpr std::size_t words = 65536 / 64;
+
+  struct Container {
+    std::uint16_t key;
+    std::uint32_t card;
+    std::vector<std::uint16_t> array;
+    std::vector<std::uint64_t> bits;
+
+    explicit Container(std::uint16_t k = 0) : key(k), card(0) {}
+
+    bool isBitset(void) const { return !bits.empty(); }
+
+    bool contains(std::uint16_t v) const {
+      if (isBitset())
+        return (bits[v >> 6] >> (v & 63)) & 1u;
+      return std::binary_search(array.begin(), array.end(), v);
+    }
+
+    void toBitset(void) {
+      bits.assign(words, 0);
+      for (std::uint16_t v : array)
+        bits[v >> 6] |= std::uint64_t(1) << (v & 63);
+      array.clear();
+      array.shrink_to_fit();
+    }
+
+    void add(std::uint16_t v) {
+      if (isBitset()) {
+        std::uint64_t & w = bits[v >> 6];
+        const std::uint64_t b = std::uint64_t(1) << (v & 63);
+        card += (w & b) == 0;
+        w |= b;
+        return;
+      }
+      if (array.empty() || array.back() < v) {
+        array.push_back(v);
+      } else {
+        auto it = std::lower_bound(array.begin(), array.end(), v);
+        if (*it == v)
+          return;
+        array.insert(it, v);
+      }
+      if (++card > array_max)
+        toBitset();
+    }
+
+    /* Converts sparse bitset to array after operations */
+    void normalize(void) {
+      if (!isBitset() || card > array_max)
+        return;
+      array.clear();
+      array.reserve(card);
+      forEach([this](std::uint16_t v) { array.push_back(v); });
+      bits.clear();
+      bits.shrink_to_fit();
+    }
+
+    template <class F>
+    void forEach(F f) const {
+      if (!isBitset()) {
+        for (std::uint16_t v : array)
+          f(v);
+        return;
+      }
+      for (std::size_t w = 0; w < words; ++w) {
+        std::uint64_t b = bits[w];
+        while (b) {
+          f(std::uint16_t(w * 64 + unsigned(__builtin_ctzll(b))));
+          b &= b - 1;
+        }
+      }
+    }
+  };
+
+  std::vector<Container> conts;
+
+  enum class Op { And, Or, AndNot };
+
+  /* Combines two containers with equal keys */
+  static Container combine(const Container & a, const Container & b, Op op) {
+    Container r(a.key);
+    if (a.isBitset() && b.isBitset()) {
+      r.bits.resize(words);
+      std::uint32_t card = 0;
+      for (std::size_t w = 0; w < words; ++w) {
+        const std::uint64_t v = op == Op::And ? a.bits[w] & b.bits[w] :
+                                op == Op::Or  ? a.bits[w] | b.bits[w] :
+                                                a.bits[w] & ~b.bits[w];
+        r.bits[w] = v;
+        card += unsigned(__builtin_popcountll(v));
+      }
+      r.card = card;
+      r.normalize();
+      return r;
+    }
+    if (op == Op::And) {
+      if (a.isBitset() || b.isBitset()) {
+        const Container & arr = a.isBitset() ? b : a;
+        const Container & bs = a.isBitset() ? a : b;
+        for (std::uint16_t v : arr.array)
+          if (bs.contains(v))
+            r.array.push_back(v);
+      } else {
+        std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                              std::back_inserter(r.array));
+      }
+      r.card = std::uint32_t(r.array.size());
+      return r;
+    }
+    if (op == Op::AndNot && !a.isBitset()) {
+      for (std::uint16_t v : a.array)
+        if (!b.contains(v))
+          r.array.push_back(v);
+      r.card = std::uint32_t(r.array.size());
+      return r;
+    }
+    /* Union of arrays is merged and converted, when it's too large */
+    if (op == Op::Or && !a.isBitset() && !b.isBitset()) {
+      r.array.reserve(a.array.size() + b.array.size());
+      std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                     std::back_inserter(r.array));
+      r.card = std::uint32_t(r.array.size());
+      if (r.card > array_max)
+        r.toBitset();
+      return r;
+    }
+    /* Union or difference with at least one bitset operand */
+    if (a.isBitset()) {
+      r = a;
+    } else {
+      r.bits.assign(words, 0);
+      r.card = 0;
+      a.forEach([&r](std::uint16_t v) { r.add(v); });
+    }
+    b.forEach([&r, op](std::uint16_t v) {
+      std::uint64_t & w = r.bits[v >> 6];
+      const std::uint64_t bit = std::uint64_t(1) << (v & 63);
+      if (op == Op::Or) {
+        r.card += (w & bit) == 0;
+        w |= bit;
+      } else {
+        r.card -= (w & bit) != 0;
+        w &= ~bit;
+      }
+    });
+    r.normalize();
+    return r;
+  }
+
+  static Bitmap apply(const Bitmap & a, const Bitmap & b, Op op) {
+    Bitmap r;
+    std::size_t i = 0, j = 0;
+    while (i < a.conts.size() || j < b.conts.size()) {
+      if (j >= b.conts.size() || (i < a.conts.size() && a.conts[i].key < b.conts[j].key)) {
+        if (op != Op::And)
+          r.conts.push_back(a.conts[i]);
+        ++i;
+      } else if (i >= a.conts.size() || b.conts[j].key < a.conts[i].key) {
+        if (op == Op::Or)
+          r.conts.push_back(b.conts[j]);
+        ++j;
+      } else {
+        Container c = combine(a.conts[i], b.conts[j], op);
+        if (c.card)
+          r.conts.push_back(std::move(c));
+        ++i;
+        ++j;
+      }
+    }
+    return r;
+  }
+
+  const Container * find(std::uint16_t key) const {
+    auto it = std::lower_bound(conts.begin(), conts.end(), key,
+                               [](const Container & c, std::uint16_t k) { return c.key < k; });
+    return it != conts.end() && it->key == key ? &*it : nullptr;
+  }
+
+public:
+  /**
+   * @brief Adds value to the bitmap
+   *
+   * Adding values in increasing order (e.g. row numbers while scanning a
+   * store) appends to the last container without searching.
+   * @param v Value
+   */
+  void add(std::uint32_t v) {
+    const std::uint16_t key = std::uint16_t(v >> 16);
+    if (conts.empty() || conts.back().key < key) {
+      conts.push_back(Container(key));
+      conts.back().add(std::uint16_t(v));
+      return;
+    }
+    auto it = std::lower_bound(conts.begin(), conts.end(), key,
+                               [](const Container & c, std::uint16_t k) { return c.key < k; });
+    if (it == conts.end() || it->key != key)
+      it = conts.insert(it, Container(key));
+    it->add(std::uint16_t(v));
+  }
+
+  /** @brief Checks whether the bitmap contains a value */
+  bool contains(std::uint32_t v) const {
+    const Container * c = find(std::uint16_t(v >> 16));
+    return c && c->contains(std::uint16_t(v));
+  }
+
+  /** @brief Retrieves number of values in the bitmap */
+  std::uint64_t cardinality(void) const {
+    std::uint64_t n = 0;
+    for (const Container & c : conts)
+      n += c.card;
+    return n;
+  }
+
+  /** @brief Checks whether the bitmap is empty */
+  bool empty(void) const { return conts.empty(); }
+
+  /** @brief Retrieves approximate memory used by the bitmap in bytes */
+  std::size_t bytes(void) const {
+    std::size_t n = sizeof(*this);
+    for (const Container & c : conts)
+      n += sizeof(c) + c.array.capacity() * sizeof(std::uint16_t) + c.bits.capacity() * sizeof(std::uint64_t);
+    return n;
+  }
+
+  /**
+   * @brief Counts values present in both bitmaps without building result
+   * @param o Other bitmap
+   * @return Cardinality of the intersection
+   */
+  std::uint64_t andCardinality(const Bitmap & o) const {
+    std::uint64_t n = 0;
+    std::size_t i = 0, j = 0;
+    while (i < conts.size() && j < o.conts.size()) {
+      const Container & a = conts[i];
+      const Container & b = o.conts[j];
+      if (a.key < b.key) {
+        ++i;
+      } else if (b.key < a.key) {
+        ++j;
+      } else {
+        if (a.isBitset() && b.isBitset()) {
+          for (std::size_t w = 0; w < words; ++w)
+            n += unsigned(__builtin_popcountll(a.bits[w] & b.bits[w]));
+        } else if (a.isBitset() || b.isBitset()) {
+          const Container & arr = a.isBitset() ? b : a;
+          const Container & bs = a.isBitset() ? a : b;
+          for (std::uint16_t v : arr.array)
+            n += bs.contains(v);
+        } else {
+          std::size_t p = 0, q = 0;
+          while (p < a.array.size() && q < b.array.size()) {
+            const std::uint16_t x = a.array[p], y = b.array[q];
+            n += x == y;
+            p += x <= y;
+            q += y <= x;
+          }
+        }
+        ++i;
+        ++j;
+      }
+    }
+    return n;
+  }
+
+  /** @brief Intersection of bitmaps */
+  friend Bitmap operator&(const Bitmap & a, const Bitmap & b) { return apply(a, b, Op::And); }
+  /** @brief Union of bitmaps */
+  friend Bitmap operator|(const Bitmap & a, const Bitmap & b) { return apply(a, b, Op::Or); }
+  /** @brief Difference of bitmaps */
+  friend Bitmap operator-(const Bitmap & a, const Bitmap & b) { return apply(a, b, Op::AndNot); }
+
+  /**
+   * @brief Visits values in increasing order
+   * @param f Function called with each value
+   */
+  template <class F>
+  void forEach(F f) const {
+    for (const Container & c : conts) {
+      const std::uint32_t high = std::uint32_t(c.key) << 16;
+      c.forEach([&f, high](std::uint16_t v) { f(high | v); });
+    }
+  }
+
+  /**
+   * @brief Converts bitmap to selection vector
+   * @return Values in increasing order
+   */
+  std::vector<std::uint32_t> toSelection(void) const {
+    std::vector<std::uint32_t> sel;
+    sel.reserve(cardinality());
+    forEach([&sel](std::uint32_t v) { sel.push_back(v); });
+    return sel;
+  }
+};
+
+/**
+ * @brief Bitmap indexes over shape store
+ *
+ * Keeps one bitmap of rows per shape type and per size bucket of dimensions
+ * A (radius, width, side or edge) and B (height). Buckets are of equal width
+ * with the last one open-ended, so bucket k holds sizes in
+ * \f$[k w, (k + 1) w)\f$. Counting shapes matching a combination of
+ * predicates is done by the bitmaps without scanning the store.
+ */
+class ShapeIndex {
+private:
+  double width;
+  std::size_t nbuckets;
+  std::size_t indexed;
+  std::uint64_t changes;
+  Bitmap by_type[shape_type_count];
+  std::vector<Bitmap> by_a;
+  std::vector<Bitmap> by_b;
+
+public:
+  /**
+   * @brief Construct index over shape store
+   * @param store Shape store
+   * @param bucket_width Width of size buckets
+   * @param buckets Number of size buckets
+   */
+  ShapeIndex(const ShapeStore & store, double bucket_width, std::size_t buckets = 256)
+    : width(bucket_width > 0 ? bucket_width : 1), nbuckets(buckets ? buckets : 1), indexed(0),
+      changes(store.changeCount()), by_a(nbuckets), by_b(nbuckets)
+  {
+    update(store);
+  }
+
+  /**
+   * @brief Indexes rows appended to the store since last update
+   *
+   * When rows were changed with ShapeStore::update or the store was cleared
+   * since, the whole index is rebuilt. Until this is called, the index
+   * reflects the store as of the last call.
+   * @param store The indexed store
+   */
+  void update(const ShapeStore & store) {
+    if (store.changeCount() != changes) {
+      for (Bitmap & bm : by_type)
+        bm = Bitmap();
+      by_a.assign(nbuckets, Bitmap());
+      by_b.assign(nbuckets, Bitmap());
+      indexed = 0;
+      changes = store.changeCount();
+    }
+    const ShapeType * t = store.types();
+    const double * a = store.column(ShapeStore::Column::A);
+    const double * b = store.column(ShapeStore::Column::B);
+    for (std::size_t i = indexed; i < store.size(); ++i) {
+      const std::uint32_t r = std::uint32_t(i);
+      by_type[unsigned(t[i])].add(r);
+      by_a[bucketOf(a[i])].add(r);
+      if (t[i] == ShapeType::Rectangle)
+        by_b[bucketOf(b[i])].add(r);
+    }
+    indexed = store.size();
+  }
+
+  /** @brief Retrieves number of size buckets */
+  std::size_t bucketCount(void) const { return nbuckets; }
+
+  /** @brief Retrieves bucket of a size value */
+  std::size_t bucketOf(double v) const {
+    const double k = std::floor(v / width);
+    if (!(k > 0))
+      return 0;
+    return k >= double(nbuckets - 1) ? nbuckets - 1 : std::size_t(k);
+  }
+
+  /** @brief Retrieves rows with shapes of given type */
+  const Bitmap & type(ShapeType t) const { return by_type[unsigned(t)]; }
+
+  /**
+   * @brief Retrieves rows with dimension in size bucket
+   * @param c Column A or B (heights of rectangles only)
+   * @param k Bucket number
+   */
+  const Bitmap & bucket(ShapeStore::Column c, std::size_t k) const {
+    return c == ShapeStore::Column::B ? by_b[k] : by_a[k];
+  }
+
+  /**
+   * @brief Counts shapes of given type with dimension A in a bucket
+   *
+   * For example the number of squares with side in bucket 7.
+   */
+  std::uint64_t count(ShapeType t, std::size_t k) const {
+    return type(t).andCardinality(by_a[k]);
+  }
+};
+
+/**
+ * @brief Calculates measure of rows selected by bitmap
+ * @param store Shape store
+ * @param m Measure
+ * @param rows Bitmap of rows
+ * @param out Output vector receiving measures in increasing row order
+ * @return Sum of the measure
+ */
+inline double measure(const ShapeStore & store, Measure m, const Bitmap & rows, std::vector<double> & out) {
+  const std::vector<std::uint32_t> sel = rows.toSelection();
+  out.resize(sel.size());
+  store.measure(m, sel.data(), sel.size(), out.data());
+  double sum = 0;
+  for (double v : out)
+    sum += v;
+  return sum;
+}
+
+}
+
+#endif
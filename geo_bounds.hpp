@@ -0,0 +1,459 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_bounds.hpp
+ * Batch kernels calculating bounding boxes and bounding spheres of shapes
+ * in columnar storage. All shape types are handled by the same branchless
+ * loop, which takes per type coefficients from small tables, so batches of
+ * mixed shapes vectorize. Like the measure kernels the loops are compiled
+ * for every instruction set level. Bounds could be kept in double precision
+ * or quantized conservatively to 16 bits per coordinate.
+ */
+
+#ifndef GEO_BOUNDS_HPP
+#define GEO_BOUNDS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "geo_dispatch.hpp"
+
+namespace Geo {
+
+/**
+ * @brief Input of bounds kernels
+ *
+ * Columns are the same as of ShapeStore. 2D shapes are bounded in the plane
+ * of their Z value (zero in stores), so their boxes are flat.
+ */
+struct BoundsBatch {
+  /** @brief Shape types */
+  const ShapeType * t;
+  /** @brief Arrays with values of each column in order X, Y, Z, A and B */
+  const double * v[ShapeStore::column_count];
+  /** @brief Number of shapes */
+  std::size_t n;
+};
+
+/** @brief Output columns of bounding boxes */
+struct BoxColumns {
+  /** @brief Minimal X, Y and Z coordinates */
+  double * min[3];
+  /** @brief Maximal X, Y and Z coordinates */
+  double * max[3];
+};
+
+/** @brief Output columns of bounding spheres (circles for 2D shapes) */
+struct SphereColumns {
+  /** @brief X, Y and Z coordinates of centers */
+  double * center[3];
+  /** @brief Radii */
+  double * radius;
+};
+
+/** @brief Batch kernel calculating bounding boxes */
+typedef void (*BoxKernelFn)(const BoundsBatch & in, const BoxColumns & out);
+/** @brief Batch kernel calculating bounding spheres */
+typedef void (*SphereKernelFn)(const BoundsBatch & in, const SphereColumns & out);
+
+/** @brief Bounds kernels compiled for an instruction set level */
+struct BoundsKernels {
+  /** @brief Bounding boxes */
+  BoxKernelFn box;
+  /** @brief Bounding spheres */
+  SphereKernelFn sphere;
+};
+
+namespace detail {
+
+/*
+ * Half extents of a shape are hx = kx a, hy = kya a + kyb b and hz = kz a,
+ * its center is the reference point moved by off times the half extents
+ * (round shapes are given by center, the others by their minimal corner)
+ * and the radius is A for round shapes or the length of the half diagonal.
+ */
+struct BoundsCoeffs {
+  double kx[shape_type_count];
+  double kya[shape_type_count];
+  double kyb[shape_type_count];
+  double kz[shape_type_count];
+  double off[shape_type_count];
+  double round[shape_type_count];
+};
+
+alignas(64) constexpr BoundsCoeffs bounds_coeffs = {
+  /*         Circle Rect  Square Sphere Cube */
+  /* kx    */ { 1,  0.5,  0.5,   1,     0.5 },
+  /* kya   */ { 1,  0,    0.5,   1,     0.5 },
+  /* kyb   */ { 0,  0.5,  0,     0,     0   },
+  /* kz    */ { 0,  0,    0,     1,     0.5 },
+  /* off   */ { 0,  1,    1,     0,     1   },
+  /* round */ { 1,  0,    0,     1,     0   }
+};
+
+/* Half extents and offset of the center from the reference point */
+struct HalfExtents {
+  double h[3];
+  double off;
+};
+
+inline __attribute__((always_inline)) HalfExtents halfExtents(unsigned s, double a, double b) {
+  return HalfExtents { { coeff(bounds_coeffs.kx, s) * a,
+                         coeff(bounds_coeffs.kya, s) * a + coeff(bounds_coeffs.kyb, s) * b,
+                         coeff(bounds_coeffs.kz, s) * a },
+                       coeff(bounds_coeffs.off, s) };
+}
+
+inline __attribute__((always_inline)) double boundingRadius(unsigned s, double a, const HalfExtents & e) {
+  const double r = coeff(bounds_coeffs.round, s);
+  return r * a + (1 - r) * std::sqrt(e.h[0] * e.h[0] + e.h[1] * e.h[1] + e.h[2] * e.h[2]);
+}
+
+/* Types are widened to 32 bits in tiles, so the loops over them run on
+ * vectors of doubles and not of bytes, which would need many conversions */
+constexpr std::size_t type_tile = 256;
+
+template <bool Simd>
+inline __attribute__((always_inline)) void widenTypes(const ShapeType * __restrict t, std::size_t m,
+                                                      std::uint32_t * __restrict s) {
+#pragma omp simd if(simd: Simd)
+  for (std::size_t j = 0; j < m; ++j)
+    s[j] = std::uint32_t(t[j]);
+}
+
+/* Loops take the columns in restricted pointers, so that they could be
+ * vectorized without checks for overlaps */
+#define GEO_BOUNDS_COLUMNS \
+  const ShapeType * __restrict t = in.t; \
+  const double * __restrict x = in.v[0]; \
+  const double * __restrict y = in.v[1]; \
+  const double * __restrict z = in.v[2]; \
+  const double * __restrict a = in.v[3]; \
+  const double * __restrict b = in.v[4]; \
+  const std::size_t n = in.n;
+
+struct BoxLoop {
+  template <bool Simd>
+  static inline __attribute__((always_inline)) void run(const BoundsBatch & in, const BoxColumns & out) {
+    GEO_BOUNDS_COLUMNS
+    double * __restrict x0 = out.min[0], * __restrict y0 = out.min[1], * __restrict z0 = out.min[2];
+    double * __restrict x1 = out.max[0], * __restrict y1 = out.max[1], * __restrict z1 = out.max[2];
+    for (std::size_t i0 = 0; i0 < n; i0 += type_tile) {
+      const std::size_t m = std::min(type_tile, n - i0);
+      std::uint32_t s[type_tile];
+      widenTypes<Simd>(t + i0, m, s);
+#pragma omp simd if(simd: Simd)
+      for (std::size_t j = 0; j < m; ++j) {
+        const std::size_t i = i0 + j;
+        const HalfExtents e = halfExtents(s[j], a[i], b[i]);
+        const double cx = x[i] + e.off * e.h[0], cy = y[i] + e.off * e.h[1], cz = z[i] + e.off * e.h[2];
+        x0[i] = cx - e.h[0]; y0[i] = cy - e.h[1]; z0[i] = cz - e.h[2];
+        x1[i] = cx + e.h[0]; y1[i] = cy + e.h[1]; z1[i] = cz + e.h[2];
+      }
+    }
+  }
+};
+
+struct SphereLoop {
+  template <bool Simd>
+  static inline __attribute__((always_inline)) void run(const BoundsBatch & in, const SphereColumns & out) {
+    GEO_BOUNDS_COLUMNS
+    double * __restrict cx = out.center[0], * __restrict cy = out.center[1], * __restrict cz = out.center[2];
+    double * __restrict r = out.radius;
+    for (std::size_t i0 = 0; i0 < n; i0 += type_tile) {
+      const std::size_t m = std::min(type_tile, n - i0);
+      std::uint32_t s[type_tile];
+      widenTypes<Simd>(t + i0, m, s);
+#pragma omp simd if(simd: Simd)
+      for (std::size_t j = 0; j < m; ++j) {
+        const std::size_t i = i0 + j;
+        const HalfExtents e = halfExtents(s[j], a[i], b[i]);
+        cx[i] = x[i] + e.off * e.h[0]; cy[i] = y[i] + e.off * e.h[1]; cz[i] = z[i] + e.off * e.h[2];
+        r[i] = boundingRadius(s[j], a[i], e);
+      }
+    }
+  }
+};
+
+#undef GEO_BOUNDS_COLUMNS
+
+}
+
+/**
+ * @brief Selects bounds kernels compiled for an instruction set level
+ *
+ * The caller is responsible for the processor supporting the level.
+ * @param isa Instruction set level
+ */
+inline BoundsKernels boundsKernels(Isa isa) {
+  return BoundsKernels { detail::IsaKernel<BoxKernelFn, detail::BoxLoop>::select(isa),
+                         detail::IsaKernel<SphereKernelFn, detail::SphereLoop>::select(isa) };
+}
+
+/** @brief Selects bounds kernels for the active instruction set level */
+inline BoundsKernels dispatchBoundsKernels(void) {
+  static const BoundsKernels k = boundsKernels(activeIsa());
+  return k;
+}
+
+/**
+ * @brief Bounding boxes and spheres of all shapes in a store
+ *
+ * Bounds are kept in columns parallel to the ones of the store, so they
+ * could be scanned or indexed like the store itself.
+ */
+class ShapeBounds {
+private:
+  std::vector<double> lo[3];
+  std::vector<double> hi[3];
+  std::vector<double> ctr[3];
+  std::vector<double> rad;
+  BoundingBox3D ext;
+
+public:
+  /** @brief Construct empty bounds */
+  ShapeBounds() : ext { Coord3D(), Coord3D() } {}
+  /**
+   * @brief Construct bounds of shapes in a store
+   * @param store Shapes
+   * @param k Kernels used for calculation
+   */
+  explicit ShapeBounds(const ShapeStore & store, BoundsKernels k = dispatchBoundsKernels())
+    : ShapeBounds() {
+    compute(store, k);
+  }
+
+  /**
+   * @brief Calculates bounds of shapes in a store
+   *
+   * Replaces the previous bounds. Calculated block by block, so the columns
+   * of the store stay in cache between the two kernels.
+   * @param store Shapes
+   * @param k Kernels used for calculation
+   */
+  void compute(const ShapeStore & store, BoundsKernels k = dispatchBoundsKernels()) {
+    const std::size_t n = store.size();
+    for (unsigned d = 0; d < 3; ++d) {
+      lo[d].resize(n);
+      hi[d].resize(n);
+      ctr[d].resize(n);
+    }
+    rad.resize(n);
+    for (std::size_t first = 0; first < n; first += store.blockSize()) {
+      BoundsBatch in;
+      in.t = store.types() + first;
+      for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+        in.v[c] = store.column(ShapeStore::Column(c)) + first;
+      in.n = std::min(store.blockSize(), n - first);
+      const BoxColumns box = { { lo[0].data() + first, lo[1].data() + first, lo[2].data() + first },
+                               { hi[0].data() + first, hi[1].data() + first, hi[2].data() + first } };
+      const SphereColumns sph = { { ctr[0].data() + first, ctr[1].data() + first, ctr[2].data() + first },
+                                  rad.data() + first };
+      k.box(in, box);
+      k.sphere(in, sph);
+    }
+    double emin[3], emax[3];
+    for (unsigned d = 0; d < 3; ++d) {
+      emin[d] = n ? *std::min_element(lo[d].begin(), lo[d].end()) : 0;
+      emax[d] = n ? *std::max_element(hi[d].begin(), hi[d].end()) : 0;
+    }
+    ext = BoundingBox3D { Coord3D(emin[0], emin[1], emin[2]), Coord3D(emax[0], emax[1], emax[2]) };
+  }
+
+  /** @brief Retrieves number of shapes */
+  std::size_t size(void) const { return rad.size(); }
+  /** @brief Retrieves box enclosing all shapes */
+  const BoundingBox3D & extent(void) const { return ext; }
+
+  /**
+   * @brief Retrieves column of minimal coordinates of boxes
+   * @param c Column X, Y or Z
+   */
+  const double * min(ShapeStore::Column c) const { return lo[unsigned(c)].data(); }
+  /**
+   * @brief Retrieves column of maximal coordinates of boxes
+   * @param c Column X, Y or Z
+   */
+  const double * max(ShapeStore::Column c) const { return hi[unsigned(c)].data(); }
+  /**
+   * @brief Retrieves column of coordinates of spheres' centers
+   * @param c Column X, Y or Z
+   */
+  const double * center(ShapeStore::Column c) const { return ctr[unsigned(c)].data(); }
+  /** @brief Retrieves column of spheres' radii */
+  const double * radius(void) const { return rad.data(); }
+
+  /** @brief Retrieves bounding box of a shape */
+  BoundingBox3D box(std::size_t i) const {
+    return BoundingBox3D { Coord3D(lo[0][i], lo[1][i], lo[2][i]), Coord3D(hi[0][i], hi[1][i], hi[2][i]) };
+  }
+  /** @brief Retrieves bounding sphere of a shape */
+  BoundingSphere sphere(std::size_t i) const {
+    return BoundingSphere { Coord3D(ctr[0][i], ctr[1][i], ctr[2][i]), rad[i] };
+  }
+};
+
+/**
+ * @brief Bounds quantized to 16 bits per coordinate
+ *
+ * Coordinates are stored as steps of a grid over the extent of all shapes,
+ * so a box takes 12 bytes instead of 48 and a sphere 8 instead of 32.
+ * Quantization is conservative: minimal coordinates are rounded down,
+ * maximal ones up and radii are enlarged by the error of centers, so the
+ * quantized bounds always enclose the exact ones. They're suitable for
+ * broad-phase tests, which may report extra candidates but never miss one.
+ */
+class QuantizedBounds {
+public:
+  /** @brief Maximal quantized value */
+  static constexpr std::uint16_t steps = std::numeric_limits<std::uint16_t>::max();
+
+private:
+  double origin[3];
+  double scale[3];
+  double rscale;
+  std::vector<std::uint16_t> lo[3];
+  std::vector<std::uint16_t> hi[3];
+  std::vector<std::uint16_t> ctr[3];
+  std::vector<std::uint16_t> rad;
+
+  double dequantize(unsigned d, std::uint16_t q) const { return origin[d] + q * scale[d]; }
+
+  /* Rounds down (or up) and corrects the cases when rounding errors of the
+   * division would make the dequantized value miss the exact one */
+  std::uint16_t quantizeDown(unsigned d, double v) const {
+    double q = std::floor((v - origin[d]) / scale[d]);
+    q = std::min(std::max(q, 0.0), double(steps));
+    while (q > 0 && dequantize(d, std::uint16_t(q)) > v)
+      --q;
+    return std::uint16_t(q);
+  }
+  std::uint16_t quantizeUp(unsigned d, double v) const {
+    double q = std::ceil((v - origin[d]) / scale[d]);
+    q = std::min(std::max(q, 0.0), double(steps));
+    while (q < steps && dequantize(d, std::uint16_t(q)) < v)
+      ++q;
+    return std::uint16_t(q);
+  }
+
+public:
+  /**
+   * @brief Construct quantized copy of bounds
+   * @param b Bounds in double precision
+   */
+  explicit QuantizedBounds(const ShapeBounds & b) {
+    const std::size_t n = b.size();
+    const Coord3D & emin = b.extent().min;
+    const Coord3D & emax = b.extent().max;
+    const double ext[3] = { emax.getX() - emin.getX(), emax.getY() - emin.getY(), emax.getZ() - emin.getZ() };
+    origin[0] = emin.getX();
+    origin[1] = emin.getY();
+    origin[2] = emin.getZ();
+    /* Steps are slightly enlarged, so the last one reaches the extent
+     * despite rounding of the products */
+    const double widen = 1 + 1e-12;
+    for (unsigned d = 0; d < 3; ++d)
+      scale[d] = ext[d] > 0 ? ext[d] / steps * widen : 1;
+    /* Rounded center is up to half step off on each axis */
+    const double slack = std::sqrt(scale[0] * scale[0] + scale[1] * scale[1] + scale[2] * scale[2]) / 2;
+    double rmax = 0;
+    for (std::size_t i = 0; i < n; ++i)
+      rmax = std::max(rmax, b.radius()[i]);
+    rscale = (rmax + slack) > 0 ? (rmax + slack) / steps * widen : 1;
+
+    for (unsigned d = 0; d < 3; ++d) {
+      lo[d].resize(n);
+      hi[d].resize(n);
+      ctr[d].resize(n);
+      const double * mn = b.min(ShapeStore::Column(d));
+      const double * mx = b.max(ShapeStore::Column(d));
+      const double * c = b.center(ShapeStore::Column(d));
+      for (std::size_t i = 0; i < n; ++i) {
+        lo[d][i] = quantizeDown(d, mn[i]);
+        hi[d][i] = quantizeUp(d, mx[i]);
+        const double q = std::nearbyint((c[i] - origin[d]) / scale[d]);
+        ctr[d][i] = std::uint16_t(std::min(std::max(q, 0.0), double(steps)));
+      }
+    }
+    rad.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      double err = 0;
+      for (unsigned d = 0; d < 3; ++d) {
+        const double e = dequantize(d, ctr[d][i]) - b.center(ShapeStore::Column(d))[i];
+        err += e * e;
+      }
+      const double r = b.radius()[i] + std::sqrt(err);
+      double q = std::min(std::ceil(r / rscale), double(steps));
+      while (q < steps && q * rscale < r)
+        ++q;
+      rad[i] = std::uint16_t(q);
+    }
+  }
+
+  /** @brief Retrieves number of shapes */
+  std::size_t size(void) const { return rad.size(); }
+
+  /** @brief Retrieves bounding box of a shape (enclosing the exact one) */
+  BoundingBox3D box(std::size_t i) const {
+    return BoundingBox3D { Coord3D(dequantize(0, lo[0][i]), dequantize(1, lo[1][i]), dequantize(2, lo[2][i])),
+                           Coord3D(dequantize(0, hi[0][i]), dequantize(1, hi[1][i]), dequantize(2, hi[2][i])) };
+  }
+  /** @brief Retrieves bounding sphere of a shape (enclosing the exact one) */
+  BoundingSphere sphere(std::size_t i) const {
+    return BoundingSphere { Coord3D(dequantize(0, ctr[0][i]), dequantize(1, ctr[1][i]), dequantize(2, ctr[2][i])),
+                            rad[i] * rscale };
+  }
+
+  /**
+   * @brief Finds shapes whose boxes may overlap a box
+   *
+   * The box is quantized conservatively as well and compared with the
+   * quantized boxes in integers, so no shape overlapping it is missed.
+   * @param q Query box
+   * @return Indexes of candidate shapes in ascending order
+   */
+  std::vector<std::uint32_t> overlapping(const BoundingBox3D & q) const {
+    const double qmin[3] = { q.min.getX(), q.min.getY(), q.min.getZ() };
+    const double qmax[3] = { q.max.getX(), q.max.getY(), q.max.getZ() };
+    std::uint16_t l[3], h[3];
+    std::vector<std::uint32_t> out;
+    for (unsigned d = 0; d < 3; ++d) {
+      if (qmax[d] < origin[d] || qmin[d] > dequantize(d, steps) || qmin[d] > qmax[d])
+        return out;
+      l[d] = quantizeDown(d, qmin[d]);
+      h[d] = quantizeUp(d, qmax[d]);
+    }
+    for (std::size_t i = 0; i < size(); ++i) {
+      bool hit = true;
+      for (unsigned d = 0; d < 3; ++d)
+        hit &= lo[d][i] <= h[d] && l[d] <= hi[d][i];
+      if (hit)
+        out.push_back(std::uint32_t(i));
+    }
+    return out;
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,322 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_cache.hpp
+ * Cache of results keyed by content hash of shape batches. Batches are
+ * hashed over their columns with a fast 128-bit hash, so repeated batches
+ * find their previous results without comparing the shapes. The cache is
+ * bounded, split in shards with own locks for concurrent use and evicts
+ * entries with CLOCK (second chance) algorithm.
+ */
+
+#ifndef GEO_CACHE_HPP
+#define GEO_CACHE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "geo_store.hpp"
+
+namespace Geo {
+
+/** @brief 128-bit content hash */
+struct ContentHash {
+  std::uint64_t lo;
+  std::uint64_t hi;
+
+  bool operator==(const ContentHash & o) const { return lo == o.lo && hi == o.hi; }
+  bool operator!=(const ContentHash & o) const { return !(*this == o); }
+};
+
+namespace detail {
+
+constexpr std::uint64_t hash_p1 = 0x9e3779b185ebca87ULL;
+constexpr std::uint64_t hash_p2 = 0xc2b2ae3d27d4eb4fULL;
+
+inline std::uint64_t rotl64(std::uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline std::uint64_t load64(const unsigned char * p) {
+  std::uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline std::uint64_t avalanche(std::uint64_t h) {
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+  return h ^ (h >> 31);
+}
+
+}
+
+/**
+ * @brief Hashes bytes to 128 bits
+ *
+ * Four independent lanes consume 32 bytes per step, so the hash runs at
+ * several bytes per cycle, and both halves of the result are derived from
+ * them in a single pass. Not cryptographic.
+ * @param data Bytes
+ * @param len Number of bytes
+ * @param seed Seed (e.g. hash of preceding data)
+ */
+inline ContentHash hashBytes128(const void * data, std::size_t len, ContentHash seed = ContentHash { 0, 0 }) {
+  using namespace detail;
+  const unsigned char * p = static_cast<const unsigned char *>(data);
+  std::uint64_t acc[4] = { seed.lo + hash_p1 + hash_p2, seed.hi + hash_p2, seed.lo, seed.hi - hash_p1 };
+  std::size_t i = 0;
+  for (; i + 32 <= len; i += 32)
+    for (unsigned k = 0; k < 4; ++k)
+      acc[k] = rotl64(acc[k] + load64(p + i + 8 * k) * hash_p2, 31) * hash_p1;
+  std::uint64_t h1 = rotl64(acc[0], 1) + rotl64(acc[1], 7) + rotl64(acc[2], 12) + rotl64(acc[3], 18);
+  std::uint64_t h2 = (acc[0] * hash_p2) ^ rotl64(acc[1], 29) ^ (acc[2] * hash_p1) ^ rotl64(acc[3], 43);
+  for (; i + 8 <= len; i += 8) {
+    const std::uint64_t w = load64(p + i);
+    h1 = rotl64(h1 ^ (w * hash_p2), 27) * hash_p1 + hash_p2;
+    h2 = rotl64(h2 + w * hash_p1, 31) * hash_p2 ^ hash_p1;
+  }
+  for (; i < len; ++i) {
+    h1 = rotl64(h1 ^ (p[i] * hash_p1), 11) * hash_p2;
+    h2 = rotl64(h2 + p[i] * hash_p2, 13) * hash_p1;
+  }
+  return ContentHash { avalanche(h1 ^ len), avalanche(h2 + len * hash_p1) };
+}
+
+/**
+ * @brief Hashes bytes to 64 bits
+ * @param data Bytes
+ * @param len Number of bytes
+ * @param seed Seed
+ */
+inline std::uint64_t hashBytes(const void * data, std::size_t len, std::uint64_t seed = 0) {
+  return hashBytes128(data, len, ContentHash { seed, seed }).lo;
+}
+
+/**
+ * @brief Hashes content of a batch of shapes given by columns
+ * @param n Number of shapes
+ * @param t Shape types
+ * @param v Arrays with values of each column in order X, Y, Z, A and B
+ * @param tag Identifies the computation, so results of different ones do
+ * not collide (e.g. hash of a query text)
+ */
+inline ContentHash batchHash(std::size_t n, const ShapeType * t, const double * const * v, std::uint64_t tag = 0) {
+  ContentHash h = hashBytes128(t, n, ContentHash { tag, ~tag });
+  for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+    h = hashBytes128(v[c], n * sizeof(double), h);
+  return h;
+}
+
+/** @brief Hashes content of all shapes in a store */
+inline ContentHash batchHash(const ShapeStore & store, std::uint64_t tag = 0) {
+  const double * v[ShapeStore::column_count];
+  for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+    v[c] = store.column(ShapeStore::Column(c));
+  return batchHash(store.size(), store.types(), v, tag);
+}
+
+/** @brief Counters of cache operations */
+struct CacheStats {
+  std::uint64_t hits = 0;
+  std::uint64_t misses = 0;
+  std::uint64_t insertions = 0;
+  std::uint64_t evictions = 0;
+
+  /** @brief Retrieves ratio of hits to lookups */
+  double hitRate(void) const { return hits + misses ? double(hits) / double(hits + misses) : 0; }
+};
+
+/**
+ * @brief Bounded concurrent cache of results by content hash
+ *
+ * Values are kept as shared pointers to immutable results, so a hit returns
+ * the result without copying or serializing it, and it stays valid after
+ * eviction while used.
+ * @tparam V Type of results (e.g. std::vector<double> or serialized reply)
+ */
+template <class V>
+class ResultCache {
+public:
+  /** @brief Cached result */
+  typedef std::shared_ptr<const V> Value;
+
+private:
+  struct KeyHash {
+    std::size_t operator()(const ContentHash & k) const { return std::size_t(k.lo); }
+  };
+
+  struct Slot {
+    ContentHash key;
+    Value value;
+    bool referenced;
+  };
+
+  struct alignas(64) Shard {
+    std::mutex mutex;
+    std::vector<Slot> slots;
+    std::unordered_map<ContentHash, std::size_t, KeyHash> index;
+    std::size_t hand = 0;
+  };
+
+  std::size_t shard_capacity;
+  std::vector<Shard> shards;
+  std::atomic<std::uint64_t> hits;
+  std::atomic<std::uint64_t> misses;
+  std::atomic<std::uint64_t> insertions;
+  std::atomic<std::uint64_t> evictions;
+
+  /* High bits select the shard, while the index of the shard uses low bits */
+  Shard & shardOf(const ContentHash & k) { return shards[std::size_t(k.hi >> 32) % shards.size()]; }
+
+public:
+  /**
+   * @brief Construct empty cache
+   * @param capacity Maximum number of results
+   * @param shard_count Number of independently locked shards
+   */
+  explicit ResultCache(std::size_t capacity, std::size_t shard_count = 16)
+    : shard_capacity(std::max<std::size_t>(1, (capacity + std::max<std::size_t>(1, shard_count) - 1) /
+                                                  std::max<std::size_t>(1, shard_count))),
+      shards(std::max<std::size_t>(1, shard_count)), hits(0), misses(0), insertions(0), evictions(0) {
+    for (Shard & s : shards) {
+      s.slots.reserve(shard_capacity);
+      s.index.reserve(shard_capacity);
+    }
+  }
+
+  ResultCache(const ResultCache &) = delete;
+  ResultCache & operator=(const ResultCache &) = delete;
+
+  /** @brief Retrieves maximum number of results */
+  std::size_t capacity(void) const { return shard_capacity * shards.size(); }
+
+  /**
+   * @brief Looks up result
+   * @param k Content hash
+   * @return Result or null pointer if not cached
+   */
+  Value find(const ContentHash & k) {
+    Shard & s = shardOf(k);
+    {
+      std::lock_guard<std::mutex> lock(s.mutex);
+      const auto it = s.index.find(k);
+      if (it != s.index.end()) {
+        Slot & slot = s.slots[it->second];
+        slot.referenced = true;
+        ++hits;
+        return slot.value;
+      }
+    }
+    ++misses;
+    return Value();
+  }
+
+  /**
+   * @brief Stores result
+   *
+   * When the shard is full, the clock hand skips referenced entries
+   * (clearing their bit) and replaces the first unreferenced one.
+   * @param k Content hash
+   * @param v Result
+   */
+  void insert(const ContentHash & k, Value v) {
+    Shard & s = shardOf(k);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    const auto it = s.index.find(k);
+    if (it != s.index.end()) {
+      s.slots[it->second].value = std::move(v);
+      return;
+    }
+    ++insertions;
+    if (s.slots.size() < shard_capacity) {
+      s.index.emplace(k, s.slots.size());
+      s.slots.push_back(Slot { k, std::move(v), false });
+      return;
+    }
+    while (s.slots[s.hand].referenced) {
+      s.slots[s.hand].referenced = false;
+      s.hand = (s.hand + 1) % s.slots.size();
+    }
+    Slot & victim = s.slots[s.hand];
+    s.index.erase(victim.key);
+    s.index.emplace(k, s.hand);
+    victim = Slot { k, std::move(v), false };
+    s.hand = (s.hand + 1) % s.slots.size();
+    ++evictions;
+  }
+
+  /**
+   * @brief Looks up result and computes it on miss
+   *
+   * Concurrent misses of the same key may compute it more than once, but
+   * the computation runs without holding any lock.
+   * @param k Content hash
+   * @param compute Function returning the result as V
+   */
+  template <class F>
+  Value getOrCompute(const ContentHash & k, F compute) {
+    Value v = find(k);
+    if (!v) {
+      v = std::make_shared<const V>(compute());
+      insert(k, v);
+    }
+    return v;
+  }
+
+  /** @brief Retrieves number of cached results */
+  std::size_t size(void) {
+    std::size_t n = 0;
+    for (Shard & s : shards) {
+      std::lock_guard<std::mutex> lock(s.mutex);
+      n += s.slots.size();
+    }
+    return n;
+  }
+
+  /** @brief Removes all results (counters are kept) */
+  void clear(void) {
+    for (Shard & s : shards) {
+      std::lock_guard<std::mutex> lock(s.mutex);
+      s.slots.clear();
+      s.index.clear();
+      s.hand = 0;
+    }
+  }
+
+  /** @brief Retrieves counters */
+  CacheStats stats(void) const {
+    CacheStats st;
+    st.hits = hits;
+    st.misses = misses;
+    st.insertions = insertions;
+    st.evictions = evictions;
+    return st;
+  }
+};
+
+}
+
+#endif
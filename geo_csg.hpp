@@ -0,0 +1,803 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_csg.hpp
+ * Constructive solid geometry trees of circles, rectangles and squares in
+ * the plane or of spheres and cubes in space. A tree is compiled to a tape,
+ * a flat list of instructions over a few slots of memberships, which is run
+ * by SIMD loops over batches of points instead of walking the tree for each
+ * point. A tape specialized to a box drops the shapes missing the box and
+ * folds the ones covering it, which makes the tape of a small box short or
+ * constant. Area or volume is measured by subdividing the boxes, where
+ * specialization is not constant.
+ */
+
+#ifndef GEO_CSG_HPP
+#define GEO_CSG_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "geo.hpp"
+#include "geo_dispatch.hpp"
+
+namespace Geo {
+
+/** @brief Instruction codes of CSG tapes */
+enum class CsgCode : std::uint8_t {
+  /** @brief Membership in a circle or sphere */
+  Ball,
+  /** @brief Membership in a rectangle, square or cube */
+  Box,
+  /** @brief Union of a slot and the next one */
+  Union,
+  /** @brief Intersection of a slot and the next one */
+  Intersection,
+  /** @brief Difference of a slot and the next one */
+  Difference,
+  /** @brief Difference of the next slot and a slot */
+  ReverseDifference,
+  /** @brief Complement of a slot */
+  Complement
+};
+
+/** @brief Instruction of a CSG tape */
+struct CsgInstr {
+  /** @brief Code */
+  CsgCode code;
+  /** @brief Slot of the result and of the first operand */
+  std::uint8_t slot;
+  /** @brief Primitive of Ball and Box, child node in trees */
+  std::uint32_t arg;
+  /** @brief Second child node in trees */
+  std::uint32_t arg2;
+};
+
+/** @brief Relation of a region to a solid */
+enum class CsgCover : std::uint8_t {
+  /** @brief Region is out of the solid */
+  Empty,
+  /** @brief Region is in the solid */
+  Full,
+  /** @brief Region could be partially in the solid */
+  Partial
+};
+
+/** @brief Circle, rectangle or square in the plane or sphere or cube in space */
+template <unsigned D>
+struct CsgPrimitive {
+  /** @brief Whether the primitive is a circle or sphere */
+  bool round;
+  /** @brief Corner of the box with minimal coordinates */
+  double lo[D];
+  /** @brief Corner of the box with maximal coordinates */
+  double hi[D];
+  /** @brief Center of circle or sphere */
+  double c[D];
+  /** @brief Radius of circle or sphere */
+  double r;
+
+  /** @brief Checks whether a point is in the primitive (boundary included) */
+  bool contains(const double (&p)[D]) const {
+    bool in = true;
+    double d = 0;
+    for (unsigned k = 0; k < D; ++k) {
+      in = in && p[k] >= lo[k] && p[k] <= hi[k];
+      d += (p[k] - c[k]) * (p[k] - c[k]);
+    }
+    return round ? d <= r * r : in;
+  }
+
+  /**
+   * @brief Relates a closed box to the primitive
+   * @param blo Corner of the box with minimal coordinates
+   * @param bhi Corner of the box with maximal coordinates
+   */
+  CsgCover cover(const double (&blo)[D], const double (&bhi)[D]) const {
+    bool out = false, in = true;
+    double near = 0, far = 0;
+    for (unsigned k = 0; k < D; ++k) {
+      out = out || bhi[k] < lo[k] || blo[k] > hi[k];
+      in = in && blo[k] >= lo[k] && bhi[k] <= hi[k];
+      const double n = std::max({ blo[k] - c[k], 0.0, c[k] - bhi[k] });
+      const double f = std::max(std::abs(blo[k] - c[k]), std::abs(bhi[k] - c[k]));
+      near += n * n;
+      far += f * f;
+    }
+    if (round) {
+      out = near > r * r;
+      in = far <= r * r;
+    }
+    return out ? CsgCover::Empty : (in ? CsgCover::Full : CsgCover::Partial);
+  }
+};
+
+/**
+ * @brief Batch kernel running a CSG tape over points
+ *
+ * Runs m instructions of code with primitives prims over n points given by
+ * columns of coordinates in p and sets v to 1 for points in the solid or 0
+ * otherwise.
+ */
+template <unsigned D>
+using CsgKernelFn = void (*)(const CsgInstr * code, std::size_t m, const CsgPrimitive<D> * prims,
+                             const double * const * p, std::size_t n, double * v);
+
+namespace detail {
+
+/* Coordinates and boxes of each dimension */
+template <unsigned D> struct CsgSpace;
+
+template <> struct CsgSpace<2> {
+  typedef Coord2D Coord;
+  typedef BoundingBox2D Box;
+
+  static void get(const Coord2D & c, double (&p)[2]) {
+    p[0] = c.getX();
+    p[1] = c.getY();
+  }
+  static Box box(const double (&lo)[2], const double (&hi)[2]) {
+    return Box { Coord2D(lo[0], lo[1]), Coord2D(hi[0], hi[1]) };
+  }
+};
+
+template <> struct CsgSpace<3> {
+  typedef Coord3D Coord;
+  typedef BoundingBox3D Box;
+
+  static void get(const Coord3D & c, double (&p)[3]) {
+    p[0] = c.getX();
+    p[1] = c.getY();
+    p[2] = c.getZ();
+  }
+  static Box box(const double (&lo)[3], const double (&hi)[3]) {
+    return Box { Coord3D(lo[0], lo[1], lo[2]), Coord3D(hi[0], hi[1], hi[2]) };
+  }
+};
+
+/* Slots are allocated by the number of registers needed by each subtree
+ * (Sethi-Ullman), which is at most one more than the binary logarithm of
+ * the number of primitives, so a tape never needs more slots than these */
+constexpr unsigned csg_slots = 32;
+constexpr std::size_t csg_block = 128;
+
+/* Memberships of points first to first + n in a primitive */
+template <unsigned D, bool Simd>
+inline __attribute__((always_inline))
+void primitiveLoop(const CsgPrimitive<D> & t, const double * const * p, std::size_t first, std::size_t n,
+                   double * __restrict v) {
+  const double * __restrict x = p[0] + first;
+  const double * __restrict y = p[1] + first;
+  const double * __restrict z = p[D - 1] + first;
+  const double c0 = t.round ? t.c[0] : t.lo[0], c1 = t.round ? t.c[1] : t.lo[1];
+  const double c2 = t.round ? t.c[D - 1] : t.lo[D - 1];
+  const double h0 = t.hi[0], h1 = t.hi[1], h2 = t.hi[D - 1], r2 = t.r * t.r;
+  if (t.round) {
+#pragma omp simd if(simd: Simd)
+    for (std::size_t i = 0; i < n; ++i) {
+      const double d = (x[i] - c0) * (x[i] - c0) + (y[i] - c1) * (y[i] - c1) +
+                       (D == 3 ? (z[i] - c2) * (z[i] - c2) : 0.0);
+      v[i] = d <= r2 ? 1.0 : 0.0;
+    }
+  } else {
+#pragma omp simd if(simd: Simd)
+    for (std::size_t i = 0; i < n; ++i)
+      v[i] = ((x[i] >= c0) & (x[i] <= h0) & (y[i] >= c1) & (y[i] <= h1) &
+              (D < 3 || ((z[i] >= c2) & (z[i] <= h2)))) ? 1.0 : 0.0;
+  }
+}
+
+/* Memberships are doubles, so union, intersection and difference are
+ * maximum, minimum and minimum with the complement without branches */
+template <CsgCode C, bool Simd>
+inline __attribute__((always_inline))
+void combineLoop(double * __restrict a, const double * __restrict b, std::size_t n) {
+#pragma omp simd if(simd: Simd)
+  for (std::size_t i = 0; i < n; ++i) {
+    const double u = a[i], w = b[i];
+    if constexpr (C == CsgCode::Union)
+      a[i] = std::max(u, w);
+    else if constexpr (C == CsgCode::Intersection)
+      a[i] = std::min(u, w);
+    else if constexpr (C == CsgCode::Difference)
+      a[i] = std::min(u, 1 - w);
+    else if constexpr (C == CsgCode::ReverseDifference)
+      a[i] = std::min(w, 1 - u);
+    else
+      a[i] = 1 - u;
+  }
+}
+
+/* Runs the whole tape over blocks of points, so the slots of a block stay
+ * in the first level cache */
+template <unsigned D>
+struct TapeLoop {
+  template <bool Simd>
+  static inline __attribute__((always_inline))
+  void run(const CsgInstr * code, std::size_t m, const CsgPrimitive<D> * prims,
+          const double * const * p, std::size_t n, double * v) {
+    alignas(64) double r[csg_slots][csg_block];
+    for (std::size_t first = 0; first < n; first += csg_block) {
+      const std::size_t len = std::min(csg_block, n - first);
+      for (std::size_t j = 0; j < m; ++j) {
+        double * s = r[code[j].slot];
+        switch (code[j].code) {
+        case CsgCode::Ball:
+        case CsgCode::Box:
+          primitiveLoop<D, Simd>(prims[code[j].arg], p, first, len, s);
+          break;
+        case CsgCode::Union:
+          combineLoop<CsgCode::Union, Simd>(s, s + csg_block, len);
+          break;
+        case CsgCode::Intersection:
+          combineLoop<CsgCode::Intersection, Simd>(s, s + csg_block, len);
+          break;
+        case CsgCode::Difference:
+          combineLoop<CsgCode::Difference, Simd>(s, s + csg_block, len);
+          break;
+        case CsgCode::ReverseDifference:
+          combineLoop<CsgCode::ReverseDifference, Simd>(s, s + csg_block, len);
+          break;
+        case CsgCode::Complement:
+          combineLoop<CsgCode::Complement, Simd>(s, s + csg_block, len);
+          break;
+        }
+      }
+      std::copy(r[0], r[0] + len, v + first);
+    }
+  }
+};
+
+template <unsigned D>
+using TapeKernel = IsaKernel<CsgKernelFn<D>, TapeLoop<D>>;
+
+}
+
+/**
+ * @brief Selects CSG tape kernel compiled for an instruction set level
+ *
+ * The caller is responsible for the processor supporting the level.
+ * @param isa Instruction set level
+ */
+template <unsigned D>
+CsgKernelFn<D> csgKernel(Isa isa) {
+  return detail::TapeKernel<D>::select(isa);
+}
+
+/** @brief Selects CSG tape kernel for the active instruction set level */
+template <unsigned D>
+CsgKernelFn<D> dispatchCsgKernel(void) {
+  static const CsgKernelFn<D> k = csgKernel<D>(activeIsa());
+  return k;
+}
+
+/**
+ * @brief Compiled CSG tree
+ *
+ * Keeps the tree of the tape as nodes in postfix order, where a node is an
+ * instruction with its children in arg and arg2, and the instructions with
+ * allocated slots. Constant tapes have no instructions. The tape refers to
+ * the primitives of its tree, which must outlive it.
+ */
+template <unsigned D>
+class CsgTape {
+private:
+  typedef detail::CsgSpace<D> Space;
+
+  static constexpr std::uint32_t empty_ref = std::numeric_limits<std::uint32_t>::max();
+  static constexpr std::uint32_t full_ref = empty_ref - 1;
+
+  const std::vector<CsgPrimitive<D>> * prims;
+  std::vector<CsgInstr> nodes;
+  std::vector<CsgInstr> instrs;
+  CsgCover constant;
+  unsigned nslots;
+
+  /* Emits instructions and compacted nodes of the subtree of root, taking
+   * at each node first the child needing more slots */
+  void emit(const std::vector<CsgInstr> & tree, std::uint32_t root) {
+    std::vector<unsigned> need(tree.size());
+    for (std::size_t i = 0; i < tree.size(); ++i) {
+      const CsgInstr & t = tree[i];
+      if (t.code == CsgCode::Ball || t.code == CsgCode::Box)
+        need[i] = 1;
+      else if (t.code == CsgCode::Complement)
+        need[i] = need[t.arg];
+      else
+        need[i] = need[t.arg] == need[t.arg2] ? need[t.arg] + 1 : std::max(need[t.arg], need[t.arg2]);
+    }
+    if (need[root] > detail::csg_slots)
+      throw std::length_error("CSG tree needs too many slots");
+    struct Frame {
+      std::uint32_t node;
+      unsigned slot;
+      unsigned stage;
+    };
+    std::vector<Frame> stack(1, Frame { root, 0, 0 });
+    std::vector<std::uint32_t> done;
+    nslots = 0;
+    while (!stack.empty()) {
+      Frame & f = stack.back();
+      const CsgInstr t = tree[f.node];
+      const unsigned slot = f.slot;
+      nslots = std::max(nslots, slot + 1);
+      if (t.code == CsgCode::Ball || t.code == CsgCode::Box) {
+        instrs.push_back(CsgInstr { t.code, std::uint8_t(slot), t.arg, 0 });
+        done.push_back(std::uint32_t(nodes.size()));
+        nodes.push_back(t);
+        stack.pop_back();
+      } else if (t.code == CsgCode::Complement) {
+        if (f.stage++ == 0) {
+          stack.push_back(Frame { t.arg, slot, 0 });
+          continue;
+        }
+        instrs.push_back(CsgInstr { t.code, std::uint8_t(slot), 0, 0 });
+        const std::uint32_t a = done.back();
+        done.back() = std::uint32_t(nodes.size());
+        nodes.push_back(CsgInstr { t.code, 0, a, 0 });
+        stack.pop_back();
+      } else {
+        const bool left_first = need[t.arg] >= need[t.arg2];
+        const unsigned stage = f.stage++;
+        if (stage < 2) {
+          const std::uint32_t child = (stage == 0) == left_first ? t.arg : t.arg2;
+          stack.push_back(Frame { child, slot + stage, 0 });
+          continue;
+        }
+        const CsgCode c = t.code == CsgCode::Difference && !left_first ? CsgCode::ReverseDifference : t.code;
+        instrs.push_back(CsgInstr { c, std::uint8_t(slot), 0, 0 });
+        std::uint32_t a = done[done.size() - 2], b = done.back();
+        if (!left_first)
+          std::swap(a, b);
+        done.pop_back();
+        done.back() = std::uint32_t(nodes.size());
+        nodes.push_back(CsgInstr { t.code, 0, a, b });
+        stack.pop_back();
+      }
+    }
+  }
+
+public:
+  /**
+   * @brief Compiles tree
+   * @param p Primitives
+   * @param tree Nodes, with children before their parents
+   * @param root Root node
+   */
+  CsgTape(const std::vector<CsgPrimitive<D>> & p, const std::vector<CsgInstr> & tree, std::uint32_t root)
+    : prims(&p), constant(CsgCover::Partial), nslots(0) {
+    emit(tree, root);
+  }
+  /**
+   * @brief Constant tape
+   * @param p Primitives
+   * @param c Empty or Full
+   */
+  CsgTape(const std::vector<CsgPrimitive<D>> & p, CsgCover c) : prims(&p), constant(c), nslots(0) {}
+
+  /** @brief Whether the tape is constant (Empty or Full) or not (Partial) */
+  CsgCover cover(void) const { return constant; }
+  /** @brief Retrieves instructions */
+  const std::vector<CsgInstr> & code(void) const { return instrs; }
+  /** @brief Retrieves primitives referred by the instructions */
+  const std::vector<CsgPrimitive<D>> & primitives(void) const { return *prims; }
+  /** @brief Retrieves number of instructions */
+  std::size_t size(void) const { return instrs.size(); }
+  /** @brief Retrieves number of slots */
+  unsigned slots(void) const { return nslots; }
+
+  /**
+   * @brief Checks whether a point is in the solid
+   * @param c Point
+   */
+  bool contains(const typename Space::Coord & c) const {
+    if (constant != CsgCover::Partial)
+      return constant == CsgCover::Full;
+    double p[D];
+    Space::get(c, p);
+    bool s[detail::csg_slots + 1] = {};
+    for (const CsgInstr & t : instrs) {
+      bool & a = s[t.slot];
+      const bool b = s[t.slot + 1];
+      switch (t.code) {
+      case CsgCode::Ball:
+      case CsgCode::Box:
+        a = (*prims)[t.arg].contains(p);
+        break;
+      case CsgCode::Union: a = a || b; break;
+      case CsgCode::Intersection: a = a && b; break;
+      case CsgCode::Difference: a = a && !b; break;
+      case CsgCode::ReverseDifference: a = b && !a; break;
+      case CsgCode::Complement: a = !a; break;
+      }
+    }
+    return s[0];
+  }
+
+  /**
+   * @brief Checks whether points are in the solid
+   * @param p Columns of coordinates of the points
+   * @param n Number of points
+   * @param v Set to 1 for points in the solid and 0 for the others
+   */
+  void contains(const double * const * p, std::size_t n, double * v) const {
+    if (constant != CsgCover::Partial)
+      std::fill(v, v + n, constant == CsgCover::Full ? 1.0 : 0.0);
+    else
+      dispatchCsgKernel<D>()(instrs.data(), instrs.size(), prims->data(), p, n, v);
+  }
+
+  /**
+   * @brief Specializes the tape to a closed box
+   *
+   * Primitives missing the box become empty and the ones covering it full,
+   * and the operations with them are folded. The result is the same as of
+   * the tape for points in the box.
+   * @param lo Corner of the box with minimal coordinates
+   * @param hi Corner of the box with maximal coordinates
+   * @return Tape, which may be constant
+   */
+  CsgTape specialize(const double (&lo)[D], const double (&hi)[D]) const {
+    if (constant != CsgCover::Partial)
+      return *this;
+    std::vector<CsgInstr> tree;
+    tree.reserve(nodes.size());
+    std::vector<std::uint32_t> ref(nodes.size());
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+      const CsgInstr & t = nodes[i];
+      std::uint32_t r;
+      if (t.code == CsgCode::Ball || t.code == CsgCode::Box) {
+        const CsgCover c = (*prims)[t.arg].cover(lo, hi);
+        r = c == CsgCover::Empty ? empty_ref : (c == CsgCover::Full ? full_ref : std::uint32_t(tree.size()));
+        if (c == CsgCover::Partial)
+          tree.push_back(t);
+      } else if (t.code == CsgCode::Complement) {
+        const std::uint32_t a = ref[t.arg];
+        if (a == empty_ref || a == full_ref)
+          r = a == empty_ref ? full_ref : empty_ref;
+        else if (tree[a].code == CsgCode::Complement)
+          r = tree[a].arg;
+        else {
+          r = std::uint32_t(tree.size());
+          tree.push_back(CsgInstr { t.code, 0, a, 0 });
+        }
+      } else {
+        const std::uint32_t a = ref[t.arg], b = ref[t.arg2];
+        const bool ca = a == empty_ref || a == full_ref, cb = b == empty_ref || b == full_ref;
+        if (t.code == CsgCode::Union && (ca || cb))
+          r = a == full_ref || b == full_ref ? full_ref : (ca ? b : a);
+        else if (t.code == CsgCode::Intersection && (ca || cb))
+          r = a == empty_ref || b == empty_ref ? empty_ref : (ca ? b : a);
+        else if (t.code == CsgCode::Difference && (a == empty_ref || b == full_ref))
+          r = empty_ref;
+        else if (t.code == CsgCode::Difference && b == empty_ref)
+          r = a;
+        else if (t.code == CsgCode::Difference && a == full_ref) {
+          if (tree[b].code == CsgCode::Complement)
+            r = tree[b].arg;
+          else {
+            r = std::uint32_t(tree.size());
+            tree.push_back(CsgInstr { CsgCode::Complement, 0, b, 0 });
+          }
+        } else {
+          r = std::uint32_t(tree.size());
+          tree.push_back(CsgInstr { t.code, 0, a, b });
+        }
+      }
+      ref[i] = r;
+    }
+    const std::uint32_t root = ref.back();
+    if (root == empty_ref || root == full_ref)
+      return CsgTape(*prims, root == empty_ref ? CsgCover::Empty : CsgCover::Full);
+    return CsgTape(*prims, tree, root);
+  }
+};
+
+/** @brief Options of measuring CSG trees */
+struct CsgMeasureOptions {
+  /** @brief Number of halvings of the bounding box */
+  unsigned depth = 6;
+  /** @brief Number of samples along each side of partial boxes at the last level */
+  unsigned samples = 8;
+};
+
+/** @brief Area or volume of a CSG tree */
+struct CsgMeasure {
+  /** @brief Estimated measure */
+  double value;
+  /** @brief Measure of boxes in the solid, not above the exact one */
+  double lower;
+  /** @brief Measure of boxes partially or fully in the solid, not below the exact one */
+  double upper;
+};
+
+/**
+ * @brief Constructive solid geometry tree
+ *
+ * Nodes are primitives (circles, rectangles and squares in the plane or
+ * spheres and cubes in space) and unions, intersections and differences of
+ * other nodes. Nodes are referred by indices returned when adding them and
+ * the last added node is the root. Nodes used several times are evaluated
+ * once per use. Points on the boundary of a primitive belong to it.
+ */
+template <unsigned D>
+class CsgTree {
+public:
+  /** @brief Index of node */
+  typedef std::uint32_t Node;
+  /** @brief Coordinates */
+  typedef typename detail::CsgSpace<D>::Coord Coord;
+  /** @brief Bounding box */
+  typedef typename detail::CsgSpace<D>::Box Box;
+
+private:
+  typedef detail::CsgSpace<D> Space;
+
+  std::vector<CsgPrimitive<D>> prims;
+  std::vector<CsgInstr> nodes;
+  /* Box of each node, with minimum above maximum when empty */
+  std::vector<double> blo[D];
+  std::vector<double> bhi[D];
+
+  Node primitive(const CsgPrimitive<D> & p) {
+    nodes.push_back(CsgInstr { p.round ? CsgCode::Ball : CsgCode::Box, 0, std::uint32_t(prims.size()), 0 });
+    prims.push_back(p);
+    for (unsigned k = 0; k < D; ++k) {
+      blo[k].push_back(p.lo[k]);
+      bhi[k].push_back(p.hi[k]);
+    }
+    return Node(nodes.size() - 1);
+  }
+
+  Node combine(CsgCode c, Node a, Node b) {
+    if (a >= nodes.size() || b >= nodes.size())
+      throw std::out_of_range("CSG node does not exist");
+    nodes.push_back(CsgInstr { c, 0, a, b });
+    for (unsigned k = 0; k < D; ++k) {
+      double lo = blo[k][a], hi = bhi[k][a];
+      if (c == CsgCode::Union) {
+        lo = std::min(lo, blo[k][b]);
+        hi = std::max(hi, bhi[k][b]);
+      } else if (c == CsgCode::Intersection) {
+        lo = std::max(lo, blo[k][b]);
+        hi = std::min(hi, bhi[k][b]);
+      }
+      blo[k].push_back(lo);
+      bhi[k].push_back(hi);
+    }
+    return Node(nodes.size() - 1);
+  }
+
+  static CsgPrimitive<D> ball(const Coord & c, double r) {
+    CsgPrimitive<D> p;
+    p.round = true;
+    Space::get(c, p.c);
+    for (unsigned k = 0; k < D; ++k) {
+      p.lo[k] = p.c[k] - r;
+      p.hi[k] = p.c[k] + r;
+    }
+    p.r = r;
+    return p;
+  }
+
+  static CsgPrimitive<D> box(const Box & b) {
+    CsgPrimitive<D> p;
+    p.round = false;
+    Space::get(b.min, p.lo);
+    Space::get(b.max, p.hi);
+    for (unsigned k = 0; k < D; ++k)
+      p.c[k] = 0;
+    p.r = 0;
+    return p;
+  }
+
+  /* Grid of samples in the unit box and buffers for partial boxes */
+  struct Samples {
+    std::vector<double> grid[D];
+    std::vector<double> pts[D];
+    std::vector<double> in;
+  };
+
+  /* Adds measures of the box and its parts */
+  void measureBox(const CsgTape<D> & tape, const double (&lo)[D], const double (&hi)[D], unsigned depth,
+                  const CsgMeasureOptions & opt, Samples & smp, CsgMeasure & m) const {
+    const CsgTape<D> t = tape.specialize(lo, hi);
+    double size = 1;
+    for (unsigned k = 0; k < D; ++k)
+      size *= hi[k] - lo[k];
+    if (t.cover() == CsgCover::Empty)
+      return;
+    if (t.cover() == CsgCover::Full) {
+      m.value += size;
+      m.lower += size;
+      m.upper += size;
+      return;
+    }
+    if (depth == opt.depth) {
+      const std::size_t n = smp.in.size();
+      const double * p[D];
+      for (unsigned k = 0; k < D; ++k) {
+        const double o = lo[k], e = hi[k] - lo[k];
+        const double * __restrict g = smp.grid[k].data();
+        double * __restrict x = smp.pts[k].data();
+#pragma omp simd
+        for (std::size_t i = 0; i < n; ++i)
+          x[i] = o + e * g[i];
+        p[k] = x;
+      }
+      t.contains(p, n, smp.in.data());
+      double c = 0;
+#pragma omp simd reduction(+ : c)
+      for (std::size_t i = 0; i < n; ++i)
+        c += smp.in[i];
+      m.value += size * c / double(n);
+      m.upper += size;
+      return;
+    }
+    for (unsigned q = 0; q < (1u << D); ++q) {
+      double clo[D], chi[D];
+      for (unsigned k = 0; k < D; ++k) {
+        const double mid = (lo[k] + hi[k]) / 2;
+        clo[k] = (q >> k) & 1 ? mid : lo[k];
+        chi[k] = (q >> k) & 1 ? hi[k] : mid;
+      }
+      measureBox(t, clo, chi, depth + 1, opt, smp, m);
+    }
+  }
+
+public:
+  /** @brief Adds circle */
+  Node add(Circle c) {
+    static_assert(D == 2, "circles are planar");
+    return primitive(ball(c.getRefPoint(), c.getRadius()));
+  }
+  /** @brief Adds rectangle */
+  Node add(Rectangle r) {
+    static_assert(D == 2, "rectangles are planar");
+    return primitive(box(r.boundingBox()));
+  }
+  /** @brief Adds square */
+  Node add(Square s) {
+    static_assert(D == 2, "squares are planar");
+    return primitive(box(s.boundingBox()));
+  }
+  /** @brief Adds sphere */
+  Node add(Sphere s) {
+    static_assert(D == 3, "spheres are solid");
+    return primitive(ball(s.getRefPoint(), s.getRadius()));
+  }
+  /** @brief Adds cube */
+  Node add(Cube c) {
+    static_assert(D == 3, "cubes are solid");
+    return primitive(box(c.boundingBox()));
+  }
+  /** @brief Adds primitive */
+  Node add(const CsgPrimitive<D> & p) { return primitive(p); }
+  /** @brief Adds union of two nodes */
+  Node unite(Node a, Node b) { return combine(CsgCode::Union, a, b); }
+  /** @brief Adds intersection of two nodes */
+  Node intersect(Node a, Node b) { return combine(CsgCode::Intersection, a, b); }
+  /** @brief Adds difference of two nodes */
+  Node subtract(Node a, Node b) { return combine(CsgCode::Difference, a, b); }
+
+  /** @brief Retrieves number of nodes */
+  std::size_t size(void) const { return nodes.size(); }
+  /** @brief Retrieves primitives */
+  const std::vector<CsgPrimitive<D>> & primitives(void) const { return prims; }
+
+  /**
+   * @brief Checks whether a point is in the solid of the root
+   *
+   * Evaluates all nodes in order of addition, which is slow for single
+   * points of big trees, but needs no compilation.
+   * @param c Point
+   */
+  bool contains(const Coord & c) const {
+    if (nodes.empty())
+      return false;
+    double p[D];
+    Space::get(c, p);
+    std::vector<std::uint8_t> in(nodes.size());
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+      const CsgInstr & t = nodes[i];
+      switch (t.code) {
+      case CsgCode::Union: in[i] = in[t.arg] | in[t.arg2]; break;
+      case CsgCode::Intersection: in[i] = in[t.arg] & in[t.arg2]; break;
+      case CsgCode::Difference: in[i] = in[t.arg] & !in[t.arg2]; break;
+      default: in[i] = prims[t.arg].contains(p); break;
+      }
+    }
+    return in.back();
+  }
+
+  /**
+   * @brief Calculates a box containing the solid of the root
+   *
+   * Unions extend the box and intersections clip it, while differences keep
+   * the box of the first node. The box is not necessarily the smallest one.
+   * @return Box, with minimum above maximum when the solid is empty
+   */
+  Box boundingBox(void) const {
+    double lo[D], hi[D];
+    for (unsigned k = 0; k < D; ++k) {
+      lo[k] = nodes.empty() ? std::numeric_limits<double>::infinity() : blo[k].back();
+      hi[k] = nodes.empty() ? -std::numeric_limits<double>::infinity() : bhi[k].back();
+    }
+    return Space::box(lo, hi);
+  }
+
+  /**
+   * @brief Compiles the root to a tape
+   *
+   * The tape refers to the primitives of the tree, so the tree must outlive
+   * it and must not be changed while the tape is used.
+   */
+  CsgTape<D> compile(void) const {
+    if (nodes.empty())
+      return CsgTape<D>(prims, CsgCover::Empty);
+    return CsgTape<D>(prims, nodes, Node(nodes.size() - 1));
+  }
+
+  /**
+   * @brief Measures area (in the plane) or volume (in space) of the root
+   *
+   * The bounding box is halved along each axis down to the given depth.
+   * Boxes, where the specialized tape is constant, are counted exactly and
+   * the partial ones at the last level by the fraction of a grid of
+   * samples in the solid, so the exact measure is between the bounds.
+   * @param opt Options
+   */
+  CsgMeasure measure(const CsgMeasureOptions & opt = CsgMeasureOptions()) const {
+    CsgMeasure m = { 0, 0, 0 };
+    if (nodes.empty())
+      return m;
+    double lo[D], hi[D];
+    for (unsigned k = 0; k < D; ++k) {
+      lo[k] = blo[k].back();
+      hi[k] = bhi[k].back();
+      if (!(lo[k] < hi[k]))
+        return m;
+    }
+    const std::size_t s = std::max(opt.samples, 1u), n = D == 2 ? s * s : s * s * s;
+    /* Midpoints of a grid of samples */
+    Samples smp;
+    for (std::size_t k = 0, stride = 1; k < D; ++k, stride *= s) {
+      smp.pts[k].resize(n);
+      for (std::size_t i = 0; i < n; ++i)
+        smp.grid[k].push_back((double(i / stride % s) + 0.5) / double(s));
+    }
+    smp.in.resize(n);
+    measureBox(compile(), lo, hi, 0, opt, smp, m);
+    return m;
+  }
+};
+
+/** @brief CSG tree of circles, rectangles and squares */
+typedef CsgTree<2> CsgTree2D;
+/** @brief CSG tree of spheres and cubes */
+typedef CsgTree<3> CsgTree3D;
+
+}
+
+#endif
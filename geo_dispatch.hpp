@@ -0,0 +1,271 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_dispatch.hpp
+ * Runtime selection of batch kernels from geo_kernels.hpp by instruction
+ * set. Every kernel is compiled for scalar code, SSE2, AVX2 and AVX-512 in
+ * the same binary and the best one supported by the processor is selected
+ * once at startup. Environment variable GEOEX_ISA (scalar, sse2, avx2 or
+ * avx512) forces a lower level, e.g. for benchmarking.
+ */
+
+#ifndef GEO_DISPATCH_HPP
+#define GEO_DISPATCH_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "geo_kernels.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define GEO_X86_DISPATCH 1
+#endif
+
+namespace Geo {
+
+/** @brief Instruction set levels of batch kernels */
+enum class Isa {
+  Scalar,
+  SSE2,
+  AVX2,
+  AVX512
+};
+
+/** @brief Number of instruction set levels */
+constexpr unsigned isa_count = 4;
+
+/** @brief Retrieves name of instruction set level */
+inline const char * isaName(Isa i) {
+  static const char * const names[isa_count] = { "scalar", "sse2", "avx2", "avx512" };
+  return names[unsigned(i)];
+}
+
+/** @brief Detects the highest instruction set level supported by the processor */
+inline Isa detectIsa(void) {
+#ifdef GEO_X86_DISPATCH
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    return Isa::AVX512;
+  if (__builtin_cpu_supports("avx2"))
+    return Isa::AVX2;
+  if (__builtin_cpu_supports("sse2"))
+    return Isa::SSE2;
+#endif
+  return Isa::Scalar;
+}
+
+/**
+ * @brief Retrieves instruction set level used by dispatched kernels
+ *
+ * Determined once as the detected level, unless GEOEX_ISA names a lower
+ * one. Levels above the detected one are not allowed, so forcing cannot
+ * lead to illegal instructions. Unknown levels and levels above the
+ * detected one are reported on standard error with the level used instead.
+ */
+inline Isa activeIsa(void) {
+  static const Isa active = [] {
+    const Isa best = detectIsa();
+    const char * env = std::getenv("GEOEX_ISA");
+    if (!env || !*env)
+      return best;
+    for (unsigned i = 0; i < isa_count; ++i)
+      if (std::strcmp(env, isaName(Isa(i))) == 0) {
+        if (i <= unsigned(best))
+          return Isa(i);
+        std::fprintf(stderr, "GEOEX_ISA: level '%s' is not supported by the processor, using %s\n",
+                     env, isaName(best));
+        return best;
+      }
+    std::fprintf(stderr, "GEOEX_ISA: unknown level '%s' (expected", env);
+    for (unsigned i = 0; i < isa_count; ++i)
+      std::fprintf(stderr, "%s %s", i ? "," : "", isaName(Isa(i)));
+    std::fprintf(stderr, "), using %s\n", isaName(best));
+    return best;
+  }();
+  return active;
+}
+
+namespace detail {
+
+/* Checks whether the processor supports AVX-512BW, which 512 bit vectors of
+ * bytes need */
+inline bool hasAvx512bw(void) {
+#ifdef GEO_X86_DISPATCH
+  static const bool bw = (__builtin_cpu_init(), __builtin_cpu_supports("avx512bw"));
+  return bw;
+#else
+  return false;
+#endif
+}
+
+/* Coefficient of a type is selected by comparisons instead of loaded by
+ * index, so the loops vectorize without gathers */
+inline __attribute__((always_inline)) double coeff(const double (&k)[shape_type_count], unsigned s) {
+  double r = k[0];
+  r = s == 1 ? k[1] : r;
+  r = s == 2 ? k[2] : r;
+  r = s == 3 ? k[3] : r;
+  r = s == 4 ? k[4] : r;
+  return r;
+}
+
+/*
+ * Kernel of type Fn compiled for every instruction set level. Body::run is
+ * the always inline loop of the kernel, which is inlined in a function for
+ * each level. The loop gets Simd false at scalar level and should mark
+ * itself for vectorization by "#pragma omp simd if(simd: Simd)", since the
+ * pragma overrides the optimize attribute. Kernels are compiled without
+ * jump threading, which would turn selections of the loops into branches.
+ * Loops with Bytes in vectors need AVX-512BW for AVX-512 level and fall
+ * back to AVX2 level on processors without it.
+ */
+template <class Fn, class Body, bool Bytes = false>
+struct IsaKernel;
+
+template <class R, class ... A, class Body, bool Bytes>
+struct IsaKernel<R (*)(A ...), Body, Bytes> {
+  typedef R (*Fn)(A ...);
+
+  __attribute__((optimize("no-tree-vectorize", "no-tree-slp-vectorize")))
+  static R scalar(A ... a) { return Body::template run<false>(a ...); }
+
+  __attribute__((optimize("no-thread-jumps")))
+  static R generic(A ... a) { return Body::template run<true>(a ...); }
+
+#ifdef GEO_X86_DISPATCH
+  __attribute__((target("sse2"), optimize("no-thread-jumps")))
+  static R sse2(A ... a) { return Body::template run<true>(a ...); }
+
+  __attribute__((target("avx2"), optimize("no-thread-jumps")))
+  static R avx2(A ... a) { return Body::template run<true>(a ...); }
+
+  __attribute__((target("avx512f,prefer-vector-width=512"), optimize("no-thread-jumps")))
+  static R avx512(A ... a) { return Body::template run<true>(a ...); }
+
+  __attribute__((target("avx512f,avx512bw,prefer-vector-width=512"), optimize("no-thread-jumps")))
+  static R avx512bw(A ... a) { return Body::template run<true>(a ...); }
+
+  static constexpr Fn wide(void) {
+    if constexpr (Bytes)
+      return &avx512bw;
+    else
+      return &avx512;
+  }
+#endif
+
+  /* Kernel of a level, which the processor must support */
+  static Fn select(Isa isa) {
+    static const Fn table[isa_count] = {
+      &scalar,
+#ifdef GEO_X86_DISPATCH
+      &sse2,
+      &avx2,
+      wide()
+#else
+      &generic,
+      &generic,
+      &generic
+#endif
+    };
+    if (Bytes && isa == Isa::AVX512 && !hasAvx512bw())
+      isa = Isa::AVX2;
+    return table[unsigned(isa)];
+  }
+};
+
+/* Loop of the batch kernel of a measure, shape type, precision and layout
+ * as in batchLoop */
+template <Measure M, ShapeType S, class T, Layout L>
+struct MeasureLoop {
+  template <bool Simd>
+  static inline __attribute__((always_inline)) void run(const Batch<T> & in, T * __restrict out) {
+    const T * __restrict a = in.a;
+    const T * __restrict b = in.b;
+    const std::size_t n = in.n;
+    if constexpr (L == Layout::Interleaved) {
+#pragma omp simd if(simd: Simd)
+      for (std::size_t i = 0; i < n; ++i)
+        out[i] = formula<M, S, T>(a[2 * i], a[2 * i + 1]);
+    } else if constexpr (usesB(M, S)) {
+#pragma omp simd if(simd: Simd)
+      for (std::size_t i = 0; i < n; ++i)
+        out[i] = formula<M, S, T>(a[i], b[i]);
+    } else {
+#pragma omp simd if(simd: Simd)
+      for (std::size_t i = 0; i < n; ++i)
+        out[i] = formula<M, S, T>(a[i], T(0));
+    }
+  }
+};
+
+template <class T, std::size_t ... I>
+std::array<KernelFn<T>, sizeof...(I)> isaKernelTable(Isa isa, std::index_sequence<I...>) {
+  return {{ IsaKernel<KernelFn<T>, MeasureLoop<Measure(I / (shape_type_count * layout_count)),
+                                               ShapeType(I / layout_count % shape_type_count),
+                                               T,
+                                               Layout(I % layout_count)> >::select(isa)... }};
+}
+
+template <class T>
+const std::array<KernelFn<T>, kernel_count> & isaTable(Isa isa) {
+  typedef std::make_index_sequence<kernel_count> Seq;
+  static const std::array<std::array<KernelFn<T>, kernel_count>, isa_count> tables = {{
+    isaKernelTable<T>(Isa::Scalar, Seq()),
+    isaKernelTable<T>(Isa::SSE2, Seq()),
+    isaKernelTable<T>(Isa::AVX2, Seq()),
+    isaKernelTable<T>(Isa::AVX512, Seq())
+  }};
+  return tables[unsigned(isa)];
+}
+
+}
+
+/**
+ * @brief Selects batch kernel compiled for an instruction set level
+ *
+ * The caller is responsible for the processor supporting the level.
+ * @param m Measure
+ * @param s Shape type
+ * @param l Storage layout
+ * @param isa Instruction set level
+ */
+template <class T>
+KernelFn<T> kernel(Measure m, ShapeType s, Layout l, Isa isa) {
+  return detail::isaTable<T>(isa)[detail::kernelIndex(m, s, l)];
+}
+
+/**
+ * @brief Selects batch kernel for the active instruction set level
+ * @param m Measure
+ * @param s Shape type
+ * @param l Storage layout
+ */
+template <class T>
+KernelFn<T> dispatchKernel(Measure m, ShapeType s, Layout l) {
+  static const std::array<KernelFn<T>, detail::kernel_count> & table = detail::isaTable<T>(activeIsa());
+  return table[detail::kernelIndex(m, s, l)];
+}
+
+}
+
+#endif
@@ -0,0 +1,216 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_expr.hpp
+ * Expression templates for combining shapes' measures. An expression like
+ * <code>area() / perimeter()</code> builds a type describing the calculation,
+ * which is evaluated for each shape in a single pass without temporaries.
+ * Over columns of a ShapeStore expressions are evaluated with the formulas
+ * of shape types known at compile time, so each type gets a vector loop.
+ */
+
+#ifndef GEO_EXPR_HPP
+#define GEO_EXPR_HPP
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "geo_kernels.hpp"
+
+namespace Geo {
+
+namespace Metric {
+
+namespace detail {
+
+/* Measure of shape of any type, selected without branches */
+template <Measure M>
+inline double select(ShapeType t, double a, double b) {
+  double v = formula<M, ShapeType::Circle, double>(a, b);
+  v = t == ShapeType::Rectangle ? formula<M, ShapeType::Rectangle, double>(a, b) : v;
+  v = t == ShapeType::Square ? formula<M, ShapeType::Square, double>(a, b) : v;
+  v = t == ShapeType::Sphere ? formula<M, ShapeType::Sphere, double>(a, b) : v;
+  v = t == ShapeType::Cube ? formula<M, ShapeType::Cube, double>(a, b) : v;
+  return v;
+}
+
+}
+
+/** @brief Base of all metric expressions */
+template <class E>
+struct Expression {
+  /** @brief Retrieves the actual expression */
+  const E & self(void) const { return static_cast<const E &>(*this); }
+};
+
+/** @brief Shape's area */
+struct Area: Expression<Area> {
+  /** @brief Evaluates the expression for a shape */
+  template <class S> double operator()(S & s) const { return s.area(); }
+  /** @brief Evaluates the expression for dimensions of a shape type */
+  template <ShapeType S> double eval(double a, double b) const { return formula<Measure::Area, S, double>(a, b); }
+  /** @brief Evaluates the expression for dimensions of a shape of any type */
+  double eval(ShapeType t, double a, double b) const { return detail::select<Measure::Area>(t, a, b); }
+};
+
+/** @brief Shape's perimeter */
+struct Perimeter: Expression<Perimeter> {
+  /** @brief Evaluates the expression for a shape */
+  template <class S> double operator()(S & s) const { return s.perimeter(); }
+  /** @brief Evaluates the expression for dimensions of a shape type */
+  template <ShapeType S> double eval(double a, double b) const { return formula<Measure::Perimeter, S, double>(a, b); }
+  /** @brief Evaluates the expression for dimensions of a shape of any type */
+  double eval(ShapeType t, double a, double b) const { return detail::select<Measure::Perimeter>(t, a, b); }
+};
+
+/**
+ * @brief Shape's volume
+ *
+ * Two dimensional shapes do not define volume, so it's evaluated to zero.
+ */
+struct Volume: Expression<Volume> {
+private:
+  template <class S>
+  static auto get(S & s, int) -> decltype(s.volume()) { return s.volume(); }
+  template <class S>
+  static double get(S &, long) { return 0; }
+
+public:
+  /** @brief Evaluates the expression for a shape */
+  template <class S> double operator()(S & s) const { return get(s, 0); }
+  /** @brief Evaluates the expression for dimensions of a shape type */
+  template <ShapeType S> double eval(double a, double b) const { return formula<Measure::Volume, S, double>(a, b); }
+  /** @brief Evaluates the expression for dimensions of a shape of any type */
+  double eval(ShapeType t, double a, double b) const { return detail::select<Measure::Volume>(t, a, b); }
+};
+
+/** @brief Constant value */
+struct Constant: Expression<Constant> {
+  /** @brief The value */
+  double value;
+
+  /**
+   * @brief Construct constant expression
+   * @param v The value
+   */
+  explicit Constant(double v) : value(v) {}
+
+  /** @brief Evaluates the expression, which does not depend on the shape */
+  template <class S> double operator()(S &) const { return value; }
+  /** @brief Evaluates the expression, which does not depend on the shape */
+  template <ShapeType S> double eval(double, double) const { return value; }
+  /** @brief Evaluates the expression, which does not depend on the shape */
+  double eval(ShapeType, double, double) const { return value; }
+};
+
+/** @brief Arithmetic operation over two expressions */
+template <class L, class R, class Op>
+struct Binary: Expression<Binary<L, R, Op> > {
+  /** @brief Left operand */
+  L left;
+  /** @brief Right operand */
+  R right;
+
+  /**
+   * @brief Construct binary expression
+   * @param l Left operand
+   * @param r Right operand
+   */
+  Binary(const L & l, const R & r) : left(l), right(r) {}
+
+  /** @brief Evaluates the expression for a shape */
+  template <class S> double operator()(S & s) const { return Op()(left(s), right(s)); }
+  /** @brief Evaluates the expression for dimensions of a shape type */
+  template <ShapeType S> double eval(double a, double b) const {
+    return Op()(left.template eval<S>(a, b), right.template eval<S>(a, b));
+  }
+  /** @brief Evaluates the expression for dimensions of a shape of any type */
+  double eval(ShapeType t, double a, double b) const { return Op()(left.eval(t, a, b), right.eval(t, a, b)); }
+};
+
+/** @brief Creates expression for shape's area */
+inline Area area(void) { return Area(); }
+/** @brief Creates expression for shape's perimeter */
+inline Perimeter perimeter(void) { return Perimeter(); }
+/** @brief Creates expression for shape's volume */
+inline Volume volume(void) { return Volume(); }
+/** @brief Creates constant expression */
+inline Constant constant(double v) { return Constant(v); }
+
+#define GEO_METRIC_OPERATOR(op, func)                                              \
+  template <class L, class R>                                                      \
+  Binary<L, R, func<double> > operator op(const Expression<L> & l,                 \
+                                          const Expression<R> & r) {               \
+    return Binary<L, R, func<double> >(l.self(), r.self());                        \
+  }                                                                                \
+  template <class L>                                                               \
+  Binary<L, Constant, func<double> > operator op(const Expression<L> & l, double r) { \
+    return Binary<L, Constant, func<double> >(l.self(), Constant(r));              \
+  }                                                                                \
+  template <class R>                                                               \
+  Binary<Constant, R, func<double> > operator op(double l, const Expression<R> & r) { \
+    return Binary<Constant, R, func<double> >(Constant(l), r.self());              \
+  }
+
+GEO_METRIC_OPERATOR(+, std::plus)
+GEO_METRIC_OPERATOR(-, std::minus)
+GEO_METRIC_OPERATOR(*, std::multiplies)
+GEO_METRIC_OPERATOR(/, std::divides)
+
+#undef GEO_METRIC_OPERATOR
+
+}
+
+/**
+ * @brief Evaluates an expression for each shape of a range
+ * @param shapes Range of shapes
+ * @param e Metric expression (e.g. <code>area() / perimeter()</code>)
+ * @param out Output iterator receiving the results in order
+ * @return Output iterator past the last written result
+ */
+template <class Range, class E, class OutputIt>
+OutputIt compute(Range & shapes, const Metric::Expression<E> & e, OutputIt out) {
+  const E & expr = e.self();
+  for (auto & s : shapes)
+    *out++ = expr(s);
+  return out;
+}
+
+/**
+ * @brief Evaluates several expressions for each shape in a single pass
+ * @param shapes Range of shapes
+ * @param e Metric expressions
+ * @return One vector of results per expression
+ */
+template <class Range, class ... E>
+std::array<std::vector<double>, sizeof...(E)>
+computeAll(Range & shapes, const Metric::Expression<E> & ... e) {
+  std::array<std::vector<double>, sizeof...(E)> res;
+  for (auto & s : shapes) {
+    std::size_t i = 0;
+    ((res[i++].push_back(e.self()(s))), ...);
+  }
+  return res;
+}
+
+}
+
+#endif
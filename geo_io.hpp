@@ -0,0 +1,290 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_io.hpp
+ * Binary columnar file format for shape stores. A file starts with a header
+ * followed by the columns of the store one after another: shape types as
+ * bytes (padded to 8 bytes) and then X, Y, Z, A and B as arrays of doubles
+ * in native byte order. Since offsets of all columns are known from the
+ * number of shapes, rows could be written and read in parallel by ranges.
+ */
+
+#ifndef GEO_IO_HPP
+#define GEO_IO_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "geo_store.hpp"
+
+namespace Geo {
+
+/** @brief Header of binary shape file */
+struct ShapeFileHeader {
+  /** @brief Magic bytes "GEOX" */
+  char magic[4];
+  /** @brief Format version */
+  std::uint32_t version;
+  /** @brief Number of shapes */
+  std::uint64_t count;
+
+  /** @brief Current format version */
+  static constexpr std::uint32_t current_version = 1;
+};
+
+static_assert(sizeof(ShapeFileHeader) == 16, "Unexpected shape file header size");
+
+/**
+ * @brief Binary shape file opened for reading or writing by row ranges
+ *
+ * Methods throw std::runtime_error on I/O errors and invalid files.
+ */
+class ShapeFile {
+private:
+  int fd;
+  std::uint64_t count;
+
+  static void fail(const std::string & what, const std::string & path) {
+    throw std::runtime_error("Geo::ShapeFile: " + what + " '" + path + "': " + std::strerror(errno));
+  }
+
+  void pwriteAll(const void * buf, std::size_t len, std::uint64_t off) const {
+    const char * p = static_cast<const char *>(buf);
+    while (len > 0) {
+      const ssize_t w = ::pwrite(fd, p, len, off_t(off));
+      if (w < 0) {
+        if (errno == EINTR)
+          continue;
+        throw std::runtime_error(std::string("Geo::ShapeFile: write failed: ") + std::strerror(errno));
+      }
+      p += w;
+      len -= std::size_t(w);
+      off += std::uint64_t(w);
+    }
+  }
+
+  void preadAll(void * buf, std::size_t len, std::uint64_t off) const {
+    char * p = static_cast<char *>(buf);
+    while (len > 0) {
+      const ssize_t r = ::pread(fd, p, len, off_t(off));
+      if (r < 0 && errno == EINTR)
+        continue;
+      if (r <= 0)
+        throw std::runtime_error("Geo::ShapeFile: read failed or file truncated");
+      p += r;
+      len -= std::size_t(r);
+      off += std::uint64_t(r);
+    }
+  }
+
+  ShapeFile(int f, std::uint64_t n) : fd(f), count(n) {}
+
+public:
+  /** @brief Number of bytes of a shape row (type and numeric columns) */
+  static constexpr std::uint64_t row_bytes = 1 + ShapeStore::column_count * sizeof(double);
+
+  /**
+   * @brief Retrieves offset of the types column
+   */
+  static constexpr std::uint64_t typesOffset(void) { return sizeof(ShapeFileHeader); }
+
+  /**
+   * @brief Retrieves offset of a numeric column
+   * @param c Column
+   * @param n Number of shapes in the file
+   */
+  static constexpr std::uint64_t columnOffset(ShapeStore::Column c, std::uint64_t n) {
+    return typesOffset() + (n + 7) / 8 * 8 + std::uint64_t(c) * n * sizeof(double);
+  }
+
+  /** @brief Retrieves size of file with given number of shapes */
+  static constexpr std::uint64_t fileSize(std::uint64_t n) {
+    return columnOffset(ShapeStore::Column(ShapeStore::column_count), n);
+  }
+
+  /**
+   * @brief Creates file for given number of shapes
+   *
+   * The file is allocated to its full size, so rows could be written by
+   * ranges from several threads with write(). The file is removed again,
+   * if it cannot be allocated.
+   * @param path File path
+   * @param n Number of shapes
+   */
+  static ShapeFile create(const std::string & path, std::uint64_t n) {
+    const int f = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (f < 0)
+      fail("cannot create", path);
+    ShapeFile sf(f, n);
+    ShapeFileHeader h;
+    std::memcpy(h.magic, "GEOX", 4);
+    h.version = ShapeFileHeader::current_version;
+    h.count = n;
+    if (::ftruncate(f, off_t(fileSize(n))) != 0) {
+      const int e = errno;
+      ::unlink(path.c_str());
+      errno = e;
+      fail("cannot allocate", path);
+    }
+    sf.pwriteAll(&h, sizeof(h), 0);
+    return sf;
+  }
+
+  /**
+   * @brief Opens existing file
+   * @param path File path
+   * @param writable Whether rows would be written
+   */
+  static ShapeFile open(const std::string & path, bool writable = false) {
+    const int f = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (f < 0)
+      fail("cannot open", path);
+    ShapeFile sf(f, 0);
+    ShapeFileHeader h;
+    sf.preadAll(&h, sizeof(h), 0);
+    if (std::memcmp(h.magic, "GEOX", 4) != 0 || h.version != ShapeFileHeader::current_version)
+      throw std::runtime_error("Geo::ShapeFile: not a shape file '" + path + "'");
+    struct stat st;
+    if (::fstat(f, &st) != 0)
+      fail("cannot stat", path);
+    // Bound the count by the file size first, so fileSize() does not overflow
+    if (h.count > std::uint64_t(st.st_size) / row_bytes ||
+        std::uint64_t(st.st_size) < fileSize(h.count))
+      throw std::runtime_error("Geo::ShapeFile: truncated shape file '" + path + "'");
+    sf.count = h.count;
+    return sf;
+  }
+
+  ShapeFile(const ShapeFile &) = delete;
+  ShapeFile & operator=(const ShapeFile &) = delete;
+  /** @brief Move constructor */
+  ShapeFile(ShapeFile && o) : fd(o.fd), count(o.count) { o.fd = -1; }
+
+  /** @brief Closes the file */
+  ~ShapeFile() {
+    if (fd >= 0)
+      ::close(fd);
+  }
+
+  /** @brief Retrieves number of shapes in the file */
+  std::uint64_t size(void) const { return count; }
+
+  /**
+   * @brief Writes range of rows
+   *
+   * Safe to call concurrently for disjoint ranges.
+   * @param first First row
+   * @param n Number of rows
+   * @param t Shape types
+   * @param v Arrays with values of each column in order X, Y, Z, A and B
+   */
+  void write(std::uint64_t first, std::size_t n, const ShapeType * t, const double * const * v) const {
+    pwriteAll(t, n, typesOffset() + first);
+    for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+      pwriteAll(v[c], n * sizeof(double), columnOffset(ShapeStore::Column(c), count) + first * sizeof(double));
+  }
+
+  /**
+   * @brief Reads range of rows
+   *
+   * Safe to call concurrently. Throws std::runtime_error on bytes, which
+   * are not shape types, so corrupt files never index tables by type.
+   * @param first First row
+   * @param n Number of rows
+   * @param t Output array for n shape types
+   * @param v Output arrays for n values of each column
+   */
+  void read(std::uint64_t first, std::size_t n, ShapeType * t, double * const * v) const {
+    preadAll(t, n, typesOffset() + first);
+    const unsigned char * b = reinterpret_cast<const unsigned char *>(t);
+    unsigned char top = 0;
+    for (std::size_t i = 0; i < n; ++i)
+      top = std::max(top, b[i]);
+    if (n > 0 && top >= shape_type_count)
+      throw std::runtime_error("Geo::ShapeFile: invalid shape type " + std::to_string(unsigned(top)) +
+                               " in rows from " + std::to_string(first));
+    for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+      preadAll(v[c], n * sizeof(double), columnOffset(ShapeStore::Column(c), count) + first * sizeof(double));
+  }
+
+  /**
+   * @brief Reads range of rows and appends them to a store
+   * @param first First row
+   * @param n Number of rows
+   * @param store Shape store
+   */
+  void read(std::uint64_t first, std::size_t n, ShapeStore & store) const {
+    /* Read through bounded buffers, so loading needs little extra memory */
+    const std::size_t chunk = std::min<std::size_t>(n, 1u << 20);
+    std::vector<ShapeType> t(chunk);
+    std::vector<double> buf(chunk * ShapeStore::column_count);
+    double * v[ShapeStore::column_count];
+    for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+      v[c] = buf.data() + c * chunk;
+    for (std::size_t done = 0; done < n; ) {
+      const std::size_t k = std::min(chunk, n - done);
+      read(first + done, k, t.data(), v);
+      store.append(k, t.data(), v);
+      done += k;
+    }
+  }
+};
+
+/**
+ * @brief Saves store to binary shape file
+ * @param store Shape store
+ * @param path File path
+ */
+inline void saveStore(const ShapeStore & store, const std::string & path) {
+  ShapeFile f = ShapeFile::create(path, store.size());
+  const double * v[ShapeStore::column_count];
+  for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+    v[c] = store.column(ShapeStore::Column(c));
+  f.write(0, store.size(), store.types(), v);
+}
+
+/**
+ * @brief Loads store from binary shape file
+ * @param path File path
+ * @param block_size Number of rows in a block of the store
+ * @param hp Huge page policy for memory of the store
+ * @return Shape store with all shapes from the file
+ */
+inline ShapeStore loadStore(const std::string & path, std::size_t block_size = ShapeStore::default_block_size,
+                            HugePages hp = HugePages::None) {
+  ShapeFile f = ShapeFile::open(path);
+  ShapeStore store(block_size, hp);
+  store.reserve(f.size());
+  f.read(0, f.size(), store);
+  return store;
+}
+
+}
+
+#endif
@@ -0,0 +1,180 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_kernels.hpp
+ * Batch kernels calculating a measure for many shapes of the same type.
+ * Kernels are instantiated at compile time for every combination of measure,
+ * shape type, precision and storage layout, so each one is a loop without
+ * branches. A dispatch table of all of them is built once on first use.
+ */
+
+#ifndef GEO_KERNELS_HPP
+#define GEO_KERNELS_HPP
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+#include "geo_store.hpp"
+
+namespace Geo {
+
+/** @brief Storage layouts of shapes' dimensions */
+enum class Layout {
+  /** Separate arrays for dimensions A and B */
+  Columnar,
+  /** One array with pairs of dimensions A and B */
+  Interleaved
+};
+
+/** @brief Number of layouts */
+constexpr unsigned layout_count = 2;
+
+/**
+ * @brief Input of a batch kernel
+ *
+ * For columnar layout a and b point to arrays of dimensions A and B (b could
+ * be null for shapes without dimension B). For interleaved layout a points
+ * to pairs of dimensions and b is not used.
+ */
+template <class T>
+struct Batch {
+  /** @brief Dimensions A or interleaved pairs of dimensions */
+  const T * a;
+  /** @brief Dimensions B for columnar layout */
+  const T * b;
+  /** @brief Number of shapes */
+  std::size_t n;
+};
+
+/** @brief Batch kernel calculating measures into output array */
+template <class T>
+using KernelFn = void (*)(const Batch<T> & in, T * out);
+
+/**
+ * @brief Calculates measure of a shape of type known at compile time
+ * @param a Radius, width, side or edge
+ * @param b Height for rectangles
+ */
+template <Measure M, ShapeType S, class T>
+constexpr T formula(T a, T b) {
+  if constexpr (M == Measure::Area) {
+    if constexpr (S == ShapeType::Circle)         return Formula::circleArea(a);
+    else if constexpr (S == ShapeType::Rectangle) return Formula::rectangleArea(a, b);
+    else if constexpr (S == ShapeType::Square)    return Formula::squareArea(a);
+    else if constexpr (S == ShapeType::Sphere)    return Formula::sphereArea(a);
+    else                                          return Formula::cubeArea(a);
+  } else if constexpr (M == Measure::Perimeter) {
+    if constexpr (S == ShapeType::Circle || S == ShapeType::Sphere)
+      return Formula::circlePerimeter(a);
+    else if constexpr (S == ShapeType::Rectangle) return Formula::rectanglePerimeter(a, b);
+    else if constexpr (S == ShapeType::Square)    return Formula::squarePerimeter(a);
+    else                                          return T(0);
+  } else {
+    if constexpr (S == ShapeType::Sphere)         return Formula::sphereVolume(a);
+    else if constexpr (S == ShapeType::Cube)      return Formula::cubeVolume(a);
+    else                                          return T(0);
+  }
+}
+
+/** @brief Checks whether a measure of a shape type depends on dimension B */
+constexpr bool usesB(Measure m, ShapeType s) {
+  return s == ShapeType::Rectangle && m != Measure::Volume;
+}
+
+/**
+ * @brief Loop of a batch kernel
+ *
+ * Kept separate, so that kernels compiled for specific instruction sets
+ * could inline the same loop. Loops are marked for vectorization with
+ * OpenMP SIMD pragmas (enabled by -fopenmp-simd).
+ */
+template <Measure M, ShapeType S, class T, Layout L>
+inline __attribute__((always_inline)) void batchLoop(const Batch<T> & in, T * __restrict out) {
+  const T * __restrict a = in.a;
+  const T * __restrict b = in.b;
+  const std::size_t n = in.n;
+  if constexpr (L == Layout::Interleaved) {
+#pragma omp simd
+    for (std::size_t i = 0; i < n; ++i)
+      out[i] = formula<M, S, T>(a[2 * i], a[2 * i + 1]);
+  } else if constexpr (usesB(M, S)) {
+#pragma omp simd
+    for (std::size_t i = 0; i < n; ++i)
+      out[i] = formula<M, S, T>(a[i], b[i]);
+  } else {
+#pragma omp simd
+    for (std::size_t i = 0; i < n; ++i)
+      out[i] = formula<M, S, T>(a[i], T(0));
+  }
+}
+
+/**
+ * @brief Batch kernel specialized for measure, shape type, precision and layout
+ * @param in Input dimensions
+ * @param out Output array for in.n measures
+ */
+template <Measure M, ShapeType S, class T, Layout L>
+void batchKernel(const Batch<T> & in, T * out) {
+  batchLoop<M, S, T, L>(in, out);
+}
+
+namespace detail {
+
+constexpr std::size_t kernel_count = measure_count * shape_type_count * layout_count;
+
+constexpr std::size_t kernelIndex(Measure m, ShapeType s, Layout l) {
+  return (std::size_t(m) * shape_type_count + std::size_t(s)) * layout_count + std::size_t(l);
+}
+
+template <class T, template <Measure, ShapeType, class, Layout> class K, std::size_t ... I>
+std::array<KernelFn<T>, sizeof...(I)> kernelTable(std::index_sequence<I...>) {
+  return {{ &K<Measure(I / (shape_type_count * layout_count)),
+               ShapeType(I / layout_count % shape_type_count),
+               T,
+               Layout(I % layout_count)>::run... }};
+}
+
+template <Measure M, ShapeType S, class T, Layout L>
+struct GenericKernel {
+  static void run(const Batch<T> & in, T * out) { batchKernel<M, S, T, L>(in, out); }
+};
+
+}
+
+/**
+ * @brief Selects specialized batch kernel
+ *
+ * The table of kernels for the precision is built once on first call.
+ * @param m Measure
+ * @param s Shape type
+ * @param l Storage layout
+ * @return Kernel for the combination (e.g. float Sphere volume over
+ * interleaved storage)
+ */
+template <class T>
+KernelFn<T> kernel(Measure m, ShapeType s, Layout l) {
+  static const std::array<KernelFn<T>, detail::kernel_count> table =
+    detail::kernelTable<T, detail::GenericKernel>(std::make_index_sequence<detail::kernel_count>());
+  return table[detail::kernelIndex(m, s, l)];
+}
+
+}
+
+#endif
@@ -0,0 +1,294 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_memory.hpp
+ * Allocation of large arrays backed by huge pages. Large allocations are
+ * mapped directly and either advised for transparent huge pages or mapped
+ * from explicit 2 MB or 1 GB hugetlbfs pages. When explicit pages are not
+ * available the allocation falls back to transparent huge pages and then
+ * to normal pages, so it never fails because of the policy. Small
+ * allocations always use the heap.
+ */
+
+#ifndef GEO_MEMORY_HPP
+#define GEO_MEMORY_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace Geo {
+
+/** @brief Huge page policies of allocations */
+enum class HugePages {
+  /** @brief Normal pages */
+  None,
+  /** @brief Transparent huge pages (madvise) */
+  Transparent,
+  /** @brief Explicit 2 MB hugetlbfs pages */
+  Explicit2M,
+  /** @brief Explicit 1 GB hugetlbfs pages */
+  Explicit1G
+};
+
+/** @brief Retrieves name of huge page policy */
+inline const char * hugePagesName(HugePages h) {
+  static const char * const names[] = { "none", "thp", "2m", "1g" };
+  return names[unsigned(h)];
+}
+
+/** @brief Counters of huge page allocations in the process */
+struct HugePageStats {
+  /** @brief Bytes currently mapped from explicit hugetlbfs pages */
+  std::atomic<std::size_t> explicit_bytes;
+  /** @brief Bytes currently mapped for transparent huge pages */
+  std::atomic<std::size_t> advised_bytes;
+  /** @brief Number of allocations, which fell back from the requested policy */
+  std::atomic<std::size_t> fallbacks;
+};
+
+/** @brief Retrieves counters of huge page allocations */
+inline HugePageStats & hugePageStats(void) {
+  static HugePageStats stats { { 0 }, { 0 }, { 0 } };
+  return stats;
+}
+
+/**
+ * @brief Retrieves number of bytes in a range, which are backed by huge pages
+ *
+ * Read from /proc/self/smaps, so it shows whether the kernel actually used
+ * huge pages, which is not guaranteed for transparent ones.
+ * @param p Start of the range
+ * @param len Length of the range in bytes
+ */
+inline std::size_t hugePageBytes(const void * p, std::size_t len) {
+  std::size_t total = 0;
+#ifdef __linux__
+  std::FILE * f = std::fopen("/proc/self/smaps", "r");
+  if (!f)
+    return 0;
+  const std::uintptr_t lo = std::uintptr_t(p), hi = lo + len;
+  std::size_t overlap = 0;
+  char line[512];
+  while (std::fgets(line, sizeof(line), f)) {
+    unsigned long start, end, kb;
+    char key[64];
+    if (std::sscanf(line, "%lx-%lx ", &start, &end) == 2 && std::strchr(line, ':') > std::strchr(line, ' ')) {
+      /* Mapping header; huge pages are counted only within the range */
+      overlap = start < hi && lo < end ? std::min<std::uintptr_t>(end, hi) - std::max<std::uintptr_t>(start, lo) : 0;
+    } else if (overlap && std::sscanf(line, "%63[^:]: %lu kB", key, &kb) == 2 &&
+               (!std::strcmp(key, "AnonHugePages") || !std::strcmp(key, "Private_Hugetlb") ||
+                !std::strcmp(key, "Shared_Hugetlb")))
+      total += std::min<std::size_t>(kb * 1024, overlap);
+  }
+  std::fclose(f);
+#else
+  (void)p; (void)len;
+#endif
+  return total;
+}
+
+namespace detail {
+
+/** @brief Allocations of at least this size are mapped and could use huge
+ * pages, so releases of smaller ones need no lookup of their mapping */
+constexpr std::size_t huge_page_threshold = std::size_t(2) << 20;
+
+inline std::size_t hugePageSize(HugePages h, std::size_t bytes) {
+  return h == HugePages::Explicit1G && bytes >= (std::size_t(1) << 30) ? std::size_t(1) << 30
+                                                                        : std::size_t(2) << 20;
+}
+
+inline std::size_t mappedLength(HugePages h, std::size_t bytes) {
+  const std::size_t page = hugePageSize(h, bytes);
+  return (bytes + page - 1) / page * page;
+}
+
+#ifdef __linux__
+/* Maps length aligned to 2 MB, so transparent huge pages could be used for all of it */
+inline void * mapAligned(std::size_t len) {
+  const std::size_t align = std::size_t(2) << 20;
+  void * m = mmap(nullptr, len + align, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (m == MAP_FAILED)
+    return nullptr;
+  const std::uintptr_t b = std::uintptr_t(m), a = (b + align - 1) / align * align;
+  if (a > b)
+    munmap(m, a - b);
+  if (b + align > a)
+    munmap(reinterpret_cast<void *>(a + len), b + align - a);
+  return reinterpret_cast<void *>(a);
+}
+#endif
+
+/** @brief Mapped allocation */
+struct Mapping {
+  std::size_t length;
+  /* Counter of the pages in HugePageStats or null for normal pages */
+  std::atomic<std::size_t> * stat;
+};
+
+/** @brief Mapped allocations by address, so they could be released with the right length */
+struct Mappings {
+  std::mutex mutex;
+  std::unordered_map<void *, Mapping> map;
+};
+
+inline Mappings & mappings(void) {
+  static Mappings m;
+  return m;
+}
+
+/**
+ * @brief Allocates memory with huge page policy
+ * @param h Huge page policy
+ * @param bytes Size in bytes
+ * @return Memory (throws std::bad_alloc on failure)
+ */
+inline void * allocatePages(HugePages h, std::size_t bytes) {
+#ifdef __linux__
+  if (bytes >= huge_page_threshold) {
+    HugePageStats & stats = hugePageStats();
+    const std::size_t len = mappedLength(h, bytes);
+    void * m = nullptr;
+    bool explicit_pages = false;
+    if (h == HugePages::Explicit2M || h == HugePages::Explicit1G) {
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+      const int size_flag = hugePageSize(h, bytes) == (std::size_t(1) << 30) ? (30 << MAP_HUGE_SHIFT)
+                                                                            : (21 << MAP_HUGE_SHIFT);
+      m = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | size_flag, -1, 0);
+      if (m == MAP_FAILED)
+        m = nullptr;
+#endif
+      explicit_pages = m != nullptr;
+      if (!m)
+        ++stats.fallbacks;
+    }
+    if (!m) {
+      m = mapAligned(len);
+      if (!m)
+        throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+      if (h != HugePages::None && madvise(m, len, MADV_HUGEPAGE) != 0)
+        ++stats.fallbacks;
+#endif
+    }
+    std::atomic<std::size_t> * stat = explicit_pages ? &stats.explicit_bytes
+                                    : h != HugePages::None ? &stats.advised_bytes : nullptr;
+    if (stat)
+      *stat += len;
+    Mappings & ms = mappings();
+    std::lock_guard<std::mutex> lock(ms.mutex);
+    ms.map[m] = Mapping { len, stat };
+    return m;
+  }
+#else
+  (void)h;
+#endif
+  return ::operator new(bytes);
+}
+
+/**
+ * @brief Releases memory allocated by allocatePages
+ * @param p Memory
+ * @param bytes Size in bytes given to allocatePages
+ */
+inline void deallocatePages(void * p, std::size_t bytes) {
+#ifdef __linux__
+  if (!p)
+    return;
+  if (bytes >= huge_page_threshold) {
+    Mappings & ms = mappings();
+    std::unique_lock<std::mutex> lock(ms.mutex);
+    const auto it = ms.map.find(p);
+    const Mapping m = it->second;
+    ms.map.erase(it);
+    lock.unlock();
+    if (m.stat)
+      *m.stat -= m.length;
+    munmap(p, m.length);
+    return;
+  }
+#else
+  (void)bytes;
+#endif
+  ::operator delete(p);
+}
+
+}
+
+/**
+ * @brief Standard allocator with huge page policy
+ *
+ * Suitable for containers of large arrays, e.g. columns of stores. Memory
+ * allocated with any policy could be released by any allocator, so all of
+ * them compare equal.
+ */
+template <class T>
+class PageAllocator {
+private:
+  HugePages policy;
+
+  template <class U> friend class PageAllocator;
+
+public:
+  typedef T value_type;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+
+  /**
+   * @brief Construct allocator
+   * @param h Huge page policy
+   */
+  PageAllocator(HugePages h = HugePages::None) noexcept : policy(h) {}
+  /** @brief Construct allocator with the policy of another one */
+  template <class U>
+  PageAllocator(const PageAllocator<U> & o) noexcept : policy(o.policy) {}
+
+  /** @brief Retrieves huge page policy */
+  HugePages hugePages(void) const { return policy; }
+
+  /** @brief Allocates memory for n objects */
+  T * allocate(std::size_t n) {
+    return static_cast<T *>(detail::allocatePages(policy, n * sizeof(T)));
+  }
+  /** @brief Releases memory for n objects */
+  void deallocate(T * p, std::size_t n) noexcept {
+    detail::deallocatePages(p, n * sizeof(T));
+  }
+
+  template <class U>
+  bool operator==(const PageAllocator<U> &) const { return true; }
+  template <class U>
+  bool operator!=(const PageAllocator<U> &) const { return false; }
+};
+
+}
+
+#endif
@@ -0,0 +1,500 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_montecarlo.hpp
+ * Monte Carlo estimation of volume and surface area of composite bodies,
+ * which are unions, intersections and differences of spheres and cubes.
+ * Points are quasi-random (Sobol) with random digital shifts, so several
+ * independent replicates give the error of the estimate and sampling stops
+ * once it's small enough. The bounding box of the body is split in cells,
+ * which keep only the spheres and cubes that could contain their points,
+ * found in a bounding volume hierarchy. The terms of each cell are run as
+ * a CSG tape (see geo_csg.hpp) over batches of points.
+ */
+
+#ifndef GEO_MONTECARLO_HPP
+#define GEO_MONTECARLO_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "geo_cache.hpp"
+#include "geo_csg.hpp"
+#include "geo_ray.hpp"
+
+namespace Geo {
+
+/**
+ * @brief Body composed of spheres and cubes
+ *
+ * Terms are applied from the first to the last one to an initially empty
+ * body, so the body is \f$((\emptyset \circ_1 s_1) \circ_2 s_2) \ldots\f$.
+ * Points on the surface of a term belong to it.
+ */
+class CompositeBody {
+public:
+  /** @brief Sphere or cube with the operation applying it */
+  struct Term : CsgPrimitive<3> {
+    /** @brief Union, Intersection or Difference */
+    CsgCode op;
+  };
+
+private:
+  std::vector<Term> body;
+
+  CompositeBody & add(CsgCode op, const CsgPrimitive<3> & p) {
+    if (op != CsgCode::Union && op != CsgCode::Intersection && op != CsgCode::Difference)
+      throw std::invalid_argument("Composite bodies apply terms by union, intersection or difference");
+    body.push_back(Term { p, op });
+    return *this;
+  }
+
+public:
+  /**
+   * @brief Applies a sphere
+   * @param op Union, Intersection or Difference
+   * @param s Sphere
+   * @return The body
+   */
+  CompositeBody & add(CsgCode op, Sphere s) {
+    const Coord3D & c = s.getRefPoint();
+    const double r = s.getRadius();
+    return add(op, CsgPrimitive<3> { true, { c.getX() - r, c.getY() - r, c.getZ() - r },
+                                     { c.getX() + r, c.getY() + r, c.getZ() + r }, { c.getX(), c.getY(), c.getZ() }, r });
+  }
+  /**
+   * @brief Applies a cube
+   * @param op Union, Intersection or Difference
+   * @param c Cube
+   * @return The body
+   */
+  CompositeBody & add(CsgCode op, Cube c) {
+    const BoundingBox3D b = c.boundingBox();
+    return add(op, CsgPrimitive<3> { false, { b.min.getX(), b.min.getY(), b.min.getZ() },
+                                     { b.max.getX(), b.max.getY(), b.max.getZ() }, { 0, 0, 0 }, 0 });
+  }
+  /** @brief Adds a sphere or a cube to the body */
+  template <class S> CompositeBody & unite(S s) { return add(CsgCode::Union, s); }
+  /** @brief Intersects the body with a sphere or a cube */
+  template <class S> CompositeBody & intersect(S s) { return add(CsgCode::Intersection, s); }
+  /** @brief Subtracts a sphere or a cube from the body */
+  template <class S> CompositeBody & subtract(S s) { return add(CsgCode::Difference, s); }
+
+  /** @brief Retrieves the terms in order of application */
+  const std::vector<Term> & terms(void) const { return body; }
+  /** @brief Retrieves number of terms */
+  std::size_t size(void) const { return body.size(); }
+
+  /**
+   * @brief Checks whether a point is in the body
+   * @param p Point
+   */
+  bool contains(const Coord3D & p) const {
+    const double q[3] = { p.getX(), p.getY(), p.getZ() };
+    bool in = false;
+    for (const Term & t : body) {
+      const bool s = t.contains(q);
+      in = t.op == CsgCode::Union ? in || s : (t.op == CsgCode::Intersection ? in && s : in && !s);
+    }
+    return in;
+  }
+
+  /**
+   * @brief Calculates a box containing the body
+   *
+   * Unions extend the box and intersections clip it, while differences do
+   * not change it. The box is not necessarily the smallest one.
+   * @return Box, with minimum above maximum when the body is empty
+   */
+  BoundingBox3D boundingBox(void) const {
+    double lo[3], hi[3];
+    for (unsigned k = 0; k < 3; ++k) {
+      lo[k] = std::numeric_limits<double>::infinity();
+      hi[k] = -std::numeric_limits<double>::infinity();
+    }
+    for (const Term & t : body)
+      for (unsigned k = 0; k < 3; ++k)
+        if (t.op == CsgCode::Union) {
+          lo[k] = std::min(lo[k], t.lo[k]);
+          hi[k] = std::max(hi[k], t.hi[k]);
+        } else if (t.op == CsgCode::Intersection) {
+          lo[k] = std::max(lo[k], t.lo[k]);
+          hi[k] = std::min(hi[k], t.hi[k]);
+        }
+    return BoundingBox3D { Coord3D(lo[0], lo[1], lo[2]), Coord3D(hi[0], hi[1], hi[2]) };
+  }
+
+  /**
+   * @brief Converts the body to a CSG tree
+   *
+   * Terms before the first union leave the body empty and are dropped, and
+   * every next term combines the previous root with its sphere or cube.
+   */
+  CsgTree3D tree(void) const {
+    CsgTree3D t;
+    std::size_t i = 0;
+    while (i < body.size() && body[i].op != CsgCode::Union)
+      ++i;
+    if (i == body.size())
+      return t;
+    CsgTree3D::Node root = t.add(body[i++]);
+    for (; i < body.size(); ++i) {
+      const CsgTree3D::Node n = t.add(body[i]);
+      root = body[i].op == CsgCode::Union ? t.unite(root, n)
+             : (body[i].op == CsgCode::Intersection ? t.intersect(root, n) : t.subtract(root, n));
+    }
+    return t;
+  }
+};
+
+namespace detail {
+
+/* Direction numbers of the first five dimensions of the Sobol sequence
+ * (primitive polynomials and initial numbers of Joe and Kuo) */
+constexpr unsigned sobol_dims = 5;
+constexpr unsigned sobol_block = 256;
+
+struct SobolDirections {
+  std::uint32_t v[sobol_dims][32];
+  /* Points of the indices below sobol_block in Gray code order. As Gray
+   * code is linear, a point of any index is the point of its high bits
+   * xor the one of its low bits, with no chain from point to point. */
+  std::uint32_t low[sobol_dims][sobol_block];
+
+  SobolDirections() {
+    static const unsigned s[sobol_dims] = { 0, 1, 2, 3, 3 };
+    static const unsigned a[sobol_dims] = { 0, 0, 1, 1, 2 };
+    static const std::uint32_t m[sobol_dims][3] = { { 1, 0, 0 }, { 1, 0, 0 }, { 1, 3, 0 }, { 1, 3, 1 }, { 1, 1, 1 } };
+    for (unsigned k = 0; k < 32; ++k)
+      v[0][k] = std::uint32_t(1) << (31 - k);
+    for (unsigned d = 1; d < sobol_dims; ++d)
+      for (unsigned k = 0; k < 32; ++k) {
+        if (k < s[d]) {
+          v[d][k] = m[d][k] << (31 - k);
+          continue;
+        }
+        v[d][k] = v[d][k - s[d]] ^ (v[d][k - s[d]] >> s[d]);
+        for (unsigned j = 1; j < s[d]; ++j)
+          if ((a[d] >> (s[d] - 1 - j)) & 1)
+            v[d][k] ^= v[d][k - j];
+      }
+    for (unsigned d = 0; d < sobol_dims; ++d)
+      for (unsigned i = 0; i < sobol_block; ++i)
+        low[d][i] = point(d, i);
+  }
+
+  std::uint32_t point(unsigned d, std::uint64_t index) const {
+    const std::uint64_t gray = index ^ (index >> 1);
+    std::uint32_t x = 0;
+    for (unsigned b = 0; b < 32; ++b)
+      if ((gray >> b) & 1)
+        x ^= v[d][b];
+    return x;
+  }
+};
+
+inline const SobolDirections & sobolDirections(void) {
+  static const SobolDirections dirs;
+  return dirs;
+}
+
+/* Cosine and sine of the angle of a fraction u of a full turn, u in [0, 1).
+ * The angle is reduced to a quarter turn by selects, so loops over it
+ * vectorize. Accurate to about 1e-11, ample for directions of segments. */
+inline void sincosTurn(double u, double & c, double & s) {
+  constexpr double pi = 3.14159265358979323846;
+  const double phi = 2 * pi * u - pi;
+  const double q = double(phi > pi / 4) + double(phi > 3 * pi / 4) - double(phi < -pi / 4) - double(phi < -3 * pi / 4);
+  const double r = phi - q * (pi / 2), r2 = r * r;
+  const double sr = r * (1 + r2 * (-1.0 / 6 + r2 * (1.0 / 120 + r2 * (-1.0 / 5040 + r2 * (1.0 / 362880 + r2 * (-1.0 / 39916800))))));
+  const double cr = 1 + r2 * (-0.5 + r2 * (1.0 / 24 + r2 * (-1.0 / 720 + r2 * (1.0 / 40320 + r2 * (-1.0 / 3628800 + r2 * (1.0 / 479001600))))));
+  c = q == 0 ? cr : q == 1 ? -sr : q == -1 ? sr : -cr;
+  s = q == 0 ? sr : q == 1 ? cr : q == -1 ? -cr : -sr;
+}
+
+/* Counter-based random numbers: the value depends only on the seed, the
+ * stream and the counter, so any thread could draw any of them */
+inline std::uint64_t counterRandom(std::uint64_t seed, std::uint64_t stream, std::uint64_t counter) {
+  return avalanche(avalanche(seed + hash_p1 * (stream + 1)) ^ (hash_p2 * (counter + 1)));
+}
+
+}
+
+/** @brief Options of Monte Carlo estimation */
+struct EstimateOptions {
+  /** @brief Relative standard error of volume, below which sampling stops */
+  double tolerance = 1e-3;
+  /** @brief Whether to estimate surface area too */
+  bool area = true;
+  /** @brief Relative standard error of surface area, below which sampling stops */
+  double area_tolerance = 1e-2;
+  /** @brief Length of segments for surface area (zero for 1e-3 of the smallest sphere or cube) */
+  double epsilon = 0;
+  /** @brief Maximal number of points, after which sampling stops */
+  std::uint64_t max_points = std::uint64_t(1) << 26;
+  /** @brief Number of independent replicates (at least 2) */
+  unsigned replicates = 8;
+  /** @brief Number of cells along the longest side of the body's box */
+  unsigned cells = 16;
+  /** @brief Number of threads (0 for the number of processors) */
+  unsigned threads = 0;
+  /** @brief Seed of random digital shifts */
+  std::uint64_t seed = 0;
+};
+
+/** @brief Result of Monte Carlo estimation */
+struct VolumeEstimate {
+  /** @brief Estimated volume */
+  double volume;
+  /** @brief Standard error of the volume */
+  double volume_error;
+  /** @brief Estimated surface area (zero when not estimated) */
+  double area;
+  /** @brief Standard error of the surface area */
+  double area_error;
+  /** @brief Number of points sampled */
+  std::uint64_t points;
+  /** @brief Whether the errors are within the tolerance */
+  bool converged;
+};
+
+/**
+ * @brief Estimates volume and surface area of a composite body
+ *
+ * Each cell of the box of the body keeps the terms which boxes overlap it.
+ * Cells where no union term is left after the last intersection term they
+ * miss are empty and not sampled. Every cell is sampled by a Sobol sequence
+ * with a digital shift of each replicate, drawn from counter-based streams
+ * of the cell and the replicate, so the result depends on the seed and not
+ * on the number of threads. Sampling goes in rounds, which double the points,
+ * until the standard error of the mean of the replicates is within the
+ * tolerance or the maximal number of points is reached.
+ *
+ * Surface area is estimated from segments of length \f$\varepsilon\f$ in
+ * random directions: the fraction of them with ends on both sides of the
+ * surface times the volume is \f$S \varepsilon / 2\f$. Features thinner
+ * than \f$\varepsilon\f$ are underestimated.
+ * @param body Composite body
+ * @param opt Options
+ * @return Estimate
+ */
+inline VolumeEstimate estimateVolume(const CompositeBody & body, const EstimateOptions & opt = EstimateOptions()) {
+  VolumeEstimate est = { 0, 0, 0, 0, 0, true };
+  const std::vector<CompositeBody::Term> & terms = body.terms();
+  const BoundingBox3D box = body.boundingBox();
+  const double blo[3] = { box.min.getX(), box.min.getY(), box.min.getZ() };
+  const double bhi[3] = { box.max.getX(), box.max.getY(), box.max.getZ() };
+  if (!(blo[0] <= bhi[0] && blo[1] <= bhi[1] && blo[2] <= bhi[2]))
+    return est;
+
+  /* Segments starting within epsilon of the box could cross the surface,
+   * so the sampled domain is the box grown by epsilon */
+  double smallest = std::numeric_limits<double>::infinity();
+  for (const CompositeBody::Term & t : terms)
+    smallest = std::min(smallest, t.hi[0] - t.lo[0]);
+  const double eps = opt.area ? (opt.epsilon > 0 ? opt.epsilon : 1e-3 * smallest) : 0;
+  double lo[3], ext[3], size[3];
+  unsigned cells[3];
+  for (unsigned k = 0; k < 3; ++k) {
+    lo[k] = blo[k] - eps;
+    ext[k] = bhi[k] - blo[k] + 2 * eps;
+  }
+  const double longest = std::max({ ext[0], ext[1], ext[2] });
+  for (unsigned k = 0; k < 3; ++k) {
+    cells[k] = std::max(1u, unsigned(std::lround(std::max(opt.cells, 1u) * ext[k] / longest)));
+    size[k] = ext[k] / cells[k];
+  }
+  const double cell_volume = size[0] * size[1] * size[2];
+
+  /* The hierarchy only finds terms overlapping cells, so it gets the boxes
+   * of the terms */
+  detail::Bvh<3> bvh;
+  {
+    std::vector<detail::Bvh<3>::Prim> prims;
+    for (std::size_t i = 0; i < terms.size(); ++i) {
+      const CompositeBody::Term & t = terms[i];
+      prims.push_back(detail::Bvh<3>::Prim { { t.lo[0], t.lo[1], t.lo[2] }, { t.hi[0], t.hi[1], t.hi[2] },
+                                             0, false, std::uint32_t(i) });
+    }
+    bvh.build(std::move(prims), 4);
+  }
+
+  /* Tapes of the cells which could contain points of the body. Terms
+   * before the first union leave the body empty and each next one combines
+   * the body in slot 0 with its sphere or cube in slot 1. */
+  const std::vector<CsgPrimitive<3>> shapes(terms.begin(), terms.end());
+  std::vector<double> cell_lo[3];
+  std::vector<std::size_t> code_first(1, 0);
+  std::vector<CsgInstr> code;
+  std::vector<std::uint32_t> cand, ids;
+  std::vector<std::uint8_t> hit(terms.size(), 0);
+  for (unsigned i = 0; i < cells[0]; ++i)
+    for (unsigned j = 0; j < cells[1]; ++j)
+      for (unsigned k = 0; k < cells[2]; ++k) {
+        const double c[3] = { lo[0] + i * size[0], lo[1] + j * size[1], lo[2] + k * size[2] };
+        const double qlo[3] = { c[0] - eps, c[1] - eps, c[2] - eps };
+        const double qhi[3] = { c[0] + size[0] + eps, c[1] + size[1] + eps, c[2] + size[2] + eps };
+        cand.clear();
+        bvh.overlapping(qlo, qhi, [&](std::uint32_t id) { cand.push_back(id); hit[id] = 1; });
+        ids.clear();
+        for (std::size_t t = 0; t < terms.size(); ++t)
+          if (hit[t])
+            ids.push_back(std::uint32_t(t));
+          else if (terms[t].op == CsgCode::Intersection)
+            ids.clear();
+        for (std::uint32_t id : cand)
+          hit[id] = 0;
+        const std::size_t first = code.size();
+        for (std::uint32_t id : ids) {
+          const CsgCode shape = terms[id].round ? CsgCode::Ball : CsgCode::Box;
+          if (code.size() == first) {
+            if (terms[id].op == CsgCode::Union)
+              code.push_back(CsgInstr { shape, 0, id, 0 });
+            continue;
+          }
+          code.push_back(CsgInstr { shape, 1, id, 0 });
+          code.push_back(CsgInstr { terms[id].op, 0, 0, 0 });
+        }
+        if (code.size() == first)
+          continue;
+        code_first.push_back(code.size());
+        for (unsigned d = 0; d < 3; ++d)
+          cell_lo[d].push_back(c[d]);
+      }
+  const std::size_t active = code_first.size() - 1;
+  if (!active)
+    return est;
+
+  const unsigned reps = std::max(opt.replicates, 2u);
+  const std::size_t units = active * reps;
+  std::vector<std::uint64_t> inside(units, 0), cross(units, 0);
+  const CsgKernelFn<3> kernel = dispatchCsgKernel<3>();
+  const detail::SobolDirections & dirs = detail::sobolDirections();
+  unsigned threads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+  threads = unsigned(std::min<std::size_t>(threads, units));
+
+  /* Points [begin, end) of the sequence of a cell and a replicate */
+  const auto sample = [&](std::size_t unit, std::uint64_t begin, std::uint64_t end) {
+    static constexpr std::size_t chunk = detail::sobol_block;
+    const std::size_t cell = unit / reps;
+    const double clx = cell_lo[0][cell], cly = cell_lo[1][cell], clz = cell_lo[2][cell];
+    /* Shifts are applied with the sign bit flipped for signed conversion,
+     * which vectorizes on every level */
+    std::uint32_t shift[detail::sobol_dims];
+    for (unsigned d = 0; d < detail::sobol_dims; ++d)
+      shift[d] = std::uint32_t(detail::counterRandom(opt.seed, unit, d) >> 32) ^ 0x80000000u;
+    alignas(64) double px[chunk], py[chunk], pz[chunk], qx[chunk], qy[chunk], qz[chunk], vp[chunk], vq[chunk];
+    const double * const pp[3] = { px, py, pz };
+    const double * const qq[3] = { qx, qy, qz };
+    const CsgInstr * cp = code.data() + code_first[cell];
+    const std::size_t cm = code_first[cell + 1] - code_first[cell];
+    for (std::uint64_t s = begin; s < end; ) {
+      const std::size_t off = std::size_t(s % chunk);
+      const std::size_t n = std::size_t(std::min<std::uint64_t>(chunk - off, end - s));
+      std::uint32_t hi[detail::sobol_dims];
+      for (unsigned d = 0; d < detail::sobol_dims; ++d)
+        hi[d] = dirs.point(d, s - off) ^ shift[d];
+      const std::uint32_t * l0 = dirs.low[0] + off, * l1 = dirs.low[1] + off, * l2 = dirs.low[2] + off;
+      #pragma omp simd
+      for (std::size_t i = 0; i < n; ++i) {
+        px[i] = clx + (double(std::int32_t(hi[0] ^ l0[i])) + 0x1p31 + 0.5) * 0x1p-32 * size[0];
+        py[i] = cly + (double(std::int32_t(hi[1] ^ l1[i])) + 0x1p31 + 0.5) * 0x1p-32 * size[1];
+        pz[i] = clz + (double(std::int32_t(hi[2] ^ l2[i])) + 0x1p31 + 0.5) * 0x1p-32 * size[2];
+      }
+      if (opt.area) {
+        const std::uint32_t * l3 = dirs.low[3] + off, * l4 = dirs.low[4] + off;
+        #pragma omp simd
+        for (std::size_t i = 0; i < n; ++i) {
+          const double cz = 1 - 2 * ((double(std::int32_t(hi[3] ^ l3[i])) + 0x1p31 + 0.5) * 0x1p-32);
+          const double sz = std::sqrt(std::max(1 - cz * cz, 0.0));
+          double c, sn;
+          detail::sincosTurn((double(std::int32_t(hi[4] ^ l4[i])) + 0x1p31 + 0.5) * 0x1p-32, c, sn);
+          qx[i] = px[i] + eps * sz * c;
+          qy[i] = py[i] + eps * sz * sn;
+          qz[i] = pz[i] + eps * cz;
+        }
+      }
+      kernel(cp, cm, shapes.data(), pp, n, vp);
+      std::uint64_t in = 0, cr = 0;
+      for (std::size_t i = 0; i < n; ++i)
+        in += vp[i] != 0;
+      if (opt.area) {
+        kernel(cp, cm, shapes.data(), qq, n, vq);
+        for (std::size_t i = 0; i < n; ++i)
+          cr += vp[i] != vq[i];
+      }
+      inside[unit] += in;
+      cross[unit] += cr;
+      s += n;
+    }
+  };
+
+  std::uint64_t per_unit = 0;
+  for (std::uint64_t round_end = 64; ; round_end *= 2) {
+    const std::uint64_t begin = per_unit;
+    std::atomic<std::size_t> next(0);
+    auto work = [&] {
+      for (std::size_t u; (u = next.fetch_add(1, std::memory_order_relaxed)) < units; )
+        sample(u, begin, round_end);
+    };
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i)
+      pool.emplace_back(work);
+    work();
+    for (std::thread & t : pool)
+      t.join();
+    per_unit = round_end;
+    est.points = per_unit * units;
+
+    double vs = 0, vss = 0, as = 0, ass = 0;
+    for (unsigned r = 0; r < reps; ++r) {
+      std::uint64_t in = 0, cr = 0;
+      for (std::size_t c = 0; c < active; ++c) {
+        in += inside[c * reps + r];
+        cr += cross[c * reps + r];
+      }
+      const double v = cell_volume * double(in) / double(per_unit);
+      const double a = opt.area ? 2 / eps * cell_volume * double(cr) / double(per_unit) : 0;
+      vs += v;
+      vss += v * v;
+      as += a;
+      ass += a * a;
+    }
+    est.volume = vs / reps;
+    est.area = as / reps;
+    est.volume_error = std::sqrt(std::max(vss / reps - est.volume * est.volume, 0.0) / (reps - 1));
+    est.area_error = std::sqrt(std::max(ass / reps - est.area * est.area, 0.0) / (reps - 1));
+    est.converged = est.volume_error <= opt.tolerance * est.volume &&
+                    (!opt.area || est.area_error <= opt.area_tolerance * est.area);
+    if (est.converged || est.points >= opt.max_points)
+      break;
+  }
+  return est;
+}
+
+}
+
+#endif
@@ -0,0 +1,374 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_numa.hpp
+ * Partitioning of shape stores across NUMA nodes. Each partition is copied
+ * by a thread pinned to its node, so its pages are allocated there on first
+ * touch, and optionally bound to the node with mbind. Blocks of a partition
+ * are processed by workers pinned to the same node. Topology is read from
+ * /sys on Linux; elsewhere (or without NUMA) there is a single node with
+ * all processors.
+ */
+
+#ifndef GEO_NUMA_HPP
+#define GEO_NUMA_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "geo_expr.hpp"
+#include "geo_store.hpp"
+
+namespace Geo {
+
+namespace detail {
+
+/** @brief Parses list like "0-3,8,10-11" (format of /sys cpu and node lists) */
+inline std::vector<unsigned> parseIdList(const std::string & s) {
+  std::vector<unsigned> ids;
+  std::size_t pos = 0;
+  while (pos < s.size()) {
+    std::size_t end = s.find(',', pos);
+    if (end == std::string::npos)
+      end = s.size();
+    const std::string item = s.substr(pos, end - pos);
+    const std::size_t dash = item.find('-');
+    if (!item.empty() && item[0] >= '0' && item[0] <= '9') {
+      const unsigned lo = unsigned(std::stoul(item));
+      const unsigned hi = dash == std::string::npos ? lo : unsigned(std::stoul(item.substr(dash + 1)));
+      for (unsigned i = lo; i <= hi; ++i)
+        ids.push_back(i);
+    }
+    pos = end + 1;
+  }
+  return ids;
+}
+
+inline std::vector<unsigned> readIdList(const std::string & path) {
+  std::ifstream in(path);
+  std::string line;
+  if (!in || !std::getline(in, line))
+    return std::vector<unsigned>();
+  return parseIdList(line);
+}
+
+}
+
+/** @brief Retrieves online NUMA nodes */
+inline std::vector<unsigned> numaNodes(void) {
+  std::vector<unsigned> nodes = detail::readIdList("/sys/devices/system/node/online");
+  if (nodes.empty())
+    nodes.push_back(0);
+  return nodes;
+}
+
+/**
+ * @brief Retrieves processors of a NUMA node, which the calling thread may run on
+ *
+ * Processors outside the affinity mask of the thread (e.g. of its cpuset
+ * or taskset) are left out, so a node could have none.
+ * @param node Node number
+ * @return Processor numbers (all allowed processors if topology is not known)
+ */
+inline std::vector<unsigned> numaNodeCpus(unsigned node) {
+  std::vector<unsigned> cpus =
+    detail::readIdList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+  if (cpus.empty())
+    for (unsigned c = 0; c < std::max(1u, std::thread::hardware_concurrency()); ++c)
+      cpus.push_back(c);
+#ifdef __linux__
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+    cpus.erase(std::remove_if(cpus.begin(), cpus.end(),
+                              [&allowed](unsigned c) { return c >= CPU_SETSIZE || !CPU_ISSET(c, &allowed); }),
+               cpus.end());
+#endif
+  return cpus;
+}
+
+/**
+ * @brief Pins the calling thread to processors of a NUMA node
+ * @param node Node number
+ * @return Whether the thread was pinned (false also when it may run on no
+ * processor of the node)
+ */
+inline bool pinToNode(unsigned node) {
+#ifdef __linux__
+  const std::vector<unsigned> cpus = numaNodeCpus(node);
+  if (cpus.empty())
+    return false;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (unsigned c : cpus)
+    CPU_SET(c, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void)node;
+  return false;
+#endif
+}
+
+/**
+ * @brief Binds memory to a NUMA node
+ *
+ * Only pages entirely within the range are bound and pages already
+ * allocated elsewhere are moved.
+ * @param p Start of memory
+ * @param len Length in bytes
+ * @param node Node number
+ * @return Whether the memory was bound (false also without NUMA support)
+ */
+inline bool bindToNode(const void * p, std::size_t len, unsigned node) {
+#if defined(__linux__) && defined(SYS_mbind)
+  const std::uintptr_t page = std::uintptr_t(sysconf(_SC_PAGESIZE));
+  const std::uintptr_t first = (std::uintptr_t(p) + page - 1) / page * page;
+  const std::uintptr_t last = (std::uintptr_t(p) + len) / page * page;
+  if (last <= first)
+    return true;
+  const std::size_t bits = 8 * sizeof(unsigned long);
+  std::vector<unsigned long> mask(node / bits + 1, 0);
+  mask[node / bits] = 1UL << (node % bits);
+  return syscall(SYS_mbind, first, last - first, MPOL_BIND, mask.data(), mask.size() * bits + 1,
+                 MPOL_MF_MOVE) == 0;
+#else
+  (void)p; (void)len; (void)node;
+  return false;
+#endif
+}
+
+/**
+ * @brief Retrieves NUMA node of memory page
+ * @param p Address within the page (must be allocated already)
+ * @return Node number or -1 if not known
+ */
+inline int nodeOf(const void * p) {
+#if defined(__linux__) && defined(SYS_get_mempolicy)
+  int node = -1;
+  if (syscall(SYS_get_mempolicy, &node, nullptr, 0, p, MPOL_F_NODE | MPOL_F_ADDR) == 0)
+    return node;
+#else
+  (void)p;
+#endif
+  return -1;
+}
+
+/**
+ * @brief Shape store partitioned across NUMA nodes
+ *
+ * Blocks of the source store are split evenly into contiguous ranges, one
+ * for each node. Partitions keep the block size of the source, so their
+ * zone maps are the same.
+ */
+class PartitionedStore {
+public:
+  /** @brief Partition of the store */
+  struct Partition {
+    /** @brief Node, which owns the memory of the partition */
+    unsigned node;
+    /** @brief Index of the first row in the source store */
+    std::size_t first;
+    /** @brief Shapes of the partition */
+    ShapeStore store;
+  };
+
+  /** @brief Assignment of partitions to workers */
+  enum class Affinity {
+    /** @brief Workers process partitions on their own node */
+    Local,
+    /** @brief Workers process partitions of the next node (for comparison) */
+    Remote
+  };
+
+private:
+  std::vector<Partition> parts;
+
+  template <class F>
+  static void onNode(unsigned node, F f, std::vector<std::thread> & threads) {
+    threads.emplace_back([node, f] {
+      pinToNode(node);
+      f();
+    });
+  }
+
+public:
+  /**
+   * @brief Partitions store across nodes
+   * @param src Source store
+   * @param nodes Nodes of partitions
+   * @param bind Whether to bind memory of partitions to their nodes with
+   * mbind in addition to first touch allocation
+   */
+  explicit PartitionedStore(const ShapeStore & src, const std::vector<unsigned> & nodes = numaNodes(),
+                            bool bind = false) {
+    const std::size_t p = nodes.empty() ? 1 : nodes.size();
+    const std::size_t blocks = src.blockCount(), bs = src.blockSize();
+    parts.resize(p, Partition { 0, 0, ShapeStore(bs, src.hugePages()) });
+    std::vector<std::thread> threads;
+    for (std::size_t k = 0; k < p; ++k) {
+      Partition & part = parts[k];
+      part.node = nodes.empty() ? 0 : nodes[k];
+      part.first = std::min(src.size(), blocks * k / p * bs);
+      const std::size_t last = std::min(src.size(), blocks * (k + 1) / p * bs);
+      onNode(part.node, [&src, &part, last, bind] {
+        const std::size_t n = last - part.first;
+        const double * v[ShapeStore::column_count];
+        for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+          v[c] = src.column(ShapeStore::Column(c)) + part.first;
+        part.store.reserve(n);
+        part.store.append(n, src.types() + part.first, v);
+        if (bind) {
+          bindToNode(part.store.types(), n, part.node);
+          for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+            bindToNode(part.store.column(ShapeStore::Column(c)), n * sizeof(double), part.node);
+        }
+      }, threads);
+    }
+    for (std::thread & t : threads)
+      t.join();
+  }
+
+  /** @brief Retrieves number of partitions */
+  std::size_t partitionCount(void) const { return parts.size(); }
+  /** @brief Retrieves partition */
+  const Partition & partition(std::size_t k) const { return parts[k]; }
+
+  /** @brief Retrieves number of shapes */
+  std::size_t size(void) const {
+    std::size_t n = 0;
+    for (const Partition & p : parts)
+      n += p.store.size();
+    return n;
+  }
+
+  /**
+   * @brief Retrieves number of workers started by forEachBlock
+   * @param threads_per_node Workers on each node (0 for its allowed processors, at least one)
+   */
+  std::size_t workerCount(unsigned threads_per_node = 0) const {
+    std::size_t n = 0;
+    for (const Partition & p : parts)
+      n += threads_per_node ? threads_per_node : std::max<std::size_t>(numaNodeCpus(p.node).size(), 1);
+    return n;
+  }
+
+  /**
+   * @brief Processes all blocks in parallel
+   *
+   * Workers are pinned to the node of a partition and claim its blocks one
+   * by one. The function is called concurrently from several threads.
+   * @param f Function called with worker index (less than workerCount()),
+   * partition and block index within the partition
+   * @param threads_per_node Workers on each node (0 for its allowed processors, at least one)
+   * @param affinity Assignment of partitions to workers
+   */
+  template <class F>
+  void forEachBlock(F f, unsigned threads_per_node = 0, Affinity affinity = Affinity::Local) const {
+    const std::size_t p = parts.size();
+    std::vector<std::atomic<std::size_t> > next(p);
+    std::vector<std::thread> threads;
+    unsigned worker = 0;
+    for (std::size_t k = 0; k < p; ++k) {
+      const std::size_t w = threads_per_node ? threads_per_node
+                                             : std::max<std::size_t>(numaNodeCpus(parts[k].node).size(), 1);
+      /* Workers on node of partition k process partition k or the next one */
+      const Partition & part = parts[affinity == Affinity::Local ? k : (k + 1) % p];
+      std::atomic<std::size_t> & counter = next[affinity == Affinity::Local ? k : (k + 1) % p];
+      for (std::size_t i = 0; i < w; ++i, ++worker)
+        onNode(parts[k].node, [&f, &part, &counter, worker] {
+          for (std::size_t blk; (blk = counter.fetch_add(1, std::memory_order_relaxed)) < part.store.blockCount(); )
+            f(worker, part, blk);
+        }, threads);
+    }
+    for (std::thread & t : threads)
+      t.join();
+  }
+
+  /**
+   * @brief Calculates sum of a metric expression over all shapes in parallel
+   *
+   * Workers evaluate the expression block by block with the vector loops of
+   * ShapeStore::compute into buffers of their own.
+   * @param e Metric expression (e.g. <code>area() / perimeter()</code>)
+   * @param threads_per_node Workers on each node (0 for its allowed processors, at least one)
+   * @param affinity Assignment of partitions to workers
+   */
+  template <class E>
+  double sum(const Metric::Expression<E> & e, unsigned threads_per_node = 0,
+             Affinity affinity = Affinity::Local) const {
+    struct alignas(64) Partial {
+      double value = 0;
+      std::vector<double> out;
+    };
+    std::vector<Partial> partial(workerCount(threads_per_node));
+    forEachBlock([&e, &partial](unsigned worker, const Partition & part, std::size_t blk) {
+      const ShapeStore & s = part.store;
+      const std::size_t n = std::min(s.blockSize(), s.size() - blk * s.blockSize());
+      /* The buffer is allocated by the worker, so on its node */
+      std::vector<double> & out = partial[worker].out;
+      out.resize(s.blockSize());
+      s.compute(e, blk, out.data());
+      const double * v = out.data();
+      double total = 0;
+#pragma omp simd reduction(+ : total)
+      for (std::size_t i = 0; i < n; ++i)
+        total += v[i];
+      partial[worker].value += total;
+    }, threads_per_node, affinity);
+    double total = 0;
+    for (const Partial & p : partial)
+      total += p.value;
+    return total;
+  }
+
+  /**
+   * @brief Calculates sum of a measure over all shapes in parallel
+   * @param m Measure
+   * @param threads_per_node Workers on each node (0 for its allowed processors, at least one)
+   * @param affinity Assignment of partitions to workers
+   */
+  double sum(Measure m, unsigned threads_per_node = 0, Affinity affinity = Affinity::Local) const {
+    switch (m) {
+    case Measure::Area:
+      return sum(Metric::area(), threads_per_node, affinity);
+    case Measure::Perimeter:
+      return sum(Metric::perimeter(), threads_per_node, affinity);
+    default:
+      return sum(Metric::volume(), threads_per_node, affinity);
+    }
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,353 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_offset.hpp
+ * Offsets (buffers) of shapes by a distance and Minkowski sums. Rectangles
+ * and squares grow into rectangles with rounded corners, circles into
+ * circles, cubes into cubes with rounded edges and spheres into spheres.
+ * All of them are rounded boxes, which are closed under offsets and sums,
+ * so their measures have exact formulas. Batch kernels calculate measures
+ * of offset shapes of a store without building the shapes.
+ */
+
+#ifndef GEO_OFFSET_HPP
+#define GEO_OFFSET_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "geo_dispatch.hpp"
+
+namespace Geo {
+
+/**
+ * @brief Rectangle with rounded corners
+ *
+ * Rectangle of the given outer width and height, which corners are quarter
+ * circles of the given radius (at most half of the shorter side). Zero
+ * radius gives a rectangle and radius of half of equal sides a circle. The
+ * reference point is the corner of the bounding box with minimal
+ * coordinates like of Rectangle. Negative sizes and radius are clamped to
+ * zero and radius to half of the shorter side, like by offset.
+ */
+class RoundedRectangle final: public Shape2D {
+private:
+  double width;
+  double height;
+  double radius;
+
+  static double clampRadius(double w, double h, double r) {
+    return std::min(std::max(r, 0.0), std::min(std::max(w, 0.0), std::max(h, 0.0)) / 2);
+  }
+
+public:
+  /**
+   * @brief Construct rounded rectangle from 2D coordinates, sizes and radius
+   * @param c 2D coordinates
+   * @param w Width
+   * @param h Height
+   * @param r Radius of corners
+   */
+  RoundedRectangle(const Coord2D & c, double w, double h, double r)
+    : Shape2D(c), width(std::max(w, 0.0)), height(std::max(h, 0.0)), radius(clampRadius(w, h, r)) {}
+  /**
+   * @brief Construct rounded rectangle from coordinates, sizes and radius
+   * @param px X coordinate value
+   * @param py Y coordinate value
+   * @param w Width
+   * @param h Height
+   * @param r Radius of corners
+   */
+  RoundedRectangle(double px, double py, double w, double h, double r)
+    : Shape2D(px, py), width(std::max(w, 0.0)), height(std::max(h, 0.0)), radius(clampRadius(w, h, r)) {}
+  /**
+   * @brief Construct rounded rectangle equal to a circle
+   * @param c Circle
+   */
+  explicit RoundedRectangle(Circle c)
+    : RoundedRectangle(c.getRefPoint().getX() - c.getRadius(), c.getRefPoint().getY() - c.getRadius(),
+                       2 * c.getRadius(), 2 * c.getRadius(), c.getRadius()) {}
+  /**
+   * @brief Construct rounded rectangle equal to a rectangle
+   * @param r Rectangle
+   */
+  explicit RoundedRectangle(Rectangle r) : RoundedRectangle(r.getRefPoint(), r.getWidth(), r.getHeight(), 0) {}
+  /**
+   * @brief Construct rounded rectangle equal to a square
+   * @param s Square
+   */
+  explicit RoundedRectangle(Square s) : RoundedRectangle(s.getRefPoint(), s.getSide(), s.getSide(), 0) {}
+
+  /** @brief Retrieves width */
+  double getWidth(void) { return width; }
+  /** @brief Retrieves height */
+  double getHeight(void) { return height; }
+  /** @brief Retrieves radius of corners */
+  double getRadius(void) { return radius; }
+
+  /**
+   * @brief Calculates rounded rectangle's area
+   *
+   * Rectangle's area without the four corners outside the quarter circles,
+   * so it's calculated by the formula \f$wh - (4 - π)r^2\f$
+   * @return Rounded rectangle's area
+   */
+  double area(void) { return Formula::roundedRectangleArea(width, height, radius); }
+  /**
+   * @brief Calculates rounded rectangle's perimeter
+   *
+   * Straight sides shortened by \f$2r\f$ each and a full circle of the four
+   * corners, so it's calculated by the formula \f$2w + 2h - (8 - 2π)r\f$
+   * @return Rounded rectangle's perimeter
+   */
+  double perimeter(void) { return Formula::roundedRectanglePerimeter(width, height, radius); }
+  /**
+   * @brief Calculates rounded rectangle's bounding box
+   * @return Box of the rectangle
+   */
+  BoundingBox2D boundingBox(void) {
+    const Coord2D & c = getRefPoint();
+    return BoundingBox2D { c, Coord2D(c.getX() + width, c.getY() + height) };
+  }
+  /**
+   * @brief Calculates rounded rectangle's bounding circle
+   * @return Circle through the farthest points of the corner arcs
+   */
+  BoundingCircle boundingCircle(void) {
+    const Coord2D & c = getRefPoint();
+    return BoundingCircle { Coord2D(c.getX() + width / 2, c.getY() + height / 2),
+                            Formula::rectangleCircumradius(width - 2 * radius, height - 2 * radius) + radius };
+  }
+};
+
+/**
+ * @brief Offsets a circle by a distance
+ * @param c Circle
+ * @param d Distance, negative for inset
+ * @return Concentric circle, of zero radius when inset by more than the radius
+ */
+inline Circle offset(Circle c, double d) { return Circle(c.getRefPoint(), std::max(c.getRadius() + d, 0.0)); }
+
+/**
+ * @brief Offsets a rounded rectangle by a distance
+ *
+ * Growing adds the distance to the radius of the corners. Shrinking takes
+ * it from the radius and once the corners are sharp the shape stays a
+ * rectangle, until it's empty.
+ * @param r Rounded rectangle
+ * @param d Distance, negative for inset
+ * @return Rounded rectangle of points within the distance
+ */
+inline RoundedRectangle offset(RoundedRectangle r, double d) {
+  return RoundedRectangle(r.getRefPoint().getX() - d, r.getRefPoint().getY() - d,
+                          r.getWidth() + 2 * d, r.getHeight() + 2 * d, r.getRadius() + d);
+}
+
+/**
+ * @brief Offsets a rectangle by a distance
+ * @param r Rectangle
+ * @param d Distance, negative for inset
+ * @return Rectangle with corners rounded by the distance when grown
+ */
+inline RoundedRectangle offset(Rectangle r, double d) { return offset(RoundedRectangle(r), d); }
+
+/** @copydoc offset(Rectangle, double) */
+inline RoundedRectangle offset(Square s, double d) { return offset(RoundedRectangle(s), d); }
+
+/**
+ * @brief Offsets a sphere by a distance
+ * @param s Sphere
+ * @param d Distance, negative for inset
+ * @return Concentric sphere, of zero radius when inset by more than the radius
+ */
+inline Sphere offset(Sphere s, double d) { return Sphere(s.getRefPoint(), std::max(s.getRadius() + d, 0.0)); }
+
+/**
+ * @brief Calculates Minkowski sum of two rounded rectangles
+ *
+ * Sizes, radii and reference points add up, so the sum of a rectangle and
+ * a circle of radius \f$r\f$ is the rectangle offset by \f$r\f$ and moved
+ * by the center of the circle.
+ * @param r First rounded rectangle
+ * @param s Second rounded rectangle
+ * @return Rounded rectangle of sums of points of both
+ */
+inline RoundedRectangle minkowskiSum(RoundedRectangle r, RoundedRectangle s) {
+  return RoundedRectangle(r.getRefPoint().getX() + s.getRefPoint().getX(),
+                          r.getRefPoint().getY() + s.getRefPoint().getY(),
+                          r.getWidth() + s.getWidth(), r.getHeight() + s.getHeight(),
+                          r.getRadius() + s.getRadius());
+}
+
+/**
+ * @brief Input of offset measure kernels
+ *
+ * Shapes in a batch could be of different types and are all offset by the
+ * same distance.
+ */
+struct OffsetBatch {
+  /** @brief Shape types */
+  const ShapeType * t;
+  /** @brief Dimensions A */
+  const double * a;
+  /** @brief Dimensions B */
+  const double * b;
+  /** @brief Distance, negative for inset */
+  double d;
+  /** @brief Number of shapes */
+  std::size_t n;
+};
+
+/** @brief Batch kernel calculating measures of offset shapes into output array */
+typedef void (*OffsetKernelFn)(const OffsetBatch & in, double * out);
+
+namespace detail {
+
+/*
+ * Every shape is a rounded box of outer width w = kw a, height
+ * h = kha a + khb b (equal to the width for solids) and radius kr a, which
+ * offset stays a rounded box. Perimeters of solids are the ones of the
+ * measure kernels: the great circle of spheres and none for cubes.
+ */
+struct OffsetCoeffs {
+  double kw[shape_type_count];
+  double kha[shape_type_count];
+  double khb[shape_type_count];
+  double kr[shape_type_count];
+  double solid[shape_type_count];
+};
+
+alignas(64) constexpr OffsetCoeffs offset_coeffs = {
+  /*          Circle Rect Square Sphere Cube */
+  /* kw    */ { 2,   1,   1,     2,     1 },
+  /* kha   */ { 2,   0,   1,     2,     1 },
+  /* khb   */ { 0,   1,   0,     0,     0 },
+  /* kr    */ { 1,   0,   0,     1,     0 },
+  /* solid */ { 0,   0,   0,     1,     1 }
+};
+
+template <Measure M>
+inline __attribute__((always_inline)) double offsetFormula(ShapeType t, double a, double b, double d) {
+  const unsigned s = unsigned(t);
+  const double w = std::max(coeff(offset_coeffs.kw, s) * a + 2 * d, 0.0);
+  const double h = std::max(coeff(offset_coeffs.kha, s) * a + coeff(offset_coeffs.khb, s) * b + 2 * d, 0.0);
+  const double r = std::min(std::max(coeff(offset_coeffs.kr, s) * a + d, 0.0), std::min(w, h) / 2);
+  const double solid = coeff(offset_coeffs.solid, s);
+  if constexpr (M == Measure::Area)
+    return (1 - solid) * Formula::roundedRectangleArea(w, h, r) + solid * Formula::roundedCubeArea(w, r);
+  else if constexpr (M == Measure::Perimeter)
+    return (1 - solid) * Formula::roundedRectanglePerimeter(w, h, r) +
+           solid * coeff(offset_coeffs.kr, s) * Formula::circlePerimeter(r);
+  else
+    return solid * Formula::roundedCubeVolume(w, r);
+}
+
+template <Measure M>
+struct OffsetLoop {
+  template <bool Simd>
+  static inline __attribute__((always_inline)) void run(const OffsetBatch & in, double * __restrict out) {
+    const ShapeType * __restrict t = in.t;
+    const double * __restrict a = in.a;
+    const double * __restrict b = in.b;
+    const double d = in.d;
+    const std::size_t n = in.n;
+#pragma omp simd if(simd: Simd)
+    for (std::size_t i = 0; i < n; ++i)
+      out[i] = offsetFormula<M>(t[i], a[i], b[i], d);
+  }
+};
+
+/* Shape types are bytes, so kernels of AVX-512 level need AVX-512BW */
+template <Measure M>
+using OffsetKernel = IsaKernel<OffsetKernelFn, OffsetLoop<M>, true>;
+
+}
+
+/**
+ * @brief Selects offset measure kernel compiled for an instruction set level
+ *
+ * The caller is responsible for the processor supporting the level. Kernels
+ * of AVX-512 level are replaced by AVX2 ones on processors without AVX-512BW.
+ * @param m Measure
+ * @param isa Instruction set level
+ */
+inline OffsetKernelFn offsetKernel(Measure m, Isa isa) {
+  switch (m) {
+  case Measure::Area:
+    return detail::OffsetKernel<Measure::Area>::select(isa);
+  case Measure::Perimeter:
+    return detail::OffsetKernel<Measure::Perimeter>::select(isa);
+  default:
+    return detail::OffsetKernel<Measure::Volume>::select(isa);
+  }
+}
+
+/**
+ * @brief Selects offset measure kernel for the active instruction set level
+ * @param m Measure
+ */
+inline OffsetKernelFn dispatchOffsetKernel(Measure m) {
+  return offsetKernel(m, activeIsa());
+}
+
+/**
+ * @brief Calculates measures of all shapes of a store offset by a distance
+ * @param store Shapes
+ * @param m Measure
+ * @param d Distance, negative for inset
+ * @param out Measures of the offset shapes in order of the store
+ */
+inline void offsetMeasure(const ShapeStore & store, Measure m, double d, double * out) {
+  const OffsetKernelFn k = dispatchOffsetKernel(m);
+  for (std::size_t first = 0; first < store.size(); first += store.blockSize()) {
+    const OffsetBatch in = { store.types() + first, store.column(ShapeStore::Column::A) + first,
+                             store.column(ShapeStore::Column::B) + first, d,
+                             std::min(store.blockSize(), store.size() - first) };
+    k(in, out + first);
+  }
+}
+
+/**
+ * @brief Sums measures of all shapes of a store offset by a distance
+ * @param store Shapes
+ * @param m Measure
+ * @param d Distance, negative for inset
+ * @return Sum of the measures of the offset shapes
+ */
+inline double offsetSum(const ShapeStore & store, Measure m, double d) {
+  const OffsetKernelFn k = dispatchOffsetKernel(m);
+  std::vector<double> buf(store.blockSize());
+  double t = 0;
+  for (std::size_t first = 0; first < store.size(); first += store.blockSize()) {
+    const OffsetBatch in = { store.types() + first, store.column(ShapeStore::Column::A) + first,
+                             store.column(ShapeStore::Column::B) + first, d,
+                             std::min(store.blockSize(), store.size() - first) };
+    k(in, buf.data());
+#pragma omp simd reduction(+ : t)
+    for (std::size_t i = 0; i < in.n; ++i)
+      t += buf[i];
+  }
+  return t;
+}
+
+}
+
+#endif
@@ -0,0 +1,467 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_overlap.hpp
+ * Exact area of the overlap of two planar shapes and exact volume of the
+ * overlap of two solids. Formulas are closed forms without branches on the
+ * relative position of the shapes: disjoint, touching, crossing and nested
+ * shapes go through the same arithmetic with clamped arguments, so batch
+ * kernels over arrays of pairs vectorize. Like the measure kernels they are
+ * compiled for every instruction set level.
+ */
+
+#ifndef GEO_OVERLAP_HPP
+#define GEO_OVERLAP_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "geo_dispatch.hpp"
+
+namespace Geo {
+
+/**
+ * @brief Kinds of pairs of shapes with overlap
+ *
+ * Squares are handled as rectangles. Pairs of a round and a box shape have
+ * the round one first.
+ */
+enum class OverlapKind : std::uint8_t {
+  CircleCircle,
+  RectangleRectangle,
+  CircleRectangle,
+  SphereSphere,
+  CubeCube,
+  SphereCube
+};
+
+/** @brief Number of kinds of pairs */
+constexpr unsigned overlap_kind_count = 6;
+
+/**
+ * @brief Finds the kind of a pair of shape types
+ * @param s Type of first shape
+ * @param t Type of second shape
+ * @param k Kind of the pair
+ * @param swap Set when the shapes should be swapped to match the kind
+ * @return False for shapes of different dimensions, which do not overlap
+ */
+inline bool overlapKind(ShapeType s, ShapeType t, OverlapKind & k, bool & swap) {
+  const auto round = [](ShapeType u) { return u == ShapeType::Circle || u == ShapeType::Sphere; };
+  const auto solid = [](ShapeType u) { return u == ShapeType::Sphere || u == ShapeType::Cube; };
+  if (solid(s) != solid(t))
+    return false;
+  swap = !round(s) && round(t);
+  const unsigned base = solid(s) ? unsigned(OverlapKind::SphereSphere) : 0;
+  k = OverlapKind(base + (round(s) == round(t) ? (round(s) ? 0 : 1) : 2));
+  return true;
+}
+
+/**
+ * @brief Checks whether pairs of a kind have rectangles
+ * @param k Kind of pairs
+ */
+constexpr bool hasRectangles(OverlapKind k) {
+  return k == OverlapKind::RectangleRectangle || k == OverlapKind::CircleRectangle;
+}
+
+/**
+ * @brief Height of a rectangle or square in a store
+ * @param store Shapes
+ * @param row Row of the shape
+ */
+inline double rectangleHeight(const ShapeStore & store, std::uint32_t row) {
+  const ShapeStore::Column c = store.type(row) == ShapeType::Square ? ShapeStore::Column::A : ShapeStore::Column::B;
+  return store.column(c)[row];
+}
+
+/**
+ * @brief Input of overlap kernels
+ *
+ * Pairs are given by row indices in columns of the same order as the ones
+ * of ShapeStore. Heights of rectangles and squares (column B or side A by
+ * type) are given by pair for kinds with rectangles, so kernels do not
+ * read types. Cubes use only their edge A.
+ */
+struct PairBatch {
+  /** @brief Arrays with values of each column in order X, Y, Z, A and B */
+  const double * v[ShapeStore::column_count];
+  /** @brief Rows of first shapes of the pairs */
+  const std::uint32_t * first;
+  /** @brief Rows of second shapes of the pairs */
+  const std::uint32_t * second;
+  /** @brief Heights of first shapes of the pairs, when of kind with rectangles */
+  const double * first_height;
+  /** @brief Heights of second shapes of the pairs, when of kind with rectangles */
+  const double * second_height;
+  /** @brief Number of pairs */
+  std::size_t n;
+};
+
+/** @brief Batch kernel calculating overlap of pairs of shapes of a kind */
+typedef void (*OverlapKernelFn)(const PairBatch & in, double * out);
+
+namespace detail {
+
+constexpr double pi = M_PI;
+/* Keeps quotients finite, where both numerator and denominator vanish */
+constexpr double tiny = 1e-300;
+
+/* Arc sine of the FDLIBM rational approximation, where the range reduction
+ * is a selection, so it vectorizes unlike the library function */
+inline __attribute__((always_inline)) double arcsin(double x) {
+  const double ax = std::fabs(x);
+  const bool small = ax < 0.5;
+  const double z = small ? x * x : (1 - ax) * 0.5;
+  const double s = small ? ax : std::sqrt(z);
+  const double p = z * (1.66666666666666657415e-01 + z * (-3.25565818622400915405e-01 +
+                   z * (2.01212532134862925881e-01 + z * (-4.00555345006794114027e-02 +
+                   z * (7.91534994289814532176e-04 + z * 3.47933107596021167570e-05)))));
+  const double q = 1 + z * (-2.40339491173441421878e+00 + z * (2.02094576023350569471e+00 +
+                   z * (-6.88283971605453293030e-01 + z * 7.70381505559019352791e-02)));
+  const double w = s + s * (p / q);
+  return std::copysign(small ? w : pi / 2 - 2 * w, x);
+}
+
+inline __attribute__((always_inline)) double clamp1(double x) { return std::min(std::max(x, -1.0), 1.0); }
+
+/* Length of the overlap of segments [lo1, lo1 + len1] and [lo2, lo2 + len2] */
+inline __attribute__((always_inline)) double segmentOverlap(double lo1, double len1, double lo2, double len2) {
+  return std::max(std::min(lo1 + len1, lo2 + len2) - std::max(lo1, lo2), 0.0);
+}
+
+/* Lens of circles at distance d. Cosines of the half angles of the arcs are
+ * clamped, so disjoint circles give zero and nested ones the smaller disk. */
+inline __attribute__((always_inline)) double lensArea(double dx, double dy, double r1, double r2) {
+  const double d = std::max(std::sqrt(dx * dx + dy * dy), tiny);
+  const double c1 = clamp1((d * d + r1 * r1 - r2 * r2) / (2 * d * r1));
+  const double c2 = clamp1((d * d + r2 * r2 - r1 * r1) / (2 * d * r2));
+  const double k = (r1 + r2 - d) * (d + r1 - r2) * (d - r1 + r2) * (d + r1 + r2);
+  return r1 * r1 * (pi / 2 - arcsin(c1)) + r2 * r2 * (pi / 2 - arcsin(c2)) - 0.5 * std::sqrt(std::max(k, 0.0));
+}
+
+/* Lens of spheres at distance d, selected between the disjoint, nested and
+ * crossing cases */
+inline __attribute__((always_inline)) double lensVolume(double dx, double dy, double dz, double r1, double r2) {
+  const double d = std::sqrt(dx * dx + dy * dy + dz * dz);
+  const double s = r1 + r2 - d, m = std::min(r1, r2);
+  const double dd = std::max(d, tiny);
+  const double lens = pi * s * s * (d * d + 2 * d * (r1 + r2) - 3 * (r1 - r2) * (r1 - r2)) / (12 * dd);
+  const double nested = 4.0 / 3.0 * pi * m * m * m;
+  return s <= 0 ? 0.0 : (d <= std::fabs(r1 - r2) ? nested : lens);
+}
+
+/*
+ * Differences of squares are factored, so they are exactly zero at the
+ * boundary and their square roots do not amplify rounding errors.
+ *
+ * Area of the disk of radius r around the origin within the rectangle from
+ * the origin to corner (a, b), negative when the rectangle is flipped. The
+ * overlap with any rectangle is the alternating sum over its four corners.
+ */
+inline __attribute__((always_inline)) double diskSegment(double t, double r) {
+  return 0.5 * (t * std::sqrt(std::max((r - t) * (r + t), 0.0)) + r * r * arcsin(std::min(t / r, 1.0)));
+}
+
+inline __attribute__((always_inline)) double diskCorner(double a, double b, double r) {
+  const double u = std::min(std::fabs(a), r), v = std::min(std::fabs(b), r);
+  const double in = u * v;
+  const double out = diskSegment(u, r) + diskSegment(v, r) - pi / 4 * r * r;
+  return std::copysign(1.0, a) * std::copysign(1.0, b) * (u * u + v * v <= r * r ? in : out);
+}
+
+inline __attribute__((always_inline)) double circleRectangleArea(double x0, double y0, double w, double h, double r) {
+  const double x1 = x0 + w, y1 = y0 + h;
+  return diskCorner(x1, y1, r) - diskCorner(x0, y1, r) - diskCorner(x1, y0, r) + diskCorner(x0, y0, r);
+}
+
+/*
+ * Volume of the ball of radius r around the origin within the box from the
+ * origin to corner (a, b, c) for non-negative coordinates up to r. Sections
+ * at height z are disks of radius rho with rho^2 = r^2 - z^2, which cover the
+ * rectangle a x b up to height zab. Above it the section is the sum of a
+ * term of each side, integrated in closed form: for side a it is the disk
+ * segment S(a) - pi rho^2 / 8 up to height za, where the disk stops
+ * crossing the side, and pi rho^2 / 8 above. sliceSide is the antiderivative
+ * of S(a) over the height.
+ */
+inline __attribute__((always_inline)) double sliceSide(double a, double z, double r) {
+  const double k2 = (r - a) * (r + a), k = std::sqrt(std::max(k2, 0.0));
+  const double q = std::sqrt(std::max((k - z) * (k + z), 0.0));
+  const double as = arcsin(std::min(z / std::max(k, tiny), 1.0));
+  const double u = arcsin(std::min(a / std::max(std::sqrt((r - z) * (r + z)), tiny), 1.0));
+  const double at = arcsin(std::min(a * z / std::max(std::sqrt(a * a * z * z + r * r * q * q), tiny), 1.0));
+  const double v = r * r * z - z * z * z / 3;
+  return 0.5 * (a / 2 * (z * q + k2 * as) + v * u - a / 3 * (0.5 * (k2 * as - z * q) - 2 * r * r * as) -
+                2 * r * r * r / 3 * at);
+}
+
+inline __attribute__((always_inline)) double sideTerm(double a, double zl, double c, double r) {
+  const double zm = std::min(std::sqrt(std::max((r - a) * (r + a), 0.0)), c);
+  const double pc = r * r * c - c * c * c / 3, pm = r * r * zm - zm * zm * zm / 3, pl = r * r * zl - zl * zl * zl / 3;
+  return sliceSide(a, zm, r) - sliceSide(a, zl, r) + pi / 4 * (pc - pm) - pi / 8 * (pc - pl);
+}
+
+inline __attribute__((always_inline)) double ballCorner(double a, double b, double c, double r) {
+  const double sign = std::copysign(1.0, a) * std::copysign(1.0, b) * std::copysign(1.0, c);
+  a = std::min(std::fabs(a), r);
+  b = std::min(std::fabs(b), r);
+  c = std::min(std::fabs(c), r);
+  const double zl = std::min(std::sqrt(std::max((r - a) * (r + a) - b * b, 0.0)), c);
+  return sign * (a * b * zl + sideTerm(a, zl, c, r) + sideTerm(b, zl, c, r));
+}
+
+inline __attribute__((always_inline)) double sphereCubeVolume(double x0, double y0, double z0, double e, double r) {
+  const double x1 = x0 + e, y1 = y0 + e, z1 = z0 + e;
+  return ballCorner(x1, y1, z1, r) - ballCorner(x0, y1, z1, r) - ballCorner(x1, y0, z1, r) -
+         ballCorner(x1, y1, z0, r) + ballCorner(x0, y0, z1, r) + ballCorner(x0, y1, z0, r) +
+         ballCorner(x1, y0, z0, r) - ballCorner(x0, y0, z0, r);
+}
+
+/* Heights hi and hj are the ones of rectangles */
+template <OverlapKind K>
+inline __attribute__((always_inline)) double pairOverlap(const double * const * v, std::uint32_t i, std::uint32_t j,
+                                                         double hi, double hj) {
+  const double * x = v[0], * y = v[1], * z = v[2], * a = v[3];
+  if constexpr (K == OverlapKind::CircleCircle)
+    return lensArea(x[j] - x[i], y[j] - y[i], a[i], a[j]);
+  else if constexpr (K == OverlapKind::RectangleRectangle)
+    return segmentOverlap(x[i], a[i], x[j], a[j]) * segmentOverlap(y[i], hi, y[j], hj);
+  else if constexpr (K == OverlapKind::CircleRectangle)
+    return circleRectangleArea(x[j] - x[i], y[j] - y[i], a[j], hj, a[i]);
+  else if constexpr (K == OverlapKind::SphereSphere)
+    return lensVolume(x[j] - x[i], y[j] - y[i], z[j] - z[i], a[i], a[j]);
+  else if constexpr (K == OverlapKind::CubeCube)
+    return segmentOverlap(x[i], a[i], x[j], a[j]) * segmentOverlap(y[i], a[i], y[j], a[j]) *
+           segmentOverlap(z[i], a[i], z[j], a[j]);
+  else
+    return sphereCubeVolume(x[j] - x[i], y[j] - y[i], z[j] - z[i], a[j], a[i]);
+}
+
+/* Rows are gathered from the columns, which are only read, so the loop
+ * needs no checks for overlaps of the output with them */
+template <OverlapKind K>
+struct OverlapLoop {
+  template <bool Simd>
+  static inline __attribute__((always_inline)) void run(const PairBatch & in, double * __restrict out) {
+    const std::uint32_t * __restrict i = in.first;
+    const std::uint32_t * __restrict j = in.second;
+    const std::size_t n = in.n;
+    if constexpr (hasRectangles(K)) {
+      const double * __restrict hi = in.first_height;
+      const double * __restrict hj = in.second_height;
+#pragma omp simd if(simd: Simd)
+      for (std::size_t p = 0; p < n; ++p)
+        out[p] = pairOverlap<K>(in.v, i[p], j[p], hi[p], hj[p]);
+    } else {
+#pragma omp simd if(simd: Simd)
+      for (std::size_t p = 0; p < n; ++p)
+        out[p] = pairOverlap<K>(in.v, i[p], j[p], 0, 0);
+    }
+  }
+};
+
+template <OverlapKind K>
+using OverlapKernel = IsaKernel<OverlapKernelFn, OverlapLoop<K>>;
+
+}
+
+/**
+ * @brief Selects overlap kernel compiled for an instruction set level
+ *
+ * The caller is responsible for the processor supporting the level.
+ * @param k Kind of pairs
+ * @param isa Instruction set level
+ */
+inline OverlapKernelFn overlapKernel(OverlapKind k, Isa isa) {
+  switch (k) {
+  case OverlapKind::CircleCircle:
+    return detail::OverlapKernel<OverlapKind::CircleCircle>::select(isa);
+  case OverlapKind::RectangleRectangle:
+    return detail::OverlapKernel<OverlapKind::RectangleRectangle>::select(isa);
+  case OverlapKind::CircleRectangle:
+    return detail::OverlapKernel<OverlapKind::CircleRectangle>::select(isa);
+  case OverlapKind::SphereSphere:
+    return detail::OverlapKernel<OverlapKind::SphereSphere>::select(isa);
+  case OverlapKind::CubeCube:
+    return detail::OverlapKernel<OverlapKind::CubeCube>::select(isa);
+  default:
+    return detail::OverlapKernel<OverlapKind::SphereCube>::select(isa);
+  }
+}
+
+/**
+ * @brief Selects overlap kernel for the active instruction set level
+ * @param k Kind of pairs
+ */
+inline OverlapKernelFn dispatchOverlapKernel(OverlapKind k) {
+  static const std::array<OverlapKernelFn, overlap_kind_count> table = [] {
+    std::array<OverlapKernelFn, overlap_kind_count> t;
+    for (unsigned i = 0; i < overlap_kind_count; ++i)
+      t[i] = overlapKernel(OverlapKind(i), activeIsa());
+    return t;
+  }();
+  return table[unsigned(k)];
+}
+
+/**
+ * @brief Calculates area of the overlap of two circles
+ * @param c First circle
+ * @param d Second circle
+ * @return Area of the lens, the smaller circle when nested or zero when disjoint
+ */
+inline double overlapArea(Circle c, Circle d) {
+  return detail::lensArea(d.getRefPoint().getX() - c.getRefPoint().getX(),
+                          d.getRefPoint().getY() - c.getRefPoint().getY(), c.getRadius(), d.getRadius());
+}
+
+/**
+ * @brief Calculates area of the overlap of two rectangles
+ * @param r First rectangle
+ * @param s Second rectangle
+ * @return Area of the common rectangle or zero when disjoint
+ */
+inline double overlapArea(Rectangle r, Rectangle s) {
+  return detail::segmentOverlap(r.getRefPoint().getX(), r.getWidth(), s.getRefPoint().getX(), s.getWidth()) *
+         detail::segmentOverlap(r.getRefPoint().getY(), r.getHeight(), s.getRefPoint().getY(), s.getHeight());
+}
+
+/**
+ * @brief Calculates area of the overlap of a circle and a rectangle
+ * @param c Circle
+ * @param r Rectangle
+ * @return Area of the common part or zero when disjoint
+ */
+inline double overlapArea(Circle c, Rectangle r) {
+  return detail::circleRectangleArea(r.getRefPoint().getX() - c.getRefPoint().getX(),
+                                     r.getRefPoint().getY() - c.getRefPoint().getY(),
+                                     r.getWidth(), r.getHeight(), c.getRadius());
+}
+
+/** @copydoc overlapArea(Circle, Rectangle) */
+inline double overlapArea(Rectangle r, Circle c) { return overlapArea(c, r); }
+
+/**
+ * @brief Calculates volume of the overlap of two spheres
+ * @param s First sphere
+ * @param t Second sphere
+ * @return Volume of the lens, the smaller sphere when nested or zero when disjoint
+ */
+inline double overlapVolume(Sphere s, Sphere t) {
+  const Coord3D & c = s.getRefPoint(), & d = t.getRefPoint();
+  return detail::lensVolume(d.getX() - c.getX(), d.getY() - c.getY(), d.getZ() - c.getZ(),
+                            s.getRadius(), t.getRadius());
+}
+
+/**
+ * @brief Calculates volume of the overlap of two cubes
+ * @param c First cube
+ * @param d Second cube
+ * @return Volume of the common box or zero when disjoint
+ */
+inline double overlapVolume(Cube c, Cube d) {
+  const Coord3D & p = c.getRefPoint(), & q = d.getRefPoint();
+  const double a = c.getEdge(), b = d.getEdge();
+  return detail::segmentOverlap(p.getX(), a, q.getX(), b) * detail::segmentOverlap(p.getY(), a, q.getY(), b) *
+         detail::segmentOverlap(p.getZ(), a, q.getZ(), b);
+}
+
+/**
+ * @brief Calculates volume of the overlap of a sphere and a cube
+ * @param s Sphere
+ * @param c Cube
+ * @return Volume of the common part or zero when disjoint
+ */
+inline double overlapVolume(Sphere s, Cube c) {
+  const Coord3D & p = s.getRefPoint(), & q = c.getRefPoint();
+  return detail::sphereCubeVolume(q.getX() - p.getX(), q.getY() - p.getY(), q.getZ() - p.getZ(),
+                                  c.getEdge(), s.getRadius());
+}
+
+/** @copydoc overlapVolume(Sphere, Cube) */
+inline double overlapVolume(Cube c, Sphere s) { return overlapVolume(s, c); }
+
+/**
+ * @brief Calculates overlaps of pairs of shapes in a store
+ *
+ * Pairs of any types are grouped by kind in chunks and each group goes
+ * through the kernel of its kind. Results are areas for planar shapes,
+ * volumes for solids and zero for a planar shape with a solid.
+ * @param store Shapes
+ * @param first Rows of first shapes of the pairs
+ * @param second Rows of second shapes of the pairs
+ * @param n Number of pairs
+ * @param out Overlaps of the pairs
+ */
+inline void overlaps(const ShapeStore & store, const std::uint32_t * first, const std::uint32_t * second,
+                     std::size_t n, double * out) {
+  static constexpr std::size_t chunk = 4096;
+  std::vector<std::uint32_t> fi[overlap_kind_count], se[overlap_kind_count], pos[overlap_kind_count];
+  std::vector<double> fh[overlap_kind_count], sh[overlap_kind_count];
+  std::vector<double> res(chunk);
+  PairBatch in;
+  for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+    in.v[c] = store.column(ShapeStore::Column(c));
+  for (std::size_t start = 0; start < n; start += chunk) {
+    const std::size_t end = std::min(n, start + chunk);
+    for (unsigned k = 0; k < overlap_kind_count; ++k) {
+      fi[k].clear();
+      se[k].clear();
+      pos[k].clear();
+      fh[k].clear();
+      sh[k].clear();
+    }
+    for (std::size_t p = start; p < end; ++p) {
+      OverlapKind k;
+      bool swap;
+      if (!overlapKind(store.type(first[p]), store.type(second[p]), k, swap)) {
+        out[p] = 0;
+        continue;
+      }
+      const std::uint32_t i = swap ? second[p] : first[p], j = swap ? first[p] : second[p];
+      fi[unsigned(k)].push_back(i);
+      se[unsigned(k)].push_back(j);
+      pos[unsigned(k)].push_back(std::uint32_t(p - start));
+      if (hasRectangles(k)) {
+        fh[unsigned(k)].push_back(k == OverlapKind::RectangleRectangle ? rectangleHeight(store, i) : 0);
+        sh[unsigned(k)].push_back(rectangleHeight(store, j));
+      }
+    }
+    for (unsigned k = 0; k < overlap_kind_count; ++k) {
+      if (pos[k].empty())
+        continue;
+      in.first = fi[k].data();
+      in.second = se[k].data();
+      in.first_height = fh[k].data();
+      in.second_height = sh[k].data();
+      in.n = pos[k].size();
+      dispatchOverlapKernel(OverlapKind(k))(in, res.data());
+      for (std::size_t q = 0; q < in.n; ++q)
+        out[start + pos[k][q]] = res[q];
+    }
+  }
+}
+
+}
+
+#endif
@@ -0,0 +1,229 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_perf.hpp
+ * Measurement of operations with hardware performance counters. On Linux
+ * counters are read through perf_event_open. Counters, which could not be
+ * opened (e.g. not supported or not permitted), are reported as not
+ * available, while wall time is always measured.
+ */
+
+#ifndef GEO_PERF_HPP
+#define GEO_PERF_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Geo {
+
+/** @brief Hardware events counted around operations */
+enum class PerfEvent {
+  Cycles,
+  Instructions,
+  BranchMisses,
+  L1DMisses,
+  LLCMisses
+};
+
+/** @brief Number of counted events */
+constexpr unsigned perf_event_count = 5;
+
+/** @brief Retrieves name of event */
+inline const char * perfEventName(PerfEvent e) {
+  static const char * const names[perf_event_count] = {
+    "cycles", "instructions", "branch-misses", "L1d-misses", "LLC-misses"
+  };
+  return names[unsigned(e)];
+}
+
+/** @brief Measurement of an operation */
+struct PerfSample {
+  /** @brief Counted events (scaled when counters were multiplexed) */
+  double value[perf_event_count] = { 0, 0, 0, 0, 0 };
+  /** @brief Whether each counter was available */
+  bool available[perf_event_count] = { false, false, false, false, false };
+  /** @brief Wall time in nanoseconds */
+  double nanoseconds = 0;
+  /** @brief Number of processed elements */
+  std::size_t elements = 1;
+
+  /** @brief Retrieves event count per element */
+  double perElement(PerfEvent e) const { return value[unsigned(e)] / double(elements ? elements : 1); }
+  /** @brief Retrieves wall time per element in nanoseconds */
+  double nsPerElement(void) const { return nanoseconds / double(elements ? elements : 1); }
+};
+
+/**
+ * @brief Set of hardware performance counters for the calling thread
+ *
+ * Counters are opened on construction and closed on destruction. Each event
+ * is opened separately, so unsupported events do not prevent counting of
+ * the others. Counters are inherited by threads created after construction,
+ * so operations running worker threads are counted whole. Counts of a
+ * worker thread are added to the counters only when the thread exits, so
+ * operations must join their workers before stop(). Events of threads
+ * still running then, e.g. of a thread pool, are not counted.
+ */
+class PerfCounters {
+private:
+  int fds[perf_event_count];
+  std::chrono::steady_clock::time_point started;
+
+#ifdef __linux__
+  static int open(std::uint32_t type, std::uint64_t config) {
+    perf_event_attr attr = perf_event_attr();
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    /* Inherited counters could not be read as a group */
+    attr.inherit = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+#endif
+
+public:
+  /** @brief Opens the counters */
+  PerfCounters() {
+    for (int & fd : fds)
+      fd = -1;
+#ifdef __linux__
+    const std::uint64_t cache_read_miss = (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    fds[unsigned(PerfEvent::Cycles)] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    fds[unsigned(PerfEvent::Instructions)] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    fds[unsigned(PerfEvent::BranchMisses)] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    fds[unsigned(PerfEvent::L1DMisses)] = open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | cache_read_miss);
+    fds[unsigned(PerfEvent::LLCMisses)] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#endif
+  }
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters & operator=(const PerfCounters &) = delete;
+
+  /** @brief Closes the counters */
+  ~PerfCounters() {
+#ifdef __linux__
+    for (int fd : fds)
+      if (fd >= 0)
+        close(fd);
+#endif
+  }
+
+  /** @brief Checks whether a counter is available */
+  bool available(PerfEvent e) const { return fds[unsigned(e)] >= 0; }
+
+  /** @brief Resets and starts counting */
+  void start(void) {
+#ifdef __linux__
+    for (int fd : fds)
+      if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+#endif
+    started = std::chrono::steady_clock::now();
+  }
+
+  /**
+   * @brief Stops counting
+   *
+   * Worker threads created since start must have been joined, since their
+   * counts are added only when they exit.
+   * @param elements Number of elements processed since start
+   * @return Counted events
+   */
+  PerfSample stop(std::size_t elements = 1) {
+    const auto stopped = std::chrono::steady_clock::now();
+    PerfSample s;
+    s.elements = elements;
+    s.nanoseconds = std::chrono::duration<double, std::nano>(stopped - started).count();
+#ifdef __linux__
+    for (unsigned e = 0; e < perf_event_count; ++e) {
+      if (fds[e] < 0)
+        continue;
+      ioctl(fds[e], PERF_EVENT_IOC_DISABLE, 0);
+      std::uint64_t buf[3] = { 0, 0, 0 };
+      if (read(fds[e], buf, sizeof(buf)) != ssize_t(sizeof(buf)) || buf[2] == 0)
+        continue;
+      s.value[e] = double(buf[0]) * double(buf[1]) / double(buf[2]);
+      s.available[e] = true;
+    }
+#endif
+    return s;
+  }
+
+  /**
+   * @brief Measures an operation
+   * @param elements Number of elements processed by the operation
+   * @param op Operation (single call, batch kernel, index build, query, etc.)
+   * @return Counted events
+   */
+  template <class F>
+  PerfSample measure(std::size_t elements, F op) {
+    start();
+    op();
+    return stop(elements);
+  }
+};
+
+/**
+ * @brief Prints measurement per element
+ * @param out Output stream
+ * @param name Name of the operation
+ * @param s Measurement
+ */
+inline void printPerElement(std::FILE * out, const std::string & name, const PerfSample & s) {
+  std::fprintf(out, "%-28s %10.3f ns", name.c_str(), s.nsPerElement());
+  for (unsigned e = 0; e < perf_event_count; ++e) {
+    if (s.available[e])
+      std::fprintf(out, " %12.4f", s.perElement(PerfEvent(e)));
+    else
+      std::fprintf(out, " %12s", "n/a");
+  }
+  std::fprintf(out, "\n");
+}
+
+/**
+ * @brief Prints header for measurements printed by printPerElement
+ * @param out Output stream
+ */
+inline void printPerElementHeader(std::FILE * out) {
+  std::fprintf(out, "%-28s %13s", "operation (per element)", "time");
+  for (unsigned e = 0; e < perf_event_count; ++e)
+    std::fprintf(out, " %12s", perfEventName(PerfEvent(e)));
+  std::fprintf(out, "\n");
+}
+
+}
+
+#endif
@@ -0,0 +1,228 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_polycollection.hpp
+ * Heterogeneous collection of shapes from geo.hpp sorted by type. Each
+ * concrete shape class is kept in its own contiguous segment, so iteration
+ * dispatches once per segment instead of once per shape.
+ */
+
+#ifndef GEO_POLYCOLLECTION_HPP
+#define GEO_POLYCOLLECTION_HPP
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <vector>
+
+#include "geo.hpp"
+
+namespace Geo {
+
+/**
+ * @brief Collection of shapes segmented by concrete type
+ *
+ * Shapes are stored by value in one vector per type (circles, rectangles,
+ * squares, spheres and cubes). Algorithms visit segment by segment with the
+ * concrete type known, so the calls to the final classes' methods are not
+ * virtual and inner loops could be vectorized. Iteration by Shape reference
+ * is available as well for code working with the generic interface.
+ */
+class PolyCollection {
+private:
+  typedef std::tuple<std::vector<Circle>,
+                     std::vector<Rectangle>,
+                     std::vector<Square>,
+                     std::vector<Sphere>,
+                     std::vector<Cube> > Segments;
+
+  Segments segs;
+
+public:
+  /** @brief Number of segments (i.e. concrete shape types) */
+  static constexpr std::size_t segment_count = std::tuple_size<Segments>::value;
+
+  /**
+   * @brief Adds shape to the segment of its type
+   * @param s Shape of concrete type
+   */
+  template <class T>
+  void insert(const T & s) { segment<T>().push_back(s); }
+
+  /**
+   * @brief Retrieves the segment of given concrete type
+   * @return Vector with all shapes of type T
+   */
+  template <class T>
+  std::vector<T> & segment(void) { return std::get<std::vector<T> >(segs); }
+  /** @copydoc segment */
+  template <class T>
+  const std::vector<T> & segment(void) const { return std::get<std::vector<T> >(segs); }
+
+  /** @brief Retrieves total number of shapes */
+  std::size_t size(void) const {
+    return std::apply([](const auto & ... v) { return (v.size() + ...); }, segs);
+  }
+  /** @brief Checks whether the collection is empty */
+  bool empty(void) const { return size() == 0; }
+  /** @brief Removes all shapes */
+  void clear(void) { std::apply([](auto & ... v) { (v.clear(), ...); }, segs); }
+
+  /**
+   * @brief Visits each segment
+   * @param f Function called once per segment with a vector of concrete type
+   */
+  template <class F>
+  void forEachSegment(F f) { std::apply([&f](auto & ... v) { (f(v), ...); }, segs); }
+
+  /**
+   * @brief Visits each shape
+   *
+   * The function is called with a reference to the concrete type, so it's
+   * instantiated for each segment and calls within are resolved statically.
+   * A function taking Shape reference could be passed as well.
+   * @param f Function called with each shape
+   */
+  template <class F>
+  void forEach(F f) {
+    forEachSegment([&f](auto & v) {
+      for (auto & s : v)
+        f(s);
+    });
+  }
+
+  /** @brief Calculates total area of all shapes */
+  double totalArea(void) {
+    double total = 0;
+    forEach([&total](auto & s) { total += s.area(); });
+    return total;
+  }
+  /** @brief Calculates total perimeter of all shapes */
+  double totalPerimeter(void) {
+    double total = 0;
+    forEach([&total](auto & s) { total += s.perimeter(); });
+    return total;
+  }
+  /** @brief Calculates total volume of all three dimensional shapes */
+  double totalVolume(void) {
+    double total = 0;
+    for (auto & s : segment<Sphere>())
+      total += s.volume();
+    for (auto & s : segment<Cube>())
+      total += s.volume();
+    return total;
+  }
+
+  /**
+   * @brief Evaluates a metric expression for each shape
+   *
+   * The expression (see geo_expr.hpp) is evaluated in a single pass with
+   * shapes' concrete types known, in the order of segments.
+   * @param e Metric expression (e.g. <code>area() / perimeter()</code>)
+   * @return Vector with results
+   */
+  template <class E>
+  std::vector<double> compute(const E & e) {
+    std::vector<double> res;
+    res.reserve(size());
+    forEach([&](auto & s) { res.push_back(e(s)); });
+    return res;
+  }
+
+  /**
+   * @brief Evaluates several metric expressions in a single pass
+   * @param e Metric expressions
+   * @return One vector of results per expression
+   */
+  template <class ... E>
+  std::array<std::vector<double>, sizeof...(E)> computeAll(const E & ... e) {
+    std::array<std::vector<double>, sizeof...(E)> res;
+    for (auto & v : res)
+      v.reserve(size());
+    forEach([&](auto & s) {
+      std::size_t i = 0;
+      ((res[i++].push_back(e(s))), ...);
+    });
+    return res;
+  }
+
+  /** @brief Forward iterator over the collection as generic shapes */
+  class iterator {
+  private:
+    PolyCollection * coll;
+    std::size_t seg;
+    std::size_t idx;
+
+    std::size_t segSize(std::size_t i) const {
+      std::size_t n = 0, k = 0;
+      coll->forEachSegment([&](auto & v) { if (k++ == i) n = v.size(); });
+      return n;
+    }
+    void skipEmpty(void) {
+      while (seg < segment_count && idx >= segSize(seg)) {
+        ++seg;
+        idx = 0;
+      }
+    }
+
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Shape value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Shape * pointer;
+    typedef Shape & reference;
+
+    /**
+     * @brief Construct iterator at given position
+     * @param c Collection
+     * @param s Segment index
+     * @param i Index within the segment
+     */
+    iterator(PolyCollection * c, std::size_t s, std::size_t i)
+      : coll(c), seg(s), idx(i) { skipEmpty(); }
+
+    /** @brief Retrieves current shape */
+    Shape & operator*(void) const {
+      Shape * p = nullptr;
+      std::size_t k = 0;
+      coll->forEachSegment([&](auto & v) { if (k++ == seg) p = &v[idx]; });
+      return *p;
+    }
+    /** @brief Retrieves pointer to current shape */
+    Shape * operator->(void) const { return &**this; }
+    /** @brief Advances to next shape */
+    iterator & operator++(void) { ++idx; skipEmpty(); return *this; }
+    /** @brief Advances to next shape */
+    iterator operator++(int) { iterator t(*this); ++*this; return t; }
+    /** @brief Compares iterators for equality */
+    bool operator==(const iterator & o) const { return seg == o.seg && idx == o.idx; }
+    /** @brief Compares iterators for inequality */
+    bool operator!=(const iterator & o) const { return !(*this == o); }
+  };
+
+  /** @brief Retrieves iterator to the first shape */
+  iterator begin(void) { return iterator(this, 0, 0); }
+  /** @brief Retrieves iterator past the last shape */
+  iterator end(void) { return iterator(this, segment_count, 0); }
+};
+
+}
+
+#endif
@@ -0,0 +1,327 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_quantized.hpp
+ * Storage of shapes with coordinates and dimensions quantized to 16 or 32
+ * bit fixed point offsets from an origin of each block. Measures are
+ * calculated directly from quantized columns, which are two or four times
+ * smaller than columns of doubles, so scans need less memory bandwidth.
+ */
+
+#ifndef GEO_QUANTIZED_HPP
+#define GEO_QUANTIZED_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "geo_dispatch.hpp"
+
+namespace Geo {
+
+/**
+ * @brief Input of quantized measure kernels
+ *
+ * Dimensions of shapes are \f$a_0 + q_a s_a\f$ and \f$b_0 + q_b s_b\f$,
+ * where \f$q\f$ are the stored offsets. Shapes in a batch could be of
+ * different types. Kernels for double take the columns of ShapeStore with
+ * zero origins and unit scales.
+ */
+template <class Q>
+struct QuantizedBatch {
+  /** @brief Shape types */
+  const ShapeType * t;
+  /** @brief Offsets of dimensions A */
+  const Q * a;
+  /** @brief Offsets of dimensions B */
+  const Q * b;
+  /** @brief Origin of dimensions A */
+  double a0;
+  /** @brief Scale of dimensions A */
+  double as;
+  /** @brief Origin of dimensions B */
+  double b0;
+  /** @brief Scale of dimensions B */
+  double bs;
+  /** @brief Number of shapes */
+  std::size_t n;
+};
+
+/** @brief Quantized measure kernel calculating measures into output array */
+template <class Q>
+using QuantizedKernelFn = void (*)(const QuantizedBatch<Q> & in, double * out);
+
+namespace detail {
+
+/*
+ * Every measure of every shape type is a polynomial of its dimensions:
+ * area is \f$(k_1 a + k_2 b) a\f$, perimeter \f$k_1 a + k_2 b\f$ and volume
+ * \f$k_1 a^3\f$, so a single loop handles mixed types by taking the
+ * coefficients from tables.
+ */
+struct MeasureCoeffs {
+  double k1[shape_type_count];
+  double k2[shape_type_count];
+};
+
+alignas(64) constexpr MeasureCoeffs measure_coeffs[measure_count] = {
+  /*                   Circle    Rect Square Sphere            Cube */
+  /* Area      */ { { M_PI,      0,   1,     4 * M_PI,         6 },
+                    { 0,         1,   0,     0,                0 } },
+  /* Perimeter */ { { 2 * M_PI,  2,   4,     2 * M_PI,         0 },
+                    { 0,         2,   0,     0,                0 } },
+  /* Volume    */ { { 0,         0,   0,     4.0 / 3.0 * M_PI, 1 },
+                    { 0,         0,   0,     0,                0 } }
+};
+
+template <Measure M>
+inline __attribute__((always_inline)) double mixedFormula(const MeasureCoeffs & k, ShapeType t, double a, double b) {
+  const unsigned s = unsigned(t);
+  if constexpr (M == Measure::Area)
+    return (coeff(k.k1, s) * a + coeff(k.k2, s) * b) * a;
+  else if constexpr (M == Measure::Perimeter)
+    return coeff(k.k1, s) * a + coeff(k.k2, s) * b;
+  else
+    return coeff(k.k1, s) * a * a * a;
+}
+
+template <Measure M, class Q>
+struct QuantizedLoop {
+  template <bool Simd>
+  static inline __attribute__((always_inline)) void run(const QuantizedBatch<Q> & in, double * __restrict out) {
+    const ShapeType * __restrict t = in.t;
+    const Q * __restrict a = in.a;
+    const Q * __restrict b = in.b;
+    const double a0 = in.a0, as = in.as, b0 = in.b0, bs = in.bs;
+    const std::size_t n = in.n;
+#pragma omp simd if(simd: Simd)
+    for (std::size_t i = 0; i < n; ++i)
+      out[i] = mixedFormula<M>(measure_coeffs[unsigned(M)], t[i], a0 + double(a[i]) * as, b0 + double(b[i]) * bs);
+  }
+};
+
+/* Shape types are bytes, so kernels of AVX-512 level need AVX-512BW */
+template <Measure M, class Q>
+using QuantizedKernel = IsaKernel<QuantizedKernelFn<Q>, QuantizedLoop<M, Q>, true>;
+
+}
+
+/**
+ * @brief Selects quantized measure kernel compiled for an instruction set level
+ *
+ * The caller is responsible for the processor supporting the level. Kernels
+ * of AVX-512 level are replaced by AVX2 ones on processors without AVX-512BW.
+ * @param m Measure
+ * @param isa Instruction set level
+ */
+template <class Q>
+QuantizedKernelFn<Q> quantizedKernel(Measure m, Isa isa) {
+  switch (m) {
+  case Measure::Area:
+    return detail::QuantizedKernel<Measure::Area, Q>::select(isa);
+  case Measure::Perimeter:
+    return detail::QuantizedKernel<Measure::Perimeter, Q>::select(isa);
+  default:
+    return detail::QuantizedKernel<Measure::Volume, Q>::select(isa);
+  }
+}
+
+/**
+ * @brief Selects quantized measure kernel for the active instruction set level
+ * @param m Measure
+ */
+template <class Q>
+QuantizedKernelFn<Q> dispatchQuantizedKernel(Measure m) {
+  return quantizedKernel<Q>(m, activeIsa());
+}
+
+/**
+ * @brief Columnar store of shapes with quantized coordinates and dimensions
+ *
+ * Built from a ShapeStore with the same blocks. Each block keeps origin and
+ * scale of every column, taken from the minimum and maximum in its zone
+ * map, so values are stored as offsets of Q steps (std::uint16_t or
+ * std::uint32_t) from the origin. Rounding to the nearest step makes the
+ * error of a value at most half a step. For a block whose values span
+ * 1000 units that is 0.008 with 16 bits and 1.2e-7 with 32 bits.
+ */
+template <class Q>
+class QuantizedStore {
+  static_assert(std::is_integral<Q>::value && std::is_unsigned<Q>::value,
+                "Offsets must be of unsigned integral type");
+
+public:
+  /** @brief Maximal offset */
+  static constexpr Q steps = std::numeric_limits<Q>::max();
+
+  /** @brief Origin and scale of columns of a block */
+  struct Frame {
+    /** @brief Value of offset zero of each column */
+    double origin[ShapeStore::column_count];
+    /** @brief Value of a step of each column */
+    double scale[ShapeStore::column_count];
+  };
+
+private:
+  std::size_t block_size;
+  std::vector<ShapeType> type_col;
+  std::vector<Q> cols[ShapeStore::column_count];
+  std::vector<Frame> frames;
+
+public:
+  /**
+   * @brief Construct quantized copy of a store
+   * @param s Store of shapes in double precision
+   */
+  explicit QuantizedStore(const ShapeStore & s)
+    : block_size(s.blockSize()), type_col(s.types(), s.types() + s.size()), frames(s.blockCount()) {
+    const std::size_t n = s.size();
+    for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+      cols[c].resize(n);
+    for (std::size_t blk = 0; blk < frames.size(); ++blk) {
+      const ShapeStore::ZoneMap & zm = s.zone(blk);
+      const std::size_t first = blk * block_size;
+      const std::size_t last = std::min(first + block_size, n);
+      for (unsigned c = 0; c < ShapeStore::column_count; ++c) {
+        const double range = zm.max[c] - zm.min[c];
+        /* Columns constant in the block (like B of all but rectangles)
+         * have zero scale and are exact */
+        const double scale = range > 0 ? range / steps : 0;
+        frames[blk].origin[c] = zm.min[c];
+        frames[blk].scale[c] = scale;
+        if (scale == 0)
+          continue;
+        const double * v = s.column(ShapeStore::Column(c));
+        for (std::size_t i = first; i < last; ++i) {
+          const double q = std::nearbyint((v[i] - zm.min[c]) / scale);
+          cols[c][i] = Q(std::min(std::max(q, 0.0), double(steps)));
+        }
+      }
+    }
+  }
+
+  /** @brief Retrieves number of shapes */
+  std::size_t size(void) const { return type_col.size(); }
+  /** @brief Retrieves number of rows in a block */
+  std::size_t blockSize(void) const { return block_size; }
+  /** @brief Retrieves number of blocks */
+  std::size_t blockCount(void) const { return frames.size(); }
+  /** @brief Retrieves origin and scale of columns of a block */
+  const Frame & frame(std::size_t blk) const { return frames[blk]; }
+  /** @brief Retrieves number of bytes of columns */
+  std::size_t bytes(void) const {
+    return size() * (sizeof(ShapeType) + ShapeStore::column_count * sizeof(Q)) + frames.size() * sizeof(Frame);
+  }
+
+  /** @brief Retrieves column with shape types */
+  const ShapeType * types(void) const { return type_col.data(); }
+  /** @brief Retrieves column of offsets */
+  const Q * column(ShapeStore::Column c) const { return cols[unsigned(c)].data(); }
+
+  /** @brief Retrieves shape's type */
+  ShapeType type(std::size_t i) const { return type_col[i]; }
+  /** @brief Retrieves value of numeric column for a shape */
+  double value(ShapeStore::Column c, std::size_t i) const {
+    const Frame & f = frames[i / block_size];
+    return f.origin[unsigned(c)] + double(cols[unsigned(c)][i]) * f.scale[unsigned(c)];
+  }
+  /**
+   * @brief Retrieves maximal error of a column
+   * @return Half of the largest step among blocks
+   */
+  double maxError(ShapeStore::Column c) const {
+    double e = 0;
+    for (const Frame & f : frames)
+      e = std::max(e, f.scale[unsigned(c)] / 2);
+    return e;
+  }
+
+  /**
+   * @brief Calculates measure of a shape
+   * @param m Measure
+   * @param i Index of the shape
+   */
+  double measure(Measure m, std::size_t i) const {
+    return Geo::measure(m, type_col[i], value(ShapeStore::Column::A, i), value(ShapeStore::Column::B, i));
+  }
+
+  /**
+   * @brief Calculates measure of all shapes
+   * @param m Measure
+   * @param out Output array for size() values
+   */
+  void measure(Measure m, double * out) const {
+    measure(out, dispatchQuantizedKernel<Q>(m));
+  }
+  /**
+   * @brief Calculates measure of all shapes with a kernel
+   * @param out Output array for size() values
+   * @param k Kernel (e.g. compiled for a specific instruction set level)
+   */
+  void measure(double * out, QuantizedKernelFn<Q> k) const {
+    for (std::size_t blk = 0; blk < frames.size(); ++blk)
+      k(batch(blk), out + blk * block_size);
+  }
+
+  /**
+   * @brief Calculates sum of a measure over all shapes
+   *
+   * Measures of each block are calculated in a buffer, which stays in cache.
+   * @param m Measure
+   */
+  double sum(Measure m) const {
+    const QuantizedKernelFn<Q> k = dispatchQuantizedKernel<Q>(m);
+    std::vector<double> buf(block_size);
+    double total = 0;
+    for (std::size_t blk = 0; blk < frames.size(); ++blk) {
+      const QuantizedBatch<Q> in = batch(blk);
+      k(in, buf.data());
+#pragma omp simd reduction(+ : total)
+      for (std::size_t i = 0; i < in.n; ++i)
+        total += buf[i];
+    }
+    return total;
+  }
+
+  /**
+   * @brief Retrieves input of kernels for a block
+   * @param blk Block index
+   */
+  QuantizedBatch<Q> batch(std::size_t blk) const {
+    const std::size_t first = blk * block_size;
+    const Frame & f = frames[blk];
+    const unsigned a = unsigned(ShapeStore::Column::A), b = unsigned(ShapeStore::Column::B);
+    return QuantizedBatch<Q> { type_col.data() + first, cols[a].data() + first, cols[b].data() + first,
+                               f.origin[a], f.scale[a], f.origin[b], f.scale[b],
+                               std::min(block_size, size() - first) };
+  }
+};
+
+/** @brief Store with 16 bit offsets */
+typedef QuantizedStore<std::uint16_t> QuantizedStore16;
+/** @brief Store with 32 bit offsets */
+typedef QuantizedStore<std::uint32_t> QuantizedStore32;
+
+}
+
+#endif
@@ -0,0 +1,407 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_query.hpp
+ * Small query language over the columnar store from geo_store.hpp, e.g.
+ * <code>select volume where type == Sphere and radius > 2.0 and z between 0 and 10</code>.
+ * Queries are compiled into a plan, which skips blocks by their zone maps,
+ * filters the remaining ones by column scans producing selection vectors and
+ * only then calculates the measure for the surviving shapes.
+ */
+
+#ifndef GEO_QUERY_HPP
+#define GEO_QUERY_HPP
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "geo_store.hpp"
+
+namespace Geo {
+
+/**
+ * @brief Compiled query over shape store
+ *
+ * Syntax is <code>select (count|area|perimeter|volume) [where predicate
+ * [and predicate]...]</code>, where predicate is one of
+ * <ul>
+ * <li><code>type (==|!=) Name</code> with name of shape class;</li>
+ * <li><code>type in (Name, ...)</code>;</li>
+ * <li><code>column (==|<|<=|>|>=) number</code>;</li>
+ * <li><code>column between number and number</code>.</li>
+ * </ul>
+ * Columns are <code>x</code>, <code>y</code>, <code>z</code> and dimensions
+ * <code>radius</code> (circles and spheres), <code>width</code> and
+ * <code>height</code> (rectangles), <code>side</code> (squares) and
+ * <code>edge</code> (cubes). Predicates on dimensions also restrict the
+ * types of shapes. Measures <code>area</code>, <code>perimeter</code> and
+ * <code>volume</code> could be used in predicates too, in which case blocks
+ * are skipped by the measures' zone maps and the measure is calculated only
+ * for the rows, which passed the other predicates. Keywords are case
+ * insensitive.
+ */
+class Query {
+public:
+  /** @brief What the query calculates */
+  enum class Select {
+    Count,
+    Area,
+    Perimeter,
+    Volume
+  };
+
+  /** @brief Result of query execution */
+  struct Result {
+    /** @brief Number of matching shapes */
+    std::size_t count = 0;
+    /** @brief Sum of the measure over matching shapes */
+    double sum = 0;
+    /** @brief Indexes of matching shapes (if collected) */
+    std::vector<std::uint32_t> rows;
+    /** @brief Measure for each matching shape (if collected) */
+    std::vector<double> values;
+    /** @brief Number of scanned blocks */
+    std::size_t blocks_scanned = 0;
+    /** @brief Number of blocks skipped by zone maps */
+    std::size_t blocks_skipped = 0;
+  };
+
+private:
+  typedef ShapeStore::Column Column;
+  static constexpr unsigned ncols = ShapeStore::column_count;
+  /* Fields are the columns followed by the measures */
+  static constexpr unsigned nfields = ncols + measure_count;
+
+  Select what;
+  std::uint8_t types;
+  bool active[nfields];
+  double lo[nfields];
+  double hi[nfields];
+
+  /* Tokenizer */
+  struct Lexer {
+    const std::string & s;
+    std::size_t pos;
+
+    explicit Lexer(const std::string & str) : s(str), pos(0) {}
+
+    std::string next(void) {
+      while (pos < s.size() && std::isspace((unsigned char)s[pos]))
+        ++pos;
+      if (pos >= s.size())
+        return std::string();
+      std::size_t st = pos;
+      char c = s[pos];
+      if (std::isalpha((unsigned char)c) || c == '_') {
+        while (pos < s.size() && (std::isalnum((unsigned char)s[pos]) || s[pos] == '_'))
+          ++pos;
+      } else if (std::isdigit((unsigned char)c) || c == '.' || c == '-' || c == '+') {
+        ++pos;
+        while (pos < s.size() && (std::isalnum((unsigned char)s[pos]) || s[pos] == '.' ||
+               ((s[pos] == '-' || s[pos] == '+') && (s[pos - 1] == 'e' || s[pos - 1] == 'E'))))
+          ++pos;
+      } else if ((c == '<' || c == '>' || c == '=' || c == '!') &&
+                 pos + 1 < s.size() && s[pos + 1] == '=') {
+        pos += 2;
+      } else {
+        ++pos;
+      }
+      return s.substr(st, pos - st);
+    }
+  };
+
+  static std::string lower(std::string s) {
+    for (auto & c : s)
+      c = char(std::tolower((unsigned char)c));
+    return s;
+  }
+
+  static void fail(const std::string & msg) {
+    throw std::invalid_argument("Geo::Query: " + msg);
+  }
+
+  static double number(const std::string & tok) {
+    char * end = nullptr;
+    double v = std::strtod(tok.c_str(), &end);
+    if (tok.empty() || *end != '\0')
+      fail("number expected instead of '" + tok + "'");
+    return v;
+  }
+
+  static ShapeType typeOf(const std::string & tok) {
+    for (unsigned t = 0; t < shape_type_count; ++t)
+      if (lower(typeName(ShapeType(t))) == lower(tok))
+        return ShapeType(t);
+    fail("unknown shape type '" + tok + "'");
+    return ShapeType::Circle;
+  }
+
+  void restrict(unsigned i, double l, double h) {
+    if (!active[i]) {
+      active[i] = true;
+      lo[i] = l;
+      hi[i] = h;
+    } else {
+      lo[i] = std::max(lo[i], l);
+      hi[i] = std::min(hi[i], h);
+    }
+  }
+
+  void predicate(Lexer & lx) {
+    std::string col = lower(lx.next());
+    if (col == "type") {
+      std::string op = lower(lx.next());
+      if (op == "==" || op == "=") {
+        types &= typeBit(typeOf(lx.next()));
+      } else if (op == "!=") {
+        types &= std::uint8_t(~typeBit(typeOf(lx.next())));
+      } else if (op == "in") {
+        if (lx.next() != "(")
+          fail("'(' expected after 'in'");
+        std::uint8_t m = 0;
+        for (;;) {
+          m |= typeBit(typeOf(lx.next()));
+          std::string sep = lx.next();
+          if (sep == ")")
+            break;
+          if (sep != ",")
+            fail("',' or ')' expected in type list");
+        }
+        types &= m;
+      } else {
+        fail("unsupported operator '" + op + "' for type");
+      }
+      return;
+    }
+
+    unsigned c;
+    std::uint8_t m = all_types;
+    if (col == "x") c = unsigned(Column::X);
+    else if (col == "y") c = unsigned(Column::Y);
+    else if (col == "z") c = unsigned(Column::Z);
+    else if (col == "radius") { c = unsigned(Column::A); m = typeBit(ShapeType::Circle) | typeBit(ShapeType::Sphere); }
+    else if (col == "width")  { c = unsigned(Column::A); m = typeBit(ShapeType::Rectangle); }
+    else if (col == "height") { c = unsigned(Column::B); m = typeBit(ShapeType::Rectangle); }
+    else if (col == "side")   { c = unsigned(Column::A); m = typeBit(ShapeType::Square); }
+    else if (col == "edge")   { c = unsigned(Column::A); m = typeBit(ShapeType::Cube); }
+    else if (col == "area")      c = ncols + unsigned(Measure::Area);
+    else if (col == "perimeter") c = ncols + unsigned(Measure::Perimeter);
+    else if (col == "volume")    c = ncols + unsigned(Measure::Volume);
+    else { fail("unknown column '" + col + "'"); return; }
+    types &= m;
+
+    const double inf = std::numeric_limits<double>::infinity();
+    std::string op = lower(lx.next());
+    if (op == "between") {
+      double l = number(lx.next());
+      if (lower(lx.next()) != "and")
+        fail("'and' expected in 'between'");
+      restrict(c, l, number(lx.next()));
+    } else {
+      double v = number(lx.next());
+      if (op == "==" || op == "=") restrict(c, v, v);
+      else if (op == "<")  restrict(c, -inf, std::nextafter(v, -inf));
+      else if (op == "<=") restrict(c, -inf, v);
+      else if (op == ">")  restrict(c, std::nextafter(v, inf), inf);
+      else if (op == ">=") restrict(c, v, inf);
+      else fail("unsupported operator '" + op + "'");
+    }
+  }
+
+  Query() : what(Select::Count), types(all_types) {
+    for (unsigned i = 0; i < nfields; ++i) {
+      active[i] = false;
+      lo[i] = -std::numeric_limits<double>::infinity();
+      hi[i] = std::numeric_limits<double>::infinity();
+    }
+  }
+
+public:
+  /**
+   * @brief Compiles query from its text
+   * @param text Query text
+   * @return Compiled query
+   * @throw std::invalid_argument On syntax errors
+   */
+  static Query parse(const std::string & text) {
+    Query q;
+    Lexer lx(text);
+    if (lower(lx.next()) != "select")
+      fail("query must start with 'select'");
+    std::string w = lower(lx.next());
+    if (w == "count") q.what = Select::Count;
+    else if (w == "area") q.what = Select::Area;
+    else if (w == "perimeter") q.what = Select::Perimeter;
+    else if (w == "volume") q.what = Select::Volume;
+    else fail("unknown selection '" + w + "'");
+
+    std::string t = lower(lx.next());
+    if (t.empty())
+      return q;
+    if (t != "where")
+      fail("'where' expected instead of '" + t + "'");
+    for (;;) {
+      q.predicate(lx);
+      t = lower(lx.next());
+      if (t.empty())
+        break;
+      if (t != "and")
+        fail("'and' expected instead of '" + t + "'");
+    }
+    return q;
+  }
+
+  /** @brief Describes the compiled plan */
+  std::string explain(void) const {
+    static const char * const names[nfields] = {
+      "x", "y", "z", "a", "b", "area", "perimeter", "volume"
+    };
+    std::ostringstream os;
+    os << "types:";
+    for (unsigned t = 0; t < shape_type_count; ++t)
+      if (types & typeBit(ShapeType(t)))
+        os << ' ' << typeName(ShapeType(t));
+    for (unsigned i = 0; i < nfields; ++i)
+      if (active[i])
+        os << "; " << names[i] << " in [" << lo[i] << ", " << hi[i] << "]";
+    return os.str();
+  }
+
+  /**
+   * @brief Executes the query
+   * @param store Shape store
+   * @param collect Whether to collect matching rows and values
+   * @return Query result
+   */
+  Result run(const ShapeStore & store, bool collect = true) const {
+    Result res;
+    const std::size_t bs = store.blockSize();
+    std::vector<std::uint32_t> sel(bs);
+    std::vector<double> vals(bs);
+    std::vector<std::uint8_t> keep(bs);
+    const ShapeType * tcol = store.types();
+
+    for (std::size_t blk = 0; blk < store.blockCount(); ++blk) {
+      const ShapeStore::ZoneMap & zm = store.zone(blk);
+      bool skip = (zm.types & types) == 0;
+      unsigned scan[nfields];
+      unsigned nscan = 0;
+      for (unsigned i = 0; i < nfields && !skip; ++i) {
+        if (!active[i])
+          continue;
+        const bool col = i < ncols;
+        if (col ? !zm.mayContain(Column(i), lo[i], hi[i])
+                : !zm.mayContain(Measure(i - ncols), lo[i], hi[i]))
+          skip = true;
+        else if (col ? !zm.within(Column(i), lo[i], hi[i])
+                     : !zm.within(Measure(i - ncols), lo[i], hi[i]))
+          scan[nscan++] = i;
+      }
+      if (skip) {
+        ++res.blocks_skipped;
+        continue;
+      }
+      ++res.blocks_scanned;
+
+      const std::size_t first = blk * bs;
+      const std::size_t n = std::min(bs, store.size() - first);
+      /* Predicates on columns are evaluated over the whole block into
+       * flags in branch-free loops, which vectorize, and the matching rows
+       * are then compacted into the selection vector once */
+      std::uint8_t * __restrict f = keep.data();
+      if ((zm.types & ~types) == 0)
+        std::fill(f, f + n, std::uint8_t(1));
+      else {
+        /* Flags of types are selected by comparisons, since bytes can't be
+         * shifted by vector elements */
+        const ShapeType * __restrict t = tcol + first;
+        std::uint8_t tf[shape_type_count];
+        for (unsigned s = 0; s < shape_type_count; ++s)
+          tf[s] = std::uint8_t((types >> s) & 1u);
+#pragma omp simd
+        for (std::size_t i = 0; i < n; ++i) {
+          const std::uint8_t s = std::uint8_t(t[i]);
+          std::uint8_t r = tf[0];
+          r = s == 1 ? tf[1] : r;
+          r = s == 2 ? tf[2] : r;
+          r = s == 3 ? tf[3] : r;
+          r = s == 4 ? tf[4] : r;
+          f[i] = r;
+        }
+      }
+      unsigned k = 0;
+      for (; k < nscan && scan[k] < ncols; ++k) {
+        const unsigned c = scan[k];
+        const double l = lo[c], h = hi[c];
+        const double * __restrict v = store.column(Column(c)) + first;
+#pragma omp simd
+        for (std::size_t i = 0; i < n; ++i)
+          f[i] = (v[i] >= l) & (v[i] <= h) ? f[i] : std::uint8_t(0);
+      }
+      std::size_t m = 0;
+      for (std::size_t i = 0; i < n; ++i) {
+        sel[m] = std::uint32_t(first + i);
+        m += f[i];
+      }
+      /* Measures are scanned last, so only for the surviving rows */
+      for (; k < nscan && m > 0; ++k) {
+        const unsigned c = scan[k];
+        const double l = lo[c], h = hi[c];
+        store.measure(Measure(c - ncols), sel.data(), m, vals.data());
+        std::fill(f, f + m, std::uint8_t(1));
+#pragma omp simd
+        for (std::size_t i = 0; i < m; ++i)
+          f[i] = (vals[i] >= l) & (vals[i] <= h) ? f[i] : std::uint8_t(0);
+        std::size_t j = 0;
+        for (std::size_t i = 0; i < m; ++i) {
+          sel[j] = sel[i];
+          j += f[i];
+        }
+        m = j;
+      }
+
+      res.count += m;
+      if (what != Select::Count) {
+        const Measure ms = what == Select::Area ? Measure::Area :
+                           what == Select::Perimeter ? Measure::Perimeter : Measure::Volume;
+        store.measure(ms, sel.data(), m, vals.data());
+        for (std::size_t i = 0; i < m; ++i)
+          res.sum += vals[i];
+        if (collect)
+          res.values.insert(res.values.end(), vals.begin(), vals.begin() + m);
+      }
+      if (collect)
+        res.rows.insert(res.rows.end(), sel.begin(), sel.begin() + m);
+    }
+    return res;
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,612 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_ray.hpp
+ * Ray casting against shapes. Rays in the plane hit circles, rectangles and
+ * squares, while rays in space hit spheres and cubes. Shapes of a store are
+ * organized in bounding volume hierarchies (one for each dimension), which
+ * are traversed by single rays or by packets of 4, 8 or 16 rays tested
+ * together in SIMD loops. Batches of rays are cast in parallel.
+ */
+
+#ifndef GEO_RAY_HPP
+#define GEO_RAY_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "geo_bounds.hpp"
+#include "geo_dispatch.hpp"
+
+namespace Geo {
+
+/**
+ * @brief Ray in two dimensions
+ *
+ * Points of the ray are \f$o + t d\f$ for \f$0 \le t \le t_{max}\f$, so
+ * distances are in lengths of the direction (Euclidean for unit directions).
+ */
+struct Ray2D {
+  /** @brief Origin */
+  Coord2D origin;
+  /** @brief Direction (not zero) */
+  Coord2D dir;
+  /** @brief Maximal distance */
+  double tmax = std::numeric_limits<double>::infinity();
+};
+
+/** @brief Ray in three dimensions */
+struct Ray3D {
+  /** @brief Origin */
+  Coord3D origin;
+  /** @brief Direction (not zero) */
+  Coord3D dir;
+  /** @brief Maximal distance */
+  double tmax = std::numeric_limits<double>::infinity();
+};
+
+/**
+ * @brief Nearest hit of a ray
+ *
+ * Of shapes hit at the same distance the one with the lowest index wins, so
+ * hits do not depend on the way of traversal.
+ */
+struct RayHit {
+  /** @brief Identifier of no shape */
+  static constexpr std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+
+  /** @brief Distance to the hit (infinity when missed) */
+  double t;
+  /** @brief Index of the shape in the store or none */
+  std::uint32_t id;
+
+  /** @brief Checks whether the ray hit a shape */
+  constexpr bool hit(void) const { return id != none; }
+};
+
+namespace detail {
+
+constexpr double no_hit = std::numeric_limits<double>::infinity();
+
+/*
+ * Hit tests of ray l of a packet of N rays given by columns of components.
+ * Shapes are solid, so a ray starting inside hits at distance zero.
+ */
+template <unsigned D, unsigned N>
+inline __attribute__((always_inline))
+double ballHit(const double (&o)[D][N], const double (&d)[D][N], unsigned l,
+               const double (&c)[D], double r, double tmax) {
+  double dd = 0, fd = 0, ff = 0;
+#pragma GCC unroll 3
+  for (unsigned k = 0; k < D; ++k) {
+    const double f = o[k][l] - c[k];
+    dd += d[k][l] * d[k][l];
+    fd += f * d[k][l];
+    ff += f * f;
+  }
+  const double disc = fd * fd - dd * (ff - r * r);
+  const double s = std::sqrt(std::max(disc, 0.0));
+  const double t0 = (-fd - s) / dd, t1 = (-fd + s) / dd;
+  const double t = std::max(t0, 0.0);
+  return std::min(disc, t1) >= 0 && t <= tmax ? t : no_hit;
+}
+
+/* Slab test with inverse direction, whose infinite components make the
+ * slabs of parallel rays either empty or unbounded */
+template <unsigned D, unsigned N>
+inline __attribute__((always_inline))
+double boxHit(const double (&o)[D][N], const double (&inv)[D][N], unsigned l,
+              const double (&lo)[D], const double (&hi)[D], double tmax) {
+  double tn = 0, tf = tmax;
+#pragma GCC unroll 3
+  for (unsigned k = 0; k < D; ++k) {
+    const double t0 = (lo[k] - o[k][l]) * inv[k][l], t1 = (hi[k] - o[k][l]) * inv[k][l];
+    tn = std::max(tn, std::min(t0, t1));
+    tf = std::min(tf, std::max(t0, t1));
+  }
+  return tn <= tf ? tn : no_hit;
+}
+
+/*
+ * Hierarchy of bounding boxes of shapes of one dimension. Nodes are in
+ * depth-first order, so the left child of an inner node follows it and the
+ * right one is at index first. Leaves refer to count shapes starting at
+ * first, which are reordered, so shapes of a leaf are adjacent in memory.
+ * Round shapes are given by center and radius, the others by their boxes.
+ */
+template <unsigned D>
+class Bvh {
+public:
+  struct Node {
+    double lo[D];
+    double hi[D];
+    std::uint32_t first;
+    std::uint16_t count;
+    std::uint16_t axis;
+  };
+
+  /* Shape to insert. Round shapes keep their exact center, since the one
+   * of their box differs from it by rounding. */
+  struct Prim {
+    double lo[D];
+    double hi[D];
+    double radius;
+    bool round;
+    std::uint32_t id;
+    double center[D];
+  };
+
+private:
+  std::vector<Node> nodes;
+  /* Box (or center in lo and radius) of each shape */
+  std::vector<double> plo[D];
+  std::vector<double> phi[D];
+  std::vector<double> prad;
+  std::vector<std::uint8_t> pround;
+  std::vector<std::uint32_t> pid;
+  std::size_t leaf_size;
+
+  std::uint32_t build(std::vector<Prim> & p, std::size_t first, std::size_t last) {
+    const std::uint32_t idx = std::uint32_t(nodes.size());
+    nodes.emplace_back();
+    Node n;
+    double clo[D], chi[D];
+    for (unsigned k = 0; k < D; ++k) {
+      n.lo[k] = clo[k] = std::numeric_limits<double>::infinity();
+      n.hi[k] = chi[k] = -std::numeric_limits<double>::infinity();
+    }
+    for (std::size_t i = first; i < last; ++i)
+      for (unsigned k = 0; k < D; ++k) {
+        n.lo[k] = std::min(n.lo[k], p[i].lo[k]);
+        n.hi[k] = std::max(n.hi[k], p[i].hi[k]);
+        const double c = p[i].lo[k] + p[i].hi[k];
+        clo[k] = std::min(clo[k], c);
+        chi[k] = std::max(chi[k], c);
+      }
+    unsigned axis = 0;
+    for (unsigned k = 1; k < D; ++k)
+      if (chi[k] - clo[k] > chi[axis] - clo[axis])
+        axis = k;
+    n.axis = std::uint16_t(axis);
+    /* Shapes with the same center could not be split, unless there are
+     * too many of them for a leaf */
+    if (last - first <= leaf_size ||
+        (chi[axis] == clo[axis] && last - first <= std::numeric_limits<std::uint16_t>::max())) {
+      n.first = std::uint32_t(plo[0].size());
+      n.count = std::uint16_t(last - first);
+      for (std::size_t i = first; i < last; ++i) {
+        for (unsigned k = 0; k < D; ++k) {
+          plo[k].push_back(p[i].round ? p[i].center[k] : p[i].lo[k]);
+          phi[k].push_back(p[i].hi[k]);
+        }
+        prad.push_back(p[i].radius);
+        pround.push_back(p[i].round);
+        pid.push_back(p[i].id);
+      }
+      nodes[idx] = n;
+      return idx;
+    }
+    /* Median split of centers along the longest axis */
+    const std::size_t mid = first + (last - first) / 2;
+    std::nth_element(p.begin() + first, p.begin() + mid, p.begin() + last, [axis](const Prim & a, const Prim & b) {
+      return a.lo[axis] + a.hi[axis] < b.lo[axis] + b.hi[axis];
+    });
+    n.count = 0;
+    build(p, first, mid);
+    n.first = build(p, mid, last);
+    nodes[idx] = n;
+    return idx;
+  }
+
+public:
+  Bvh() : leaf_size(4) {}
+
+  void build(std::vector<Prim> p, std::size_t leaf) {
+    leaf_size = std::min<std::size_t>(std::max<std::size_t>(leaf, 1), std::numeric_limits<std::uint16_t>::max());
+    nodes.clear();
+    nodes.reserve(2 * (p.size() / leaf_size + 1));
+    if (!p.empty())
+      build(p, 0, p.size());
+  }
+
+  std::size_t nodeCount(void) const { return nodes.size(); }
+  std::size_t size(void) const { return pid.size(); }
+
+  /* Distance to shape i of the reordered ones */
+  double primHit(std::size_t i, const double (&o)[D][1], const double (&d)[D][1], const double (&inv)[D][1],
+                 double tmax) const {
+    double lo[D], hi[D];
+    for (unsigned k = 0; k < D; ++k) {
+      lo[k] = plo[k][i];
+      hi[k] = phi[k][i];
+    }
+    return pround[i] ? ballHit(o, d, 0, lo, prad[i], tmax) : boxHit(o, inv, 0, lo, hi, tmax);
+  }
+
+  /* Calls f with the index of every shape, which box overlaps the query box */
+  template <class F>
+  void overlapping(const double (&lo)[D], const double (&hi)[D], F f) const {
+    const auto overlaps = [&](const double * a, const double * b) {
+      for (unsigned k = 0; k < D; ++k)
+        if (a[k] > hi[k] || b[k] < lo[k])
+          return false;
+      return true;
+    };
+    if (nodes.empty())
+      return;
+    std::uint32_t stack[64];
+    unsigned sp = 0;
+    stack[sp++] = 0;
+    while (sp) {
+      const Node & n = nodes[stack[--sp]];
+      if (!overlaps(n.lo, n.hi))
+        continue;
+      if (n.count) {
+        for (std::size_t i = n.first; i < n.first + n.count; ++i) {
+          double a[D], b[D];
+          for (unsigned k = 0; k < D; ++k) {
+            a[k] = pround[i] ? plo[k][i] - prad[i] : plo[k][i];
+            b[k] = phi[k][i];
+          }
+          if (overlaps(a, b))
+            f(pid[i]);
+        }
+      } else {
+        stack[sp++] = std::uint32_t(&n - nodes.data()) + 1;
+        stack[sp++] = n.first;
+      }
+    }
+  }
+
+  RayHit cast(const double (&o)[D][1], const double (&d)[D][1], double tmax) const {
+    RayHit best = { no_hit, RayHit::none };
+    if (nodes.empty())
+      return best;
+    double inv[D][1];
+    for (unsigned k = 0; k < D; ++k)
+      inv[k][0] = 1 / d[k][0];
+    std::uint32_t stack[64];
+    unsigned sp = 0;
+    stack[sp++] = 0;
+    while (sp) {
+      const Node & n = nodes[stack[--sp]];
+      if (boxHit(o, inv, 0, n.lo, n.hi, std::min(tmax, best.t)) == no_hit)
+        continue;
+      if (n.count) {
+        for (std::size_t i = n.first; i < n.first + n.count; ++i) {
+          const double t = primHit(i, o, d, inv, std::min(tmax, best.t));
+          if (t < best.t || (t == best.t && t != no_hit && pid[i] < best.id))
+            best = RayHit { t, pid[i] };
+        }
+      } else {
+        /* Nearer child is visited first */
+        const std::uint32_t left = std::uint32_t(&n - nodes.data()) + 1;
+        if (d[n.axis][0] < 0) {
+          stack[sp++] = left;
+          stack[sp++] = n.first;
+        } else {
+          stack[sp++] = n.first;
+          stack[sp++] = left;
+        }
+      }
+    }
+    return best;
+  }
+
+  /*
+   * Traverses the hierarchy with N rays at once. A node is entered when any
+   * ray of the packet hits its box closer than its best hit, and all rays
+   * are tested against shapes of a leaf in a SIMD loop.
+   */
+  template <unsigned N, bool Simd = true>
+  inline __attribute__((always_inline))
+  void castPacket(const double (&o)[D][N], const double (&d)[D][N], const double (&tmax)[N],
+                  double (&t)[N], std::uint32_t (&id)[N]) const {
+    double inv[D][N], limit[N];
+    for (unsigned l = 0; l < N; ++l) {
+      t[l] = no_hit;
+      id[l] = RayHit::none;
+      limit[l] = tmax[l];
+      for (unsigned k = 0; k < D; ++k)
+        inv[k][l] = 1 / d[k][l];
+    }
+    if (nodes.empty())
+      return;
+    std::uint32_t stack[64];
+    unsigned sp = 0;
+    stack[sp++] = 0;
+    while (sp) {
+      const Node & n = nodes[stack[--sp]];
+      int active = 0;
+#pragma omp simd if(simd: Simd) reduction(+ : active)
+      for (unsigned l = 0; l < N; ++l)
+        active += boxHit(o, inv, l, n.lo, n.hi, limit[l]) != no_hit ? 1 : 0;
+      if (!active)
+        continue;
+      if (n.count) {
+        for (std::size_t i = n.first; i < n.first + n.count; ++i) {
+          double c[D], h[D];
+          for (unsigned k = 0; k < D; ++k) {
+            c[k] = plo[k][i];
+            h[k] = phi[k][i];
+          }
+          const double r = prad[i];
+          const std::uint32_t pi = pid[i];
+          if (pround[i]) {
+#pragma omp simd if(simd: Simd)
+            for (unsigned l = 0; l < N; ++l) {
+              const double th = ballHit(o, d, l, c, r, limit[l]);
+              const bool closer = th < t[l] || (th == t[l] && th < no_hit && pi < id[l]);
+              t[l] = closer ? th : t[l];
+              id[l] = closer ? pi : id[l];
+              limit[l] = closer ? th : limit[l];
+            }
+          } else {
+#pragma omp simd if(simd: Simd)
+            for (unsigned l = 0; l < N; ++l) {
+              const double th = boxHit(o, inv, l, c, h, limit[l]);
+              const bool closer = th < t[l] || (th == t[l] && th < no_hit && pi < id[l]);
+              t[l] = closer ? th : t[l];
+              id[l] = closer ? pi : id[l];
+              limit[l] = closer ? th : limit[l];
+            }
+          }
+        }
+      } else {
+        const std::uint32_t left = std::uint32_t(&n - nodes.data()) + 1;
+        if (d[n.axis][0] < 0) {
+          stack[sp++] = left;
+          stack[sp++] = n.first;
+        } else {
+          stack[sp++] = n.first;
+          stack[sp++] = left;
+        }
+      }
+    }
+  }
+};
+
+/* Packet traversal compiled for every instruction set level */
+template <unsigned D, unsigned N>
+using PacketFn = void (*)(const Bvh<D> & b, const double (&o)[D][N], const double (&d)[D][N],
+                          const double (&tmax)[N], double (&t)[N], std::uint32_t (&id)[N]);
+
+template <unsigned D, unsigned N>
+struct PacketLoop {
+  template <bool Simd>
+  static inline __attribute__((always_inline))
+  void run(const Bvh<D> & b, const double (&o)[D][N], const double (&d)[D][N],
+           const double (&tmax)[N], double (&t)[N], std::uint32_t (&id)[N]) {
+    b.template castPacket<N, Simd>(o, d, tmax, t, id);
+  }
+};
+
+template <unsigned D, unsigned N>
+PacketFn<D, N> packetKernel(Isa isa) {
+  return IsaKernel<PacketFn<D, N>, PacketLoop<D, N>>::select(isa);
+}
+
+/* Stores ray as lane l of a packet */
+template <unsigned N>
+inline void load(const Ray2D & r, double (&o)[2][N], double (&d)[2][N], unsigned l) {
+  o[0][l] = r.origin.getX();
+  o[1][l] = r.origin.getY();
+  d[0][l] = r.dir.getX();
+  d[1][l] = r.dir.getY();
+}
+
+template <unsigned N>
+inline void load(const Ray3D & r, double (&o)[3][N], double (&d)[3][N], unsigned l) {
+  o[0][l] = r.origin.getX();
+  o[1][l] = r.origin.getY();
+  o[2][l] = r.origin.getZ();
+  d[0][l] = r.dir.getX();
+  d[1][l] = r.dir.getY();
+  d[2][l] = r.dir.getZ();
+}
+
+template <class R> struct RayDim;
+template <> struct RayDim<Ray2D> { static constexpr unsigned value = 2; };
+template <> struct RayDim<Ray3D> { static constexpr unsigned value = 3; };
+
+}
+
+/**
+ * @brief Calculates distance to the nearest point of a circle hit by a ray
+ * @param r Ray
+ * @param c Circle
+ * @return Distance or infinity when missed (zero when the origin is inside)
+ */
+inline double intersect(const Ray2D & r, Circle c) {
+  double o[2][1], d[2][1];
+  detail::load(r, o, d, 0);
+  const double ctr[2] = { c.getRefPoint().getX(), c.getRefPoint().getY() };
+  return detail::ballHit(o, d, 0, ctr, c.getRadius(), r.tmax);
+}
+
+/** @copydoc intersect(const Ray2D &, Circle) */
+inline double intersect(const Ray2D & r, Rectangle s) {
+  double o[2][1], d[2][1];
+  detail::load(r, o, d, 0);
+  const double inv[2][1] = { { 1 / d[0][0] }, { 1 / d[1][0] } };
+  const BoundingBox2D b = s.boundingBox();
+  const double lo[2] = { b.min.getX(), b.min.getY() }, hi[2] = { b.max.getX(), b.max.getY() };
+  return detail::boxHit(o, inv, 0, lo, hi, r.tmax);
+}
+
+/** @copydoc intersect(const Ray2D &, Circle) */
+inline double intersect(const Ray2D & r, Square s) {
+  return intersect(r, Rectangle(s.getRefPoint(), s.getSide(), s.getSide()));
+}
+
+/** @copydoc intersect(const Ray2D &, Circle) */
+inline double intersect(const Ray3D & r, Sphere s) {
+  double o[3][1], d[3][1];
+  detail::load(r, o, d, 0);
+  const Coord3D & c = s.getRefPoint();
+  const double ctr[3] = { c.getX(), c.getY(), c.getZ() };
+  return detail::ballHit(o, d, 0, ctr, s.getRadius(), r.tmax);
+}
+
+/** @copydoc intersect(const Ray2D &, Circle) */
+inline double intersect(const Ray3D & r, Cube s) {
+  double o[3][1], d[3][1];
+  detail::load(r, o, d, 0);
+  const double inv[3][1] = { { 1 / d[0][0] }, { 1 / d[1][0] }, { 1 / d[2][0] } };
+  const BoundingBox3D b = s.boundingBox();
+  const double lo[3] = { b.min.getX(), b.min.getY(), b.min.getZ() };
+  const double hi[3] = { b.max.getX(), b.max.getY(), b.max.getZ() };
+  return detail::boxHit(o, inv, 0, lo, hi, r.tmax);
+}
+
+/**
+ * @brief Shapes of a store prepared for ray casting
+ *
+ * Two dimensional shapes are kept in one hierarchy of bounding boxes and
+ * three dimensional ones in another, so rays in the plane hit only circles,
+ * rectangles and squares and rays in space only spheres and cubes. The
+ * scene is a snapshot: later changes of the store are not reflected.
+ */
+class RayScene {
+private:
+  detail::Bvh<2> bvh2;
+  detail::Bvh<3> bvh3;
+
+  const detail::Bvh<2> & bvh(const Ray2D *) const { return bvh2; }
+  const detail::Bvh<3> & bvh(const Ray3D *) const { return bvh3; }
+
+public:
+  /** @brief Default number of shapes in a leaf of the hierarchies */
+  static constexpr std::size_t default_leaf_size = 4;
+
+  /**
+   * @brief Construct scene of shapes in a store
+   * @param store Shapes
+   * @param leaf_size Maximal number of shapes in a leaf of the hierarchies
+   */
+  explicit RayScene(const ShapeStore & store, std::size_t leaf_size = default_leaf_size) {
+    const ShapeBounds b(store);
+    std::vector<detail::Bvh<2>::Prim> p2;
+    std::vector<detail::Bvh<3>::Prim> p3;
+    const double * cx = b.center(ShapeStore::Column::X), * cy = b.center(ShapeStore::Column::Y),
+                 * cz = b.center(ShapeStore::Column::Z);
+    for (std::size_t i = 0; i < store.size(); ++i) {
+      const ShapeType t = store.type(i);
+      const bool round = t == ShapeType::Circle || t == ShapeType::Sphere;
+      const BoundingBox3D box = b.box(i);
+      if (t == ShapeType::Sphere || t == ShapeType::Cube)
+        p3.push_back(detail::Bvh<3>::Prim {
+          { box.min.getX(), box.min.getY(), box.min.getZ() },
+          { box.max.getX(), box.max.getY(), box.max.getZ() },
+          b.radius()[i], round, std::uint32_t(i), { cx[i], cy[i], cz[i] } });
+      else
+        p2.push_back(detail::Bvh<2>::Prim {
+          { box.min.getX(), box.min.getY() }, { box.max.getX(), box.max.getY() },
+          b.radius()[i], round, std::uint32_t(i), { cx[i], cy[i] } });
+    }
+    bvh2.build(std::move(p2), leaf_size);
+    bvh3.build(std::move(p3), leaf_size);
+  }
+
+  /** @brief Retrieves number of two dimensional shapes */
+  std::size_t size2D(void) const { return bvh2.size(); }
+  /** @brief Retrieves number of three dimensional shapes */
+  std::size_t size3D(void) const { return bvh3.size(); }
+  /** @brief Retrieves number of nodes of both hierarchies */
+  std::size_t nodeCount(void) const { return bvh2.nodeCount() + bvh3.nodeCount(); }
+
+  /**
+   * @brief Finds the nearest shape hit by a ray
+   * @param r Ray in the plane (or in space)
+   * @return Distance and index of the shape in the store
+   */
+  template <class R>
+  RayHit cast(const R & r) const {
+    constexpr unsigned D = detail::RayDim<R>::value;
+    double o[D][1], d[D][1];
+    detail::load(r, o, d, 0);
+    return bvh(&r).cast(o, d, r.tmax);
+  }
+
+  /**
+   * @brief Finds the nearest shapes hit by a packet of rays
+   *
+   * Rays of a packet traverse the hierarchy together, so it is the fastest
+   * for coherent rays (e.g. with near origins and directions). Traversal is
+   * compiled for the active instruction set level.
+   * @param rays N rays (4, 8 or 16)
+   * @param out Output array for N hits
+   */
+  template <unsigned N, class R>
+  void castPacket(const R * rays, RayHit * out) const {
+    static_assert(N == 4 || N == 8 || N == 16, "Packets are of 4, 8 or 16 rays");
+    constexpr unsigned D = detail::RayDim<R>::value;
+    double o[D][N], d[D][N], tmax[N], t[N];
+    std::uint32_t id[N];
+    for (unsigned l = 0; l < N; ++l) {
+      detail::load(rays[l], o, d, l);
+      tmax[l] = rays[l].tmax;
+    }
+    static const detail::PacketFn<D, N> k = detail::packetKernel<D, N>(activeIsa());
+    k(bvh(rays), o, d, tmax, t, id);
+    for (unsigned l = 0; l < N; ++l)
+      out[l] = RayHit { t[l], id[l] };
+  }
+
+  /**
+   * @brief Finds the nearest shapes hit by a batch of rays in parallel
+   *
+   * Rays are cast in packets of N, which are claimed by the threads one by
+   * one. The remainder is cast ray by ray.
+   * @param rays Rays
+   * @param n Number of rays
+   * @param out Output array for n hits
+   * @param threads Number of threads (0 for the number of processors)
+   */
+  template <unsigned N = 8, class R>
+  void cast(const R * rays, std::size_t n, RayHit * out, unsigned threads = 0) const {
+    const std::size_t packets = n / N;
+    if (!threads)
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = unsigned(std::min<std::size_t>(threads, std::max<std::size_t>(packets, 1)));
+    std::atomic<std::size_t> next(0);
+    auto work = [&] {
+      for (std::size_t p; (p = next.fetch_add(1, std::memory_order_relaxed)) < packets; )
+        castPacket<N>(rays + p * N, out + p * N);
+    };
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i)
+      pool.emplace_back(work);
+    work();
+    for (std::thread & t : pool)
+      t.join();
+    for (std::size_t i = packets * N; i < n; ++i)
+      out[i] = cast(rays[i]);
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,633 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_sdf.hpp
+ * Signed distance functions of shapes and of CSG trees of them, negative
+ * inside and positive outside. Tapes of CSG trees are run over batches of
+ * points with the same instructions as for membership, but on distances,
+ * where union, intersection and difference are minimum, maximum and
+ * maximum with the negation. A sparse grid keeps distances sampled near the
+ * surface, which answers proximity queries there by interpolation.
+ */
+
+#ifndef GEO_SDF_HPP
+#define GEO_SDF_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "geo.hpp"
+#include "geo_csg.hpp"
+#include "geo_dispatch.hpp"
+
+namespace Geo {
+
+namespace detail {
+
+/* Distance to a circle or sphere given by center and radius */
+template <unsigned D>
+inline double ballDistance(const double (&c)[D], double r, const double (&p)[D]) {
+  double d = 0;
+  for (unsigned k = 0; k < D; ++k)
+    d += (p[k] - c[k]) * (p[k] - c[k]);
+  return std::sqrt(d) - r;
+}
+
+/* Distance to a box: the length of the excess over the box outside and the
+ * largest (negative) excess inside */
+template <unsigned D>
+inline double boxDistance(const double (&lo)[D], const double (&hi)[D], const double (&p)[D]) {
+  double out = 0, in = -std::numeric_limits<double>::infinity();
+  for (unsigned k = 0; k < D; ++k) {
+    const double q = std::abs(p[k] - (lo[k] + hi[k]) / 2) - (hi[k] - lo[k]) / 2;
+    out += std::max(q, 0.0) * std::max(q, 0.0);
+    in = std::max(in, q);
+  }
+  return std::sqrt(out) + std::min(in, 0.0);
+}
+
+template <unsigned D>
+inline double primitiveDistance(const CsgPrimitive<D> & t, const double (&p)[D]) {
+  return t.round ? ballDistance<D>(t.c, t.r, p) : boxDistance<D>(t.lo, t.hi, p);
+}
+
+}
+
+/**
+ * @brief Signed distance of a point to a circle
+ * @param c Circle
+ * @param p Point
+ * @return Distance, negative inside
+ */
+inline double signedDistance(Circle c, const Coord2D & p) {
+  const double cc[2] = { c.getRefPoint().getX(), c.getRefPoint().getY() }, q[2] = { p.getX(), p.getY() };
+  return detail::ballDistance<2>(cc, c.getRadius(), q);
+}
+
+/**
+ * @brief Signed distance of a point to a rectangle
+ * @param r Rectangle
+ * @param p Point
+ * @return Distance, negative inside
+ */
+inline double signedDistance(Rectangle r, const Coord2D & p) {
+  const BoundingBox2D b = r.boundingBox();
+  const double lo[2] = { b.min.getX(), b.min.getY() }, hi[2] = { b.max.getX(), b.max.getY() };
+  const double q[2] = { p.getX(), p.getY() };
+  return detail::boxDistance<2>(lo, hi, q);
+}
+
+/**
+ * @brief Signed distance of a point to a square
+ * @param s Square
+ * @param p Point
+ * @return Distance, negative inside
+ */
+inline double signedDistance(Square s, const Coord2D & p) {
+  const BoundingBox2D b = s.boundingBox();
+  const double lo[2] = { b.min.getX(), b.min.getY() }, hi[2] = { b.max.getX(), b.max.getY() };
+  const double q[2] = { p.getX(), p.getY() };
+  return detail::boxDistance<2>(lo, hi, q);
+}
+
+/**
+ * @brief Signed distance of a point to a sphere
+ * @param s Sphere
+ * @param p Point
+ * @return Distance, negative inside
+ */
+inline double signedDistance(Sphere s, const Coord3D & p) {
+  const Coord3D & c = s.getRefPoint();
+  const double cc[3] = { c.getX(), c.getY(), c.getZ() }, q[3] = { p.getX(), p.getY(), p.getZ() };
+  return detail::ballDistance<3>(cc, s.getRadius(), q);
+}
+
+/**
+ * @brief Signed distance of a point to a cube
+ * @param c Cube
+ * @param p Point
+ * @return Distance, negative inside
+ */
+inline double signedDistance(Cube c, const Coord3D & p) {
+  const BoundingBox3D b = c.boundingBox();
+  const double lo[3] = { b.min.getX(), b.min.getY(), b.min.getZ() };
+  const double hi[3] = { b.max.getX(), b.max.getY(), b.max.getZ() };
+  const double q[3] = { p.getX(), p.getY(), p.getZ() };
+  return detail::boxDistance<3>(lo, hi, q);
+}
+
+namespace detail {
+
+/* Distances of points first to first + n to a primitive */
+template <unsigned D, bool Simd>
+inline __attribute__((always_inline))
+void primitiveDistanceLoop(const CsgPrimitive<D> & t, const double * const * p, std::size_t first, std::size_t n,
+                           double * __restrict v) {
+  const double * __restrict x = p[0] + first;
+  const double * __restrict y = p[1] + first;
+  const double * __restrict z = p[D - 1] + first;
+  if (t.round) {
+    const double c0 = t.c[0], c1 = t.c[1], c2 = t.c[D - 1], r = t.r;
+#pragma omp simd if(simd: Simd)
+    for (std::size_t i = 0; i < n; ++i) {
+      const double d = (x[i] - c0) * (x[i] - c0) + (y[i] - c1) * (y[i] - c1) +
+                       (D == 3 ? (z[i] - c2) * (z[i] - c2) : 0.0);
+      v[i] = std::sqrt(d) - r;
+    }
+  } else {
+    const double m0 = (t.lo[0] + t.hi[0]) / 2, m1 = (t.lo[1] + t.hi[1]) / 2, m2 = (t.lo[D - 1] + t.hi[D - 1]) / 2;
+    const double e0 = (t.hi[0] - t.lo[0]) / 2, e1 = (t.hi[1] - t.lo[1]) / 2, e2 = (t.hi[D - 1] - t.lo[D - 1]) / 2;
+#pragma omp simd if(simd: Simd)
+    for (std::size_t i = 0; i < n; ++i) {
+      const double q0 = std::abs(x[i] - m0) - e0, q1 = std::abs(y[i] - m1) - e1;
+      const double q2 = D == 3 ? std::abs(z[i] - m2) - e2 : q1;
+      const double o0 = std::max(q0, 0.0), o1 = std::max(q1, 0.0), o2 = D == 3 ? std::max(q2, 0.0) : 0.0;
+      v[i] = std::sqrt(o0 * o0 + o1 * o1 + o2 * o2) + std::min(std::max(q0, std::max(q1, q2)), 0.0);
+    }
+  }
+}
+
+template <CsgCode C, bool Simd>
+inline __attribute__((always_inline))
+void combineDistanceLoop(double * __restrict a, const double * __restrict b, std::size_t n) {
+#pragma omp simd if(simd: Simd)
+  for (std::size_t i = 0; i < n; ++i) {
+    const double u = a[i], w = b[i];
+    if constexpr (C == CsgCode::Union)
+      a[i] = std::min(u, w);
+    else if constexpr (C == CsgCode::Intersection)
+      a[i] = std::max(u, w);
+    else if constexpr (C == CsgCode::Difference)
+      a[i] = std::max(u, -w);
+    else if constexpr (C == CsgCode::ReverseDifference)
+      a[i] = std::max(w, -u);
+    else
+      a[i] = -u;
+  }
+}
+
+template <unsigned D>
+struct DistanceLoop {
+  template <bool Simd>
+  static inline __attribute__((always_inline))
+  void run(const CsgInstr * code, std::size_t m, const CsgPrimitive<D> * prims,
+          const double * const * p, std::size_t n, double * v) {
+    alignas(64) double r[csg_slots][csg_block];
+    for (std::size_t first = 0; first < n; first += csg_block) {
+      const std::size_t len = std::min(csg_block, n - first);
+      for (std::size_t j = 0; j < m; ++j) {
+        double * s = r[code[j].slot];
+        switch (code[j].code) {
+        case CsgCode::Ball:
+        case CsgCode::Box:
+          primitiveDistanceLoop<D, Simd>(prims[code[j].arg], p, first, len, s);
+          break;
+        case CsgCode::Union:
+          combineDistanceLoop<CsgCode::Union, Simd>(s, s + csg_block, len);
+          break;
+        case CsgCode::Intersection:
+          combineDistanceLoop<CsgCode::Intersection, Simd>(s, s + csg_block, len);
+          break;
+        case CsgCode::Difference:
+          combineDistanceLoop<CsgCode::Difference, Simd>(s, s + csg_block, len);
+          break;
+        case CsgCode::ReverseDifference:
+          combineDistanceLoop<CsgCode::ReverseDifference, Simd>(s, s + csg_block, len);
+          break;
+        case CsgCode::Complement:
+          combineDistanceLoop<CsgCode::Complement, Simd>(s, s + csg_block, len);
+          break;
+        }
+      }
+      std::copy(r[0], r[0] + len, v + first);
+    }
+  }
+};
+
+template <unsigned D>
+using DistanceKernel = IsaKernel<CsgKernelFn<D>, DistanceLoop<D>>;
+
+}
+
+/**
+ * @brief Selects signed distance kernel compiled for an instruction set level
+ *
+ * The kernel runs a CSG tape like the one of csgKernel, but sets v to the
+ * signed distances. The caller is responsible for the processor supporting
+ * the level.
+ * @param isa Instruction set level
+ */
+template <unsigned D>
+CsgKernelFn<D> sdfKernel(Isa isa) {
+  return detail::DistanceKernel<D>::select(isa);
+}
+
+/** @brief Selects signed distance kernel for the active instruction set level */
+template <unsigned D>
+CsgKernelFn<D> dispatchSdfKernel(void) {
+  static const CsgKernelFn<D> k = sdfKernel<D>(activeIsa());
+  return k;
+}
+
+/**
+ * @brief Signed distance of a point to the solid of a CSG tape
+ *
+ * Distances to shapes are exact, while the ones to unions, intersections
+ * and differences are bounds, which are exact outside unions. All of them
+ * change by at most the distance between points. Points on the boundary
+ * of a subtracted shape have zero distance. Constant tapes have infinite
+ * distances.
+ * @param t Tape (not specialized)
+ * @param c Point
+ * @return Distance, negative inside
+ */
+template <unsigned D>
+double signedDistance(const CsgTape<D> & t, const typename detail::CsgSpace<D>::Coord & c) {
+  if (t.cover() != CsgCover::Partial)
+    return t.cover() == CsgCover::Full ? -std::numeric_limits<double>::infinity()
+                                       : std::numeric_limits<double>::infinity();
+  double p[D];
+  detail::CsgSpace<D>::get(c, p);
+  double s[detail::csg_slots + 1] = {};
+  for (const CsgInstr & i : t.code()) {
+    double & a = s[i.slot];
+    const double b = s[i.slot + 1];
+    switch (i.code) {
+    case CsgCode::Ball:
+    case CsgCode::Box:
+      a = detail::primitiveDistance<D>(t.primitives()[i.arg], p);
+      break;
+    case CsgCode::Union: a = std::min(a, b); break;
+    case CsgCode::Intersection: a = std::max(a, b); break;
+    case CsgCode::Difference: a = std::max(a, -b); break;
+    case CsgCode::ReverseDifference: a = std::max(b, -a); break;
+    case CsgCode::Complement: a = -a; break;
+    }
+  }
+  return s[0];
+}
+
+/**
+ * @brief Signed distances of points to the solid of a CSG tape
+ * @param t Tape (not specialized)
+ * @param p Columns of coordinates of the points
+ * @param n Number of points
+ * @param d Distances, negative inside
+ */
+template <unsigned D>
+void signedDistance(const CsgTape<D> & t, const double * const * p, std::size_t n, double * d) {
+  if (t.cover() != CsgCover::Partial)
+    std::fill(d, d + n, t.cover() == CsgCover::Full ? -std::numeric_limits<double>::infinity()
+                                                    : std::numeric_limits<double>::infinity());
+  else
+    dispatchSdfKernel<D>()(t.code().data(), t.size(), t.primitives().data(), p, n, d);
+}
+
+/**
+ * @brief Sparse narrow band grid of signed distances of a CSG tree
+ *
+ * Distances are sampled in the corners of the cells of bricks of 8 cells
+ * per side, kept only for bricks which could have points within the band
+ * around the surface. Distances change by at most the distance between
+ * points, so a box of bricks is skipped when the distance in its center
+ * exceeds the band by more than half of its diagonal, and then all of its
+ * points are on the same side of the surface. A dense table of the bricks
+ * refers to the samples of the kept ones and keeps the side of the others,
+ * which costs 4 bytes per brick against 2916 bytes (in space) of samples.
+ * Points in kept bricks get distances interpolated from the corners of
+ * their cells, with the error of multilinear interpolation, so points
+ * within the band are always answered by the grid. The samples are floats,
+ * which is ample for distances within a band. The grid refers to the
+ * primitives of the tree, which must outlive it.
+ */
+template <unsigned D>
+class SdfGrid {
+public:
+  /** @brief Number of cells along each side of a brick */
+  static constexpr unsigned brick = 8;
+  /** @brief Maximal number of bricks of the table */
+  static constexpr std::size_t max_bricks = std::size_t(1) << 24;
+  /** @brief Coordinates */
+  typedef typename detail::CsgSpace<D>::Coord Coord;
+
+private:
+  static constexpr unsigned side = brick + 1;
+  static constexpr std::size_t brick_samples = D == 2 ? side * side : side * side * side;
+  static constexpr std::uint32_t outside = std::numeric_limits<std::uint32_t>::max();
+  static constexpr std::uint32_t inside = outside - 1;
+
+  CsgTape<D> tape;
+  double org[D];
+  double h;
+  double inv_h;
+  double w;
+  std::size_t nb[D];
+  double cells[D];
+  /* Index of samples of each brick or its side, x fastest */
+  std::vector<std::uint32_t> table;
+  std::vector<float> values;
+  std::size_t kept;
+
+  std::size_t brickIndex(const std::size_t (&b)[D]) const {
+    std::size_t i = 0;
+    for (unsigned k = D; k-- > 0; )
+      i = i * nb[k] + b[k];
+    return i;
+  }
+
+  /* Marks bricks of [lo, hi) by side */
+  void mark(const std::size_t (&lo)[D], const std::size_t (&hi)[D], std::uint32_t s) {
+    std::size_t b[D];
+    for (unsigned k = 0; k < D; ++k)
+      b[k] = lo[k];
+    for (;;) {
+      table[brickIndex(b)] = s;
+      unsigned k = 0;
+      while (k < D && ++b[k] == hi[k])
+        b[k] = lo[k], ++k;
+      if (k == D)
+        return;
+    }
+  }
+
+  /* Samples bricks of [lo, hi) near the surface */
+  void build(const std::size_t (&lo)[D], const std::size_t (&hi)[D], std::vector<double> (&pts)[D],
+             std::vector<double> & d) {
+    double c[D], r = 0;
+    for (unsigned k = 0; k < D; ++k) {
+      const double e = double(hi[k] - lo[k]) * brick * h;
+      c[k] = org[k] + double(lo[k]) * brick * h + e / 2;
+      r += e * e / 4;
+    }
+    double v;
+    if constexpr (D == 2)
+      v = signedDistance(tape, Coord(c[0], c[1]));
+    else
+      v = signedDistance(tape, Coord(c[0], c[1], c[2]));
+    if (std::abs(v) > w + std::sqrt(r)) {
+      mark(lo, hi, v > 0 ? outside : inside);
+      return;
+    }
+    unsigned axis = 0;
+    for (unsigned k = 1; k < D; ++k)
+      if (hi[k] - lo[k] > hi[axis] - lo[axis])
+        axis = k;
+    if (hi[axis] - lo[axis] > 1) {
+      std::size_t a[D], b[D];
+      for (unsigned k = 0; k < D; ++k) {
+        a[k] = k == axis ? (lo[k] + hi[k]) / 2 : hi[k];
+        b[k] = k == axis ? (lo[k] + hi[k]) / 2 : lo[k];
+      }
+      build(lo, a, pts, d);
+      build(b, hi, pts, d);
+      return;
+    }
+    for (std::size_t i = 0; i < brick_samples; ++i)
+      for (std::size_t k = 0, j = i; k < D; ++k, j /= side)
+        pts[k][i] = org[k] + (double(lo[k]) * brick + double(j % side)) * h;
+    const double * p[D];
+    for (unsigned k = 0; k < D; ++k)
+      p[k] = pts[k].data();
+    signedDistance(tape, p, brick_samples, d.data());
+    table[brickIndex(lo)] = std::uint32_t(kept++);
+    values.insert(values.end(), d.begin(), d.end());
+  }
+
+  /* Entry of the table of the brick of a point, with the offset of the
+   * first sample of its cell and the fractions of the point in the cell,
+   * or outside for points out of the grid */
+  std::uint32_t locate(const double (&p)[D], std::size_t & off, double (&t)[D]) const {
+    std::size_t b[D], s = 0;
+    for (std::size_t k = 0, stride = 1; k < D; ++k, stride *= side) {
+      const double f = (p[k] - org[k]) * inv_h;
+      if (!(f >= 0 && f < cells[k]))
+        return outside;
+      const std::size_t i = std::size_t(f);
+      b[k] = i / brick;
+      s += (i % brick) * stride;
+      t[k] = f - double(i);
+    }
+    const std::uint32_t e = table[brickIndex(b)];
+    off = std::size_t(e) * brick_samples + s;
+    return e;
+  }
+
+  double interpolate(std::size_t off, const double (&t)[D]) const {
+    const float * v = values.data() + off;
+    const double x0 = v[0] + (v[1] - v[0]) * t[0];
+    const double x1 = v[side] + (v[side + 1] - v[side]) * t[0];
+    const double y0 = x0 + (x1 - x0) * t[1];
+    if constexpr (D == 2)
+      return y0;
+    else {
+      const float * u = v + side * side;
+      const double x2 = u[0] + (u[1] - u[0]) * t[0];
+      const double x3 = u[side] + (u[side + 1] - u[side]) * t[0];
+      const double y1 = x2 + (x3 - x2) * t[1];
+      return y0 + (y1 - y0) * t[D - 1];
+    }
+  }
+
+public:
+  /**
+   * @brief Samples distances of a tree near its surface
+   * @param tree CSG tree
+   * @param cell Size of cells
+   * @param band Half width of the band around the surface
+   */
+  SdfGrid(const CsgTree<D> & tree, double cell, double band) : tape(tree.compile()), h(cell), inv_h(1 / cell), w(band), kept(0) {
+    if (!(cell > 0) || !(band >= 0))
+      throw std::invalid_argument("SDF grid needs positive cell and band");
+    const typename detail::CsgSpace<D>::Box box = tree.boundingBox();
+    double lo[D], hi[D];
+    detail::CsgSpace<D>::get(box.min, lo);
+    detail::CsgSpace<D>::get(box.max, hi);
+    for (unsigned k = 0; k < D; ++k) {
+      org[k] = 0;
+      nb[k] = 0;
+      cells[k] = 0;
+    }
+    for (unsigned k = 0; k < D; ++k)
+      if (!(lo[k] <= hi[k]))
+        return;
+    double total = 1;
+    for (unsigned k = 0; k < D; ++k) {
+      org[k] = lo[k] - band;
+      nb[k] = std::max(std::size_t(std::ceil((hi[k] - lo[k] + 2 * band) / (brick * cell))), std::size_t(1));
+      cells[k] = double(nb[k] * brick);
+      total *= double(nb[k]);
+    }
+    if (!(total <= double(max_bricks)))
+      throw std::length_error("SDF grid has too many bricks");
+    table.resize(std::size_t(total), outside);
+    std::vector<double> pts[D], d(brick_samples);
+    for (unsigned k = 0; k < D; ++k)
+      pts[k].resize(brick_samples);
+    const std::size_t first[D] = {};
+    build(first, nb, pts, d);
+  }
+
+  /** @brief Retrieves size of cells */
+  double cellSize(void) const { return h; }
+  /** @brief Retrieves half width of the band */
+  double band(void) const { return w; }
+  /** @brief Retrieves number of kept bricks */
+  std::size_t bricks(void) const { return kept; }
+  /** @brief Retrieves number of bytes of the table and the samples */
+  std::size_t memory(void) const { return table.size() * sizeof(std::uint32_t) + values.size() * sizeof(float); }
+  /** @brief Retrieves tape evaluating exact distances */
+  const CsgTape<D> & exact(void) const { return tape; }
+
+  /**
+   * @brief Signed distance of a point
+   * @param c Point
+   * @return Interpolated distance in kept bricks, exact one elsewhere
+   */
+  double distance(const Coord & c) const {
+    double p[D], t[D];
+    detail::CsgSpace<D>::get(c, p);
+    std::size_t off;
+    return locate(p, off, t) < inside ? interpolate(off, t) : signedDistance(tape, c);
+  }
+
+  /**
+   * @brief Signed distances of points
+   *
+   * Points out of the kept bricks are gathered and evaluated together by
+   * the kernel of the tape.
+   * @param p Columns of coordinates of the points
+   * @param n Number of points
+   * @param d Interpolated distances in kept bricks, exact ones elsewhere
+   */
+  void distance(const double * const * p, std::size_t n, double * d) const {
+    static constexpr std::size_t block = 256;
+    alignas(64) double mp[D][block], md[block];
+    std::size_t miss[block];
+    const double * mcols[D];
+    for (unsigned k = 0; k < D; ++k)
+      mcols[k] = mp[k];
+    for (std::size_t first = 0; first < n; first += block) {
+      const std::size_t len = std::min(block, n - first);
+      std::size_t m = 0;
+      for (std::size_t i = first; i < first + len; ++i) {
+        double q[D], t[D];
+        for (unsigned k = 0; k < D; ++k)
+          q[k] = p[k][i];
+        std::size_t off;
+        if (locate(q, off, t) < inside)
+          d[i] = interpolate(off, t);
+        else {
+          for (unsigned k = 0; k < D; ++k)
+            mp[k][m] = q[k];
+          miss[m++] = i;
+        }
+      }
+      if (!m)
+        continue;
+      signedDistance(tape, mcols, m, md);
+      for (std::size_t j = 0; j < m; ++j)
+        d[miss[j]] = md[j];
+    }
+  }
+
+  /**
+   * @brief Signed distances of points clamped to the band
+   *
+   * Needs no evaluation of the tape, which suits queries of margins up to
+   * the band, e.g. of collisions. Points out of the kept bricks get the band
+   * with the sign of their side, while points out of the grid are out of the
+   * bounding box, so out of the solid.
+   * @param p Columns of coordinates of the points
+   * @param n Number of points
+   * @param d Distances clamped to [-band, band]
+   */
+  void clamped(const double * const * p, std::size_t n, double * d) const {
+    static constexpr std::size_t block = 256;
+    alignas(64) double t[D][block];
+    alignas(64) std::int32_t cell[block], sub[block];
+    alignas(64) std::int64_t off[block];
+    alignas(64) double side_of[block];
+    if (table.empty()) {
+      std::fill(d, d + n, w);
+      return;
+    }
+    const std::int32_t n0 = std::int32_t(nb[0]), n1 = std::int32_t(nb[1]), n2 = std::int32_t(nb[D - 1]);
+    const float * v = values.data();
+    for (std::size_t first = 0; first < n; first += block) {
+      const std::size_t len = std::min(block, n - first);
+      /* Bricks and cells of the points, with cell -1 out of the grid */
+#pragma omp simd
+      for (std::size_t i = 0; i < len; ++i) {
+        bool ok = true;
+        std::int32_t b = 0, s = 0;
+        for (unsigned k = D; k-- > 0; ) {
+          const double f = (p[k][first + i] - org[k]) * inv_h;
+          const bool in = (f >= 0) & (f < cells[k]);
+          const std::int32_t c = std::int32_t(in ? f : 0.0);
+          ok = ok & in;
+          t[k][i] = (in ? f : 0.0) - double(c);
+          b = b * (k == 0 ? n0 : (k == 1 ? n1 : n2)) + c / std::int32_t(brick);
+          s = s * std::int32_t(side) + c % std::int32_t(brick);
+        }
+        cell[i] = ok ? b : -1;
+        sub[i] = s;
+      }
+      for (std::size_t i = 0; i < len; ++i) {
+        const std::uint32_t e = cell[i] < 0 ? outside : table[std::size_t(cell[i])];
+        side_of[i] = e == outside ? w : (e == inside ? -w : 0.0);
+        off[i] = e < inside ? std::int64_t(e) * std::int64_t(brick_samples) + sub[i] : 0;
+      }
+      /* With no kept bricks there are no samples to read */
+      if (!kept) {
+        std::copy(side_of, side_of + len, d + first);
+        continue;
+      }
+#pragma omp simd
+      for (std::size_t i = 0; i < len; ++i) {
+        const float * c = v + off[i];
+        const double x0 = c[0] + (c[1] - c[0]) * t[0][i];
+        const double x1 = c[side] + (c[side + 1] - c[side]) * t[0][i];
+        double r = x0 + (x1 - x0) * t[1][i];
+        if constexpr (D == 3) {
+          const float * u = c + side * side;
+          const double x2 = u[0] + (u[1] - u[0]) * t[0][i];
+          const double x3 = u[side] + (u[side + 1] - u[side]) * t[0][i];
+          const double y1 = x2 + (x3 - x2) * t[1][i];
+          r = r + (y1 - r) * t[D - 1][i];
+        }
+        const double e = side_of[i];
+        d[first + i] = e != 0 ? e : std::min(std::max(r, -w), w);
+      }
+    }
+  }
+};
+
+/** @brief Sparse grid of signed distances in the plane */
+typedef SdfGrid<2> SdfGrid2D;
+/** @brief Sparse grid of signed distances in space */
+typedef SdfGrid<3> SdfGrid3D;
+
+}
+
+#endif
@@ -0,0 +1,538 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_shard.hpp
+ * Sharded execution over binary shape files. A coordinator splits a file
+ * into shards by row ranges, hash of rows or spatial grid cells, starts a
+ * worker process for each shard and merges the aggregates computed by the
+ * workers. Coordinator and workers exchange framed messages through a
+ * Transport, so pipes or Unix sockets could be replaced by a network
+ * transport.
+ */
+
+#ifndef GEO_SHARD_HPP
+#define GEO_SHARD_HPP
+
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "geo_aggregate.hpp"
+#include "geo_io.hpp"
+#include "geo_query.hpp"
+
+namespace Geo {
+
+/**
+ * @brief Bidirectional channel of framed messages
+ *
+ * Implementations throw std::runtime_error when the peer is gone.
+ */
+class Transport {
+public:
+  virtual ~Transport() {}
+  /** @brief Sends message */
+  virtual void send(const std::string & msg) = 0;
+  /** @brief Receives next message */
+  virtual std::string receive(void) = 0;
+};
+
+/** @brief Transport over file descriptors (pipes or sockets) */
+class FdTransport : public Transport {
+private:
+  int in;
+  int out;
+
+  void writeAll(const void * buf, std::size_t len) {
+    const char * p = static_cast<const char *>(buf);
+    while (len > 0) {
+      const ssize_t w = ::write(out, p, len);
+      if (w < 0 && errno == EINTR)
+        continue;
+      if (w <= 0)
+        throw std::runtime_error(std::string("Geo::FdTransport: send failed: ") + std::strerror(errno));
+      p += w;
+      len -= std::size_t(w);
+    }
+  }
+
+  void readAll(void * buf, std::size_t len) {
+    char * p = static_cast<char *>(buf);
+    while (len > 0) {
+      const ssize_t r = ::read(in, p, len);
+      if (r < 0 && errno == EINTR)
+        continue;
+      if (r <= 0)
+        throw std::runtime_error("Geo::FdTransport: connection closed");
+      p += r;
+      len -= std::size_t(r);
+    }
+  }
+
+public:
+  /**
+   * @brief Construct transport, which owns the descriptors
+   * @param rfd Descriptor for receiving
+   * @param wfd Descriptor for sending (could be the same as rfd)
+   */
+  FdTransport(int rfd, int wfd) : in(rfd), out(wfd) {}
+  ~FdTransport() {
+    ::close(in);
+    if (out != in)
+      ::close(out);
+  }
+  FdTransport(const FdTransport &) = delete;
+  FdTransport & operator=(const FdTransport &) = delete;
+
+  void send(const std::string & msg) override {
+    const std::uint64_t n = msg.size();
+    writeAll(&n, sizeof(n));
+    writeAll(msg.data(), msg.size());
+  }
+
+  std::string receive(void) override {
+    std::uint64_t n;
+    readAll(&n, sizeof(n));
+    std::string msg(n, '\0');
+    readAll(&msg[0], n);
+    return msg;
+  }
+};
+
+/** @brief Kinds of local transports between coordinator and workers */
+enum class TransportKind {
+  Pipe,
+  Socket
+};
+
+/** @brief Connected ends of a transport */
+typedef std::pair<std::unique_ptr<Transport>, std::unique_ptr<Transport> > TransportPair;
+
+/**
+ * @brief Creates connected pair of local transports
+ *
+ * Both ends are created in the calling process, so one of them could be
+ * passed to a forked worker.
+ * @param kind Kind of transport
+ */
+inline TransportPair makeTransportPair(TransportKind kind) {
+  if (kind == TransportKind::Socket) {
+    int sv[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+      throw std::runtime_error(std::string("Geo::makeTransportPair: socketpair failed: ") + std::strerror(errno));
+    return TransportPair(std::unique_ptr<Transport>(new FdTransport(sv[0], sv[0])),
+                         std::unique_ptr<Transport>(new FdTransport(sv[1], sv[1])));
+  }
+  int a[2], b[2];
+  if (::pipe(a) != 0)
+    throw std::runtime_error(std::string("Geo::makeTransportPair: pipe failed: ") + std::strerror(errno));
+  if (::pipe(b) != 0) {
+    ::close(a[0]);
+    ::close(a[1]);
+    throw std::runtime_error(std::string("Geo::makeTransportPair: pipe failed: ") + std::strerror(errno));
+  }
+  return TransportPair(std::unique_ptr<Transport>(new FdTransport(a[0], b[1])),
+                       std::unique_ptr<Transport>(new FdTransport(b[0], a[1])));
+}
+
+/** @brief Strategies for splitting shape files into shards */
+enum class ShardStrategy {
+  /** @brief Contiguous ranges of rows (no copying) */
+  Range,
+  /** @brief Hash of row number */
+  Hash,
+  /** @brief Hash of grid cell of the reference point, so near shapes are together */
+  Spatial
+};
+
+/** @brief Work of a worker: range of rows of a shape file and what to compute */
+struct ShardTask {
+  /** @brief Shape file */
+  std::string path;
+  /** @brief First row */
+  std::uint64_t first = 0;
+  /** @brief Number of rows */
+  std::uint64_t count = 0;
+  /** @brief Measure for ranking and quantiles */
+  Measure measure = Measure::Area;
+  /** @brief Number of largest shapes to keep */
+  std::uint64_t top = 10;
+  /** @brief Query run on the shard (empty for none) */
+  std::string query;
+
+  /** @brief Serializes task */
+  std::string serialize(void) const {
+    MessageWriter w;
+    w.put(path).put(first).put(count).put(std::uint8_t(measure)).put(top).put(query);
+    return w.str();
+  }
+  /** @brief Deserializes task */
+  static ShardTask deserialize(const std::string & msg) {
+    MessageReader r(msg);
+    ShardTask t;
+    t.path = r.getString();
+    t.first = r.get<std::uint64_t>();
+    t.count = r.get<std::uint64_t>();
+    t.measure = Measure(r.get<std::uint8_t>());
+    t.top = r.get<std::uint64_t>();
+    t.query = r.getString();
+    return t;
+  }
+};
+
+/** @brief Result of a shard or merged result of all shards */
+struct ShardResult {
+  /** @brief Aggregate of the shapes */
+  Aggregate aggregate;
+  /** @brief Number of shapes matching the query */
+  std::uint64_t query_count = 0;
+  /** @brief Sum of the measure selected by the query */
+  double query_sum = 0;
+
+  /** @brief Construct empty result */
+  explicit ShardResult(Measure m = Measure::Area, std::size_t top = 10) : aggregate(m, top) {}
+
+  /** @brief Adds result of another shard */
+  void merge(const ShardResult & o) {
+    aggregate.merge(o.aggregate);
+    query_count += o.query_count;
+    query_sum += o.query_sum;
+  }
+
+  /** @brief Serializes result */
+  std::string serialize(void) const {
+    MessageWriter w;
+    aggregate.write(w);
+    w.put(query_count).put(query_sum);
+    return w.str();
+  }
+  /** @brief Deserializes result */
+  static ShardResult deserialize(const std::string & msg) {
+    MessageReader r(msg);
+    ShardResult s;
+    s.aggregate = Aggregate::read(r);
+    s.query_count = r.get<std::uint64_t>();
+    s.query_sum = r.get<double>();
+    return s;
+  }
+};
+
+/**
+ * @brief Computes result of a task
+ * @param task Task
+ * @return Result of the shard
+ */
+inline ShardResult runShardTask(const ShardTask & task) {
+  const ShapeFile f = ShapeFile::open(task.path);
+  if (task.first + task.count > f.size())
+    throw std::runtime_error("Geo::runShardTask: rows out of range of '" + task.path + "'");
+  ShapeStore store;
+  store.reserve(task.count);
+  f.read(task.first, task.count, store);
+  ShardResult r(task.measure, task.top);
+  r.aggregate.add(store);
+  if (!task.query.empty()) {
+    const Query::Result q = Query::parse(task.query).run(store, false);
+    r.query_count = q.count;
+    r.query_sum = q.sum;
+  }
+  return r;
+}
+
+/**
+ * @brief Serves tasks received through transport until the peer closes it
+ *
+ * Replies start with 'R' and the serialized result, or 'E' and an error
+ * message.
+ * @param t Transport to coordinator
+ */
+inline void serveShardTasks(Transport & t) {
+  for (;;) {
+    std::string msg;
+    try {
+      msg = t.receive();
+    } catch (const std::runtime_error &) {
+      return;
+    }
+    try {
+      t.send("R" + runShardTask(ShardTask::deserialize(msg)).serialize());
+    } catch (const std::exception & e) {
+      t.send(std::string("E") + e.what());
+    }
+  }
+}
+
+/**
+ * @brief Retrieves shard of a row
+ * @param s Strategy (Hash or Spatial)
+ * @param row Row number
+ * @param x X coordinate of reference point
+ * @param y Y coordinate of reference point
+ * @param cell Size of grid cells for spatial sharding
+ * @param shards Number of shards
+ */
+inline std::size_t shardOf(ShardStrategy s, std::uint64_t row, double x, double y, double cell,
+                           std::size_t shards) {
+  std::uint64_t h;
+  if (s == ShardStrategy::Spatial) {
+    const std::uint64_t cx = std::uint64_t(std::int64_t(std::floor(x / cell)));
+    const std::uint64_t cy = std::uint64_t(std::int64_t(std::floor(y / cell)));
+    h = cx * 0x9e3779b97f4a7c15ULL ^ (cy + 0x632be59bd9b4e019ULL);
+  } else
+    h = row;
+  /* Finalizer of splitmix64 */
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+  return std::size_t((h ^ (h >> 31)) % shards);
+}
+
+/**
+ * @brief Splits shape file into shards
+ *
+ * Range shards refer to the file itself. Hash and spatial shards are
+ * written as separate shape files named by prefix and shard number in two
+ * streaming passes over the file, so it is not loaded into memory. Shard
+ * files written so far are removed, if splitting fails.
+ * @param path Shape file
+ * @param s Strategy
+ * @param shards Number of shards
+ * @param prefix Prefix of paths of shard files
+ * @param cell Size of grid cells for spatial sharding
+ * @return Task for each shard (with default parameters)
+ */
+inline std::vector<ShardTask> splitShapeFile(const std::string & path, ShardStrategy s, std::size_t shards,
+                                             const std::string & prefix, double cell = 100) {
+  const ShapeFile f = ShapeFile::open(path);
+  const std::uint64_t n = f.size();
+  std::vector<ShardTask> tasks(shards ? shards : 1);
+  shards = tasks.size();
+  if (s == ShardStrategy::Range) {
+    for (std::size_t k = 0; k < shards; ++k) {
+      tasks[k].path = path;
+      tasks[k].first = n * k / shards;
+      tasks[k].count = n * (k + 1) / shards - tasks[k].first;
+    }
+    return tasks;
+  }
+
+  const std::size_t chunk = std::size_t(std::min<std::uint64_t>(n, 1u << 18));
+  std::vector<ShapeType> t(chunk);
+  std::vector<double> buf(chunk * ShapeStore::column_count);
+  double * v[ShapeStore::column_count];
+  for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+    v[c] = buf.data() + c * chunk;
+  auto pass = [&](auto row_fn) {
+    for (std::uint64_t done = 0; done < n; ) {
+      const std::size_t m = std::size_t(std::min<std::uint64_t>(chunk, n - done));
+      f.read(done, m, t.data(), v);
+      for (std::size_t i = 0; i < m; ++i)
+        row_fn(i, shardOf(s, done + i, v[0][i], v[1][i], cell, shards));
+      done += m;
+    }
+  };
+
+  /* First pass counts rows of shards, so their files could be allocated */
+  std::vector<std::uint64_t> counts(shards, 0);
+  pass([&](std::size_t, std::size_t k) { ++counts[k]; });
+
+  /* Shard files written so far are removed, if splitting fails */
+  std::vector<ShapeFile> files;
+  std::size_t created = 0;
+  try {
+    for (std::size_t k = 0; k < shards; ++k) {
+      tasks[k].path = prefix + std::to_string(k) + ".geo";
+      tasks[k].count = counts[k];
+      files.push_back(ShapeFile::create(tasks[k].path, counts[k]));
+      ++created;
+    }
+
+    /* Second pass buffers rows of each shard and writes them in batches */
+    const std::size_t batch = 4096;
+    std::vector<std::vector<ShapeType> > bt(shards);
+    std::vector<std::vector<double> > bv(shards);
+    std::vector<std::uint64_t> written(shards, 0);
+    auto flush = [&](std::size_t k) {
+      const std::size_t m = bt[k].size();
+      const double * cols[ShapeStore::column_count];
+      std::vector<double> colbuf(m * ShapeStore::column_count);
+      for (unsigned c = 0; c < ShapeStore::column_count; ++c) {
+        for (std::size_t i = 0; i < m; ++i)
+          colbuf[c * m + i] = bv[k][i * ShapeStore::column_count + c];
+        cols[c] = colbuf.data() + c * m;
+      }
+      files[k].write(written[k], m, bt[k].data(), cols);
+      written[k] += m;
+      bt[k].clear();
+      bv[k].clear();
+    };
+    pass([&](std::size_t i, std::size_t k) {
+      bt[k].push_back(t[i]);
+      for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+        bv[k].push_back(v[c][i]);
+      if (bt[k].size() == batch)
+        flush(k);
+    });
+    for (std::size_t k = 0; k < shards; ++k)
+      flush(k);
+  } catch (...) {
+    files.clear();
+    for (std::size_t k = 0; k < created; ++k)
+      ::unlink(tasks[k].path.c_str());
+    throw;
+  }
+  return tasks;
+}
+
+namespace detail {
+
+/* Blocks SIGPIPE in the calling thread, so sending to a worker, which is
+ * gone, fails with EPIPE instead of killing the process. SIGPIPE raised
+ * meanwhile is discarded on unblocking. */
+class SigpipeBlock {
+private:
+  sigset_t old;
+
+public:
+  SigpipeBlock() {
+    sigset_t s;
+    sigemptyset(&s);
+    sigaddset(&s, SIGPIPE);
+    ::pthread_sigmask(SIG_BLOCK, &s, &old);
+  }
+  ~SigpipeBlock() {
+    if (sigismember(&old, SIGPIPE))
+      return;
+    sigset_t s;
+    sigemptyset(&s);
+    sigaddset(&s, SIGPIPE);
+    const timespec none = { 0, 0 };
+    while (::sigtimedwait(&s, nullptr, &none) == SIGPIPE)
+      ;
+    ::pthread_sigmask(SIG_SETMASK, &old, nullptr);
+  }
+  SigpipeBlock(const SigpipeBlock &) = delete;
+  SigpipeBlock & operator=(const SigpipeBlock &) = delete;
+};
+
+/* Worker processes with links to them, which are closed before the
+ * workers are reaped, also when the coordinator fails */
+struct ShardWorkers {
+  std::vector<std::unique_ptr<Transport> > links;
+  std::vector<pid_t> pids;
+
+  ShardWorkers() {}
+  ~ShardWorkers() {
+    links.clear();
+    for (pid_t pid : pids)
+      while (::waitpid(pid, nullptr, 0) < 0 && errno == EINTR)
+        ;
+  }
+  ShardWorkers(const ShardWorkers &) = delete;
+  ShardWorkers & operator=(const ShardWorkers &) = delete;
+};
+
+}
+
+/**
+ * @brief Runs tasks in local worker processes and merges their results
+ *
+ * A worker process is forked for each task and all tasks are sent before
+ * any result is received, so the workers run in parallel. Workers, which
+ * exit early, are reported as errors of their shards and all workers are
+ * reaped before returning or throwing.
+ * @param tasks Tasks (with the same measure and top-K size)
+ * @param kind Kind of transport
+ * @return Merged result
+ */
+inline ShardResult runSharded(const std::vector<ShardTask> & tasks, TransportKind kind = TransportKind::Pipe) {
+  const detail::SigpipeBlock sigpipe;
+  detail::ShardWorkers workers;
+  std::fflush(nullptr);
+  for (std::size_t k = 0; k < tasks.size(); ++k) {
+    TransportPair p = makeTransportPair(kind);
+    const pid_t pid = ::fork();
+    if (pid < 0)
+      throw std::runtime_error(std::string("Geo::runSharded: fork failed: ") + std::strerror(errno));
+    if (pid == 0) {
+      /* Worker keeps only its own end of the transport and never returns */
+      workers.links.clear();
+      p.first.reset();
+      int status = 0;
+      try {
+        serveShardTasks(*p.second);
+      } catch (...) {
+        status = 1;
+      }
+      p.second.reset();
+      ::_exit(status);
+    }
+    workers.pids.push_back(pid);
+    workers.links.push_back(std::move(p.first));
+  }
+
+  ShardResult merged(tasks.empty() ? Measure::Area : tasks[0].measure,
+                     tasks.empty() ? 0 : std::size_t(tasks[0].top));
+  std::string error;
+  std::vector<bool> sent(tasks.size(), false);
+  for (std::size_t k = 0; k < tasks.size(); ++k)
+    try {
+      workers.links[k]->send(tasks[k].serialize());
+      sent[k] = true;
+    } catch (const std::runtime_error & e) {
+      if (error.empty())
+        error = "shard " + std::to_string(k) + ": " + e.what();
+    }
+  for (std::size_t k = 0; k < tasks.size(); ++k) {
+    if (!sent[k])
+      continue;
+    try {
+      const std::string reply = workers.links[k]->receive();
+      if (!reply.empty() && reply[0] == 'R')
+        merged.merge(ShardResult::deserialize(reply.substr(1)));
+      else if (error.empty())
+        error = "shard " + std::to_string(k) + ": " + (reply.empty() ? "empty reply" : reply.substr(1));
+    } catch (const std::runtime_error & e) {
+      if (error.empty())
+        error = "shard " + std::to_string(k) + ": " + e.what();
+    }
+  }
+  if (!error.empty())
+    throw std::runtime_error("Geo::runSharded: " + error);
+  return merged;
+}
+}
+
+#endif
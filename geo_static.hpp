@@ -0,0 +1,304 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_static.hpp
+ * Static polymorphism variant of the shapes hierarchy from geo.hpp.
+ * Shapes derive from StaticShape through the curiously recurring template
+ * pattern (CRTP), so calls to area, perimeter and volume are resolved at
+ * compile time and could be inlined in loops over shapes of a known type.
+ */
+
+#ifndef GEO_STATIC_HPP
+#define GEO_STATIC_HPP
+
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#include "geo.hpp"
+
+namespace Geo {
+
+/**
+ * @brief Generic static shape
+ *
+ * Mirrors Shape, but dispatches to the implementation of the derived class
+ * given as template parameter without virtual calls.
+ */
+template <class Derived>
+class StaticShape {
+public:
+  /** @brief Calculates shape's area */
+  double area(void) const { return derived().areaImpl(); }
+  /** @brief Calculates shape's perimeter */
+  double perimeter(void) const { return derived().perimeterImpl(); }
+
+protected:
+  /** @brief Retrieves the derived shape */
+  const Derived & derived(void) const { return static_cast<const Derived &>(*this); }
+};
+
+/** @brief Generic static two dimensional shape */
+template <class Derived>
+class StaticShape2D: public StaticShape<Derived> {
+private:
+  Coord2D ref_point;
+
+public:
+  /** @brief Shape is two dimensional */
+  static constexpr unsigned dimensions = 2;
+
+  /**
+   * @brief Construct 2D shape from 2D coordinates
+   * @param c 2D coordinates
+   */
+  explicit constexpr StaticShape2D(const Coord2D & c) : ref_point(c) {}
+
+  /** @brief Retrieves shape's reference point */
+  constexpr const Coord2D & getRefPoint(void) const { return ref_point; }
+  /**
+   * @brief Shape's volume
+   * @return Always zero, because 2D shapes do not enclose volume.
+   */
+  constexpr double volume(void) const { return 0; }
+};
+
+/** @brief Generic static three dimensional shape */
+template <class Derived>
+class StaticShape3D: public StaticShape<Derived> {
+private:
+  Coord3D ref_point;
+
+protected:
+  /**
+   * @brief Shape's perimeter
+   *
+   * Like Shape3D, perimeter is not useful for 3D shapes unless the derived
+   * class defines it.
+   * @return Always zero.
+   */
+  constexpr double perimeterImpl(void) const { return 0; }
+
+  friend class StaticShape<Derived>;
+
+public:
+  /** @brief Shape is three dimensional */
+  static constexpr unsigned dimensions = 3;
+
+  /**
+   * @brief Construct 3D shape from 3D coordinates
+   * @param c 3D coordinates
+   */
+  explicit constexpr StaticShape3D(const Coord3D & c) : ref_point(c) {}
+
+  /** @brief Retrieves shape's reference point */
+  constexpr const Coord3D & getRefPoint(void) const { return ref_point; }
+  /** @brief Calculates shape's volume */
+  double volume(void) const { return this->derived().volumeImpl(); }
+};
+
+/** @brief Static circle shape */
+class StaticCircle final: public StaticShape2D<StaticCircle> {
+private:
+  double radius;
+
+  constexpr double areaImpl(void) const { return Formula::circleArea(radius); }
+  constexpr double perimeterImpl(void) const { return Formula::circlePerimeter(radius); }
+
+  friend class StaticShape<StaticCircle>;
+
+public:
+  /**
+   * @brief Construct circle from 2D coordinates and radius
+   * @param c 2D coordinates
+   * @param r Radius
+   */
+  constexpr StaticCircle(const Coord2D & c, double r) : StaticShape2D(c), radius(r) {}
+
+  /** @brief Retrieves circle's radius */
+  constexpr double getRadius(void) const { return radius; }
+};
+
+/** @brief Static rectangle shape */
+class StaticRectangle final: public StaticShape2D<StaticRectangle> {
+private:
+  double width;
+  double height;
+
+  constexpr double areaImpl(void) const { return Formula::rectangleArea(width, height); }
+  constexpr double perimeterImpl(void) const { return Formula::rectanglePerimeter(width, height); }
+
+  friend class StaticShape<StaticRectangle>;
+
+public:
+  /**
+   * @brief Construct rectangle from 2D coordinates, width and height
+   * @param c 2D coordinates
+   * @param w Width
+   * @param h Height
+   */
+  constexpr StaticRectangle(const Coord2D & c, double w, double h)
+    : StaticShape2D(c), width(w), height(h) {}
+
+  /** @brief Retrieves rectangle's width */
+  constexpr double getWidth(void) const { return width; }
+  /** @brief Retrieves rectangle's height */
+  constexpr double getHeight(void) const { return height; }
+};
+
+/** @brief Static square shape */
+class StaticSquare final: public StaticShape2D<StaticSquare> {
+private:
+  double side;
+
+  constexpr double areaImpl(void) const { return Formula::squareArea(side); }
+  constexpr double perimeterImpl(void) const { return Formula::squarePerimeter(side); }
+
+  friend class StaticShape<StaticSquare>;
+
+public:
+  /**
+   * @brief Construct square from 2D coordinates and side
+   * @param c 2D coordinates
+   * @param s Side value
+   */
+  constexpr StaticSquare(const Coord2D & c, double s) : StaticShape2D(c), side(s) {}
+
+  /** @brief Retrieves side value */
+  constexpr double getSide(void) const { return side; }
+};
+
+/** @brief Static sphere object */
+class StaticSphere final: public StaticShape3D<StaticSphere> {
+private:
+  double radius;
+
+  constexpr double areaImpl(void) const { return Formula::sphereArea(radius); }
+  constexpr double perimeterImpl(void) const { return Formula::circlePerimeter(radius); }
+  constexpr double volumeImpl(void) const { return Formula::sphereVolume(radius); }
+
+  friend class StaticShape<StaticSphere>;
+  friend class StaticShape3D<StaticSphere>;
+
+public:
+  /**
+   * @brief Construct sphere from central point and radius
+   * @param cntr Sphere's central point
+   * @param r Radius
+   */
+  constexpr StaticSphere(const Coord3D & cntr, double r) : StaticShape3D(cntr), radius(r) {}
+
+  /** @brief Retrieves sphere's radius */
+  constexpr double getRadius(void) const { return radius; }
+};
+
+/** @brief Static cube shape */
+class StaticCube final: public StaticShape3D<StaticCube> {
+private:
+  double edge;
+
+  constexpr double areaImpl(void) const { return Formula::cubeArea(edge); }
+  constexpr double volumeImpl(void) const { return Formula::cubeVolume(edge); }
+
+  friend class StaticShape<StaticCube>;
+  friend class StaticShape3D<StaticCube>;
+
+public:
+  /**
+   * @brief Construct cube from 3D coordinates and edge
+   * @param c 3D coordinates
+   * @param s Side value
+   */
+  constexpr StaticCube(const Coord3D & c, double s) : StaticShape3D(c), edge(s) {}
+
+  /** @brief Retrieves cube's edge */
+  constexpr double getEdge(void) const { return edge; }
+};
+
+static_assert(sizeof(StaticCircle) == sizeof(Coord2D) + sizeof(double),
+              "Static shapes must not carry a virtual table pointer");
+static_assert(sizeof(StaticCube) == sizeof(Coord3D) + sizeof(double),
+              "Static shapes must not carry a virtual table pointer");
+
+/** @brief Function object retrieving shape's area */
+struct AreaOf {
+  /** @brief Calculates area of the given shape */
+  template <class S> double operator()(const S & s) const { return s.area(); }
+};
+
+/** @brief Function object retrieving shape's perimeter */
+struct PerimeterOf {
+  /** @brief Calculates perimeter of the given shape */
+  template <class S> double operator()(const S & s) const { return s.perimeter(); }
+};
+
+/** @brief Function object retrieving shape's volume */
+struct VolumeOf {
+  /** @brief Calculates volume of the given shape */
+  template <class S> double operator()(const S & s) const { return s.volume(); }
+};
+
+/**
+ * @brief Sums a measure over a range of shapes
+ * @param shapes Range of shapes of the same static type
+ * @param m Measure (e.g. AreaOf) applied to each shape
+ * @return Sum of the measures
+ */
+template <class Range, class Measure>
+double sum(const Range & shapes, Measure m) {
+  double total = 0;
+  for (const auto & s : shapes)
+    total += m(s);
+  return total;
+}
+
+/**
+ * @brief Selects shapes satisfying a predicate
+ * @param shapes Range of shapes of the same static type
+ * @param pred Predicate applied to each shape
+ * @return Copies of the shapes for which the predicate holds
+ */
+template <class Range, class Predicate>
+auto filter(const Range & shapes, Predicate pred)
+  -> std::vector<typename std::decay<decltype(*std::begin(shapes))>::type>
+{
+  std::vector<typename std::decay<decltype(*std::begin(shapes))>::type> res;
+  for (const auto & s : shapes)
+    if (pred(s))
+      res.push_back(s);
+  return res;
+}
+
+/**
+ * @brief Calculates a measure for each shape of a range
+ * @param shapes Range of shapes of the same static type
+ * @param m Measure (e.g. VolumeOf) applied to each shape
+ * @param out Output iterator receiving the measures in order
+ * @return Output iterator past the last written measure
+ */
+template <class Range, class Measure, class OutputIt>
+OutputIt transform(const Range & shapes, Measure m, OutputIt out) {
+  for (const auto & s : shapes)
+    *out++ = m(s);
+  return out;
+}
+
+}
+
+#endif
@@ -0,0 +1,507 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_store.hpp
+ * Columnar storage of shapes from geo.hpp. Instead of objects each shape's
+ * attributes are kept in separate arrays (columns), which are split in
+ * blocks with minimum and maximum statistics (zone maps) of each column.
+ */
+
+#ifndef GEO_STORE_HPP
+#define GEO_STORE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "geo.hpp"
+#include "geo_memory.hpp"
+
+namespace Geo {
+
+/** @brief Concrete shape types */
+enum class ShapeType : std::uint8_t {
+  Circle,
+  Rectangle,
+  Square,
+  Sphere,
+  Cube
+};
+
+/** @brief Number of concrete shape types */
+constexpr unsigned shape_type_count = 5;
+
+/** @brief Bit of shape type in masks of types */
+constexpr std::uint8_t typeBit(ShapeType t) { return std::uint8_t(1u << unsigned(t)); }
+
+/** @brief Mask of all shape types */
+constexpr std::uint8_t all_types = (1u << shape_type_count) - 1;
+
+/**
+ * @brief Retrieves name of shape type
+ * @param t Shape type
+ * @return Name of the type as the class name in geo.hpp
+ */
+inline const char * typeName(ShapeType t) {
+  static const char * const names[shape_type_count] = {
+    "Circle", "Rectangle", "Square", "Sphere", "Cube"
+  };
+  return names[unsigned(t)];
+}
+
+/** @brief Measures calculated for shapes */
+enum class Measure {
+  Area,
+  Perimeter,
+  Volume
+};
+
+/** @brief Number of measures */
+constexpr unsigned measure_count = 3;
+
+/**
+ * @brief Calculates measure of a shape given by type and dimensions
+ *
+ * Uses the same formulas like the classes in geo.hpp.
+ * @param m Measure
+ * @param t Shape type
+ * @param a Radius, width, side or edge
+ * @param b Height for rectangles
+ * @return Measure's value
+ */
+inline double measure(Measure m, ShapeType t, double a, double b) {
+  switch (m) {
+  case Measure::Area:
+    switch (t) {
+    case ShapeType::Circle:    return Formula::circleArea(a);
+    case ShapeType::Rectangle: return Formula::rectangleArea(a, b);
+    case ShapeType::Square:    return Formula::squareArea(a);
+    case ShapeType::Sphere:    return Formula::sphereArea(a);
+    case ShapeType::Cube:      return Formula::cubeArea(a);
+    }
+    break;
+  case Measure::Perimeter:
+    switch (t) {
+    case ShapeType::Circle:    return Formula::circlePerimeter(a);
+    case ShapeType::Rectangle: return Formula::rectanglePerimeter(a, b);
+    case ShapeType::Square:    return Formula::squarePerimeter(a);
+    case ShapeType::Sphere:    return Formula::circlePerimeter(a);
+    case ShapeType::Cube:      return 0;
+    }
+    break;
+  case Measure::Volume:
+    switch (t) {
+    case ShapeType::Sphere:    return Formula::sphereVolume(a);
+    case ShapeType::Cube:      return Formula::cubeVolume(a);
+    default:                   return 0;
+    }
+  }
+  return 0;
+}
+
+namespace Metric {
+template <class E> struct Expression;
+}
+
+/**
+ * @brief Columnar store of shapes
+ *
+ * Each shape is described by its type, reference point (X, Y and Z, which is
+ * zero for 2D shapes) and two dimensions: A is radius for circles and
+ * spheres, width for rectangles, side for squares and edge for cubes, while
+ * B is height for rectangles and zero otherwise. Rows are grouped in blocks
+ * of fixed size with zone map for each block maintained on write. Zone maps
+ * include the measures of the shapes as well, so range filters on columns
+ * and measures could skip blocks without touching their rows.
+ */
+class ShapeStore {
+public:
+  /** @brief Columns of the store */
+  enum class Column {
+    X,
+    Y,
+    Z,
+    A,
+    B
+  };
+
+  /** @brief Number of numeric columns */
+  static constexpr unsigned column_count = 5;
+
+  /** @brief Default number of rows in a block */
+  static constexpr std::size_t default_block_size = 4096;
+
+  /** @brief Statistics of a block */
+  struct ZoneMap {
+    /** @brief Minimum value of each column */
+    double min[column_count];
+    /** @brief Maximum value of each column */
+    double max[column_count];
+    /** @brief Minimum value of each measure */
+    double mmin[measure_count];
+    /** @brief Maximum value of each measure */
+    double mmax[measure_count];
+    /** @brief Number of NaN values of each column, which min and max ignore */
+    std::uint32_t nans[column_count];
+    /** @brief Number of NaN values of each measure */
+    std::uint32_t mnans[measure_count];
+    /** @brief Mask of shape types present in the block */
+    std::uint8_t types;
+
+    /** @brief Construct empty zone map */
+    ZoneMap() : nans(), mnans(), types(0) {
+      std::fill(min, min + column_count, std::numeric_limits<double>::infinity());
+      std::fill(max, max + column_count, -std::numeric_limits<double>::infinity());
+      std::fill(mmin, mmin + measure_count, std::numeric_limits<double>::infinity());
+      std::fill(mmax, mmax + measure_count, -std::numeric_limits<double>::infinity());
+    }
+
+    /**
+     * @brief Extends the statistics with a shape
+     * @param t Shape type
+     * @param v Values of the columns
+     */
+    void extend(ShapeType t, const double * v) {
+      for (unsigned c = 0; c < column_count; ++c) {
+        min[c] = std::min(min[c], v[c]);
+        max[c] = std::max(max[c], v[c]);
+        nans[c] += std::isnan(v[c]);
+      }
+      for (unsigned m = 0; m < measure_count; ++m) {
+        const double mv = Geo::measure(Measure(m), t, v[unsigned(Column::A)], v[unsigned(Column::B)]);
+        mmin[m] = std::min(mmin[m], mv);
+        mmax[m] = std::max(mmax[m], mv);
+        mnans[m] += std::isnan(mv);
+      }
+      types |= typeBit(t);
+    }
+
+    /**
+     * @brief Checks whether some value of a column could be within range
+     * @param c Column
+     * @param lo Minimum value
+     * @param hi Maximum value
+     */
+    bool mayContain(Column c, double lo, double hi) const {
+      return !(hi < min[unsigned(c)] || lo > max[unsigned(c)] || lo > hi);
+    }
+    /** @brief Checks whether some value of a measure could be within range */
+    bool mayContain(Measure m, double lo, double hi) const {
+      return !(hi < mmin[unsigned(m)] || lo > mmax[unsigned(m)] || lo > hi);
+    }
+    /**
+     * @brief Checks whether all values of a column are within range
+     *
+     * NaN values are within no range, so blocks with them never are.
+     */
+    bool within(Column c, double lo, double hi) const {
+      return lo <= min[unsigned(c)] && max[unsigned(c)] <= hi && nans[unsigned(c)] == 0;
+    }
+    /** @brief Checks whether all values of a measure are within range */
+    bool within(Measure m, double lo, double hi) const {
+      return lo <= mmin[unsigned(m)] && mmax[unsigned(m)] <= hi && mnans[unsigned(m)] == 0;
+    }
+  };
+
+private:
+  std::size_t block_size;
+  std::uint64_t changes = 0;
+  std::vector<ShapeType, PageAllocator<ShapeType> > type_col;
+  std::vector<double, PageAllocator<double> > cols[column_count];
+  std::vector<ZoneMap> zones;
+
+  /* Evaluates expression for a block of shapes of a single type */
+  template <ShapeType S, class E>
+  bool computeBlock(const E & expr, std::uint8_t mask, std::size_t first, std::size_t n,
+                    double * __restrict out) const {
+    if (mask != typeBit(S))
+      return false;
+    const double * __restrict a = cols[unsigned(Column::A)].data() + first;
+    const double * __restrict b = cols[unsigned(Column::B)].data() + first;
+#pragma omp simd
+    for (std::size_t i = 0; i < n; ++i)
+      out[i] = expr.template eval<S>(a[i], b[i]);
+    return true;
+  }
+
+public:
+  /**
+   * @brief Construct empty store
+   * @param bs Number of rows in a block
+   * @param hp Huge page policy for memory of columns
+   */
+  explicit ShapeStore(std::size_t bs = default_block_size, HugePages hp = HugePages::None)
+    : block_size(bs ? bs : 1), type_col(PageAllocator<ShapeType>(hp)) {
+    for (auto & c : cols)
+      c = std::vector<double, PageAllocator<double> >(PageAllocator<double>(hp));
+  }
+
+  /**
+   * @brief Appends shape given by its attributes
+   * @param t Shape type
+   * @param x X coordinate value
+   * @param y Y coordinate value
+   * @param z Z coordinate value
+   * @param a Radius, width, side or edge
+   * @param b Height for rectangles
+   */
+  void append(ShapeType t, double x, double y, double z, double a, double b = 0) {
+    if (type_col.size() % block_size == 0)
+      zones.push_back(ZoneMap());
+    const double v[column_count] = { x, y, z, a, b };
+    type_col.push_back(t);
+    for (unsigned c = 0; c < column_count; ++c)
+      cols[c].push_back(v[c]);
+    zones.back().extend(t, v);
+  }
+
+  /**
+   * @brief Appends shapes given by columns
+   * @param n Number of shapes
+   * @param t Shape types
+   * @param v Arrays with values of each column in order X, Y, Z, A and B
+   */
+  void append(std::size_t n, const ShapeType * t, const double * const * v) {
+    const std::size_t first = size();
+    type_col.insert(type_col.end(), t, t + n);
+    for (unsigned c = 0; c < column_count; ++c)
+      cols[c].insert(cols[c].end(), v[c], v[c] + n);
+    for (std::size_t i = first; i < first + n; ++i) {
+      if (i % block_size == 0)
+        zones.push_back(ZoneMap());
+      const double r[column_count] = { cols[0][i], cols[1][i], cols[2][i], cols[3][i], cols[4][i] };
+      zones.back().extend(type_col[i], r);
+    }
+  }
+
+  /**
+   * @brief Replaces attributes of a shape
+   *
+   * Zone map of the block is widened when the new values fall outside of
+   * it and rebuilt when the old values were on its boundaries or NaN, so it
+   * stays exact after updates.
+   * @param i Index of the shape
+   * @param t Shape type
+   * @param x X coordinate value
+   * @param y Y coordinate value
+   * @param z Z coordinate value
+   * @param a Radius, width, side or edge
+   * @param b Height for rectangles
+   */
+  void update(std::size_t i, ShapeType t, double x, double y, double z, double a, double b = 0) {
+    const std::size_t blk = i / block_size;
+    const ZoneMap & zm = zones[blk];
+    bool boundary = type_col[i] != t;
+    for (unsigned c = 0; c < column_count && !boundary; ++c)
+      boundary = cols[c][i] == zm.min[c] || cols[c][i] == zm.max[c] || std::isnan(cols[c][i]);
+    for (unsigned m = 0; m < measure_count && !boundary; ++m) {
+      const double mv = measure(Measure(m), i);
+      boundary = mv == zm.mmin[m] || mv == zm.mmax[m] || std::isnan(mv);
+    }
+
+    const double v[column_count] = { x, y, z, a, b };
+    type_col[i] = t;
+    for (unsigned c = 0; c < column_count; ++c)
+      cols[c][i] = v[c];
+    ++changes;
+    if (boundary)
+      rebuildZone(blk);
+    else
+      zones[blk].extend(t, v);
+  }
+
+  /**
+   * @brief Recalculates zone map of a block from its rows
+   * @param blk Block index
+   */
+  void rebuildZone(std::size_t blk) {
+    ZoneMap zm;
+    const std::size_t first = blk * block_size;
+    const std::size_t last = std::min(first + block_size, size());
+    for (std::size_t i = first; i < last; ++i) {
+      double v[column_count];
+      for (unsigned c = 0; c < column_count; ++c)
+        v[c] = cols[c][i];
+      zm.extend(type_col[i], v);
+    }
+    zones[blk] = zm;
+  }
+
+  /** @brief Appends circle */
+  void add(Circle c) {
+    append(ShapeType::Circle, c.getRefPoint().getX(), c.getRefPoint().getY(), 0, c.getRadius());
+  }
+  /** @brief Appends rectangle */
+  void add(Rectangle r) {
+    append(ShapeType::Rectangle, r.getRefPoint().getX(), r.getRefPoint().getY(), 0,
+           r.getWidth(), r.getHeight());
+  }
+  /** @brief Appends square */
+  void add(Square s) {
+    append(ShapeType::Square, s.getRefPoint().getX(), s.getRefPoint().getY(), 0, s.getSide());
+  }
+  /** @brief Appends sphere */
+  void add(Sphere s) {
+    const Coord3D & c = s.getRefPoint();
+    append(ShapeType::Sphere, c.getX(), c.getY(), c.getZ(), s.getRadius());
+  }
+  /** @brief Appends cube */
+  void add(Cube s) {
+    const Coord3D & c = s.getRefPoint();
+    append(ShapeType::Cube, c.getX(), c.getY(), c.getZ(), s.getEdge());
+  }
+
+  /**
+   * @brief Reserves memory for rows
+   * @param n Number of rows
+   */
+  void reserve(std::size_t n) {
+    type_col.reserve(n);
+    for (auto & c : cols)
+      c.reserve(n);
+    zones.reserve((n + block_size - 1) / block_size);
+  }
+
+  /** @brief Removes all shapes */
+  void clear(void) {
+    type_col.clear();
+    for (auto & c : cols)
+      c.clear();
+    zones.clear();
+    ++changes;
+  }
+
+  /**
+   * @brief Retrieves number of changes of existing rows
+   *
+   * Counts updates and clearing of the store, but not appends, so indexes
+   * over the store could tell whether they have to be rebuilt.
+   */
+  std::uint64_t changeCount(void) const { return changes; }
+
+  /** @brief Retrieves number of shapes */
+  std::size_t size(void) const { return type_col.size(); }
+  /** @brief Retrieves number of rows in a block */
+  std::size_t blockSize(void) const { return block_size; }
+  /** @brief Retrieves number of blocks */
+  std::size_t blockCount(void) const { return zones.size(); }
+  /** @brief Retrieves zone map of a block */
+  const ZoneMap & zone(std::size_t blk) const { return zones[blk]; }
+  /** @brief Retrieves huge page policy for memory of columns */
+  HugePages hugePages(void) const { return type_col.get_allocator().hugePages(); }
+
+  /**
+   * @brief Retrieves number of bytes of columns backed by huge pages
+   *
+   * Reported by the kernel, so it is the memory which actually got huge
+   * pages and not only requested them.
+   */
+  std::size_t hugePageBytes(void) const {
+    std::size_t n = Geo::hugePageBytes(type_col.data(), type_col.capacity());
+    for (const auto & c : cols)
+      n += Geo::hugePageBytes(c.data(), c.capacity() * sizeof(double));
+    return n;
+  }
+
+  /** @brief Retrieves column with shape types */
+  const ShapeType * types(void) const { return type_col.data(); }
+  /** @brief Retrieves numeric column */
+  const double * column(Column c) const { return cols[unsigned(c)].data(); }
+
+  /** @brief Retrieves shape's type */
+  ShapeType type(std::size_t i) const { return type_col[i]; }
+  /** @brief Retrieves value of numeric column for a shape */
+  double value(Column c, std::size_t i) const { return cols[unsigned(c)][i]; }
+
+  /**
+   * @brief Calculates measure of a shape
+   * @param m Measure
+   * @param i Index of the shape
+   */
+  double measure(Measure m, std::size_t i) const {
+    return Geo::measure(m, type_col[i], cols[unsigned(Column::A)][i], cols[unsigned(Column::B)][i]);
+  }
+
+  /**
+   * @brief Evaluates a metric expression for the shapes of a block
+   *
+   * The expression (see geo_expr.hpp) is evaluated in a vector loop. Blocks
+   * of a single type, according to their zone maps, use the formulas of the
+   * type, while other blocks select the measures of each shape by its type
+   * without branches.
+   * @param e Metric expression (e.g. <code>area() / perimeter()</code>)
+   * @param blk Block index
+   * @param out Output array for the results of the rows of the block
+   */
+  template <class E>
+  void compute(const Metric::Expression<E> & e, std::size_t blk, double * out) const {
+    const E & expr = e.self();
+    const std::size_t first = blk * block_size;
+    const std::size_t n = std::min(block_size, size() - first);
+    const std::uint8_t mask = zones[blk].types;
+    if (computeBlock<ShapeType::Circle>(expr, mask, first, n, out) ||
+        computeBlock<ShapeType::Rectangle>(expr, mask, first, n, out) ||
+        computeBlock<ShapeType::Square>(expr, mask, first, n, out) ||
+        computeBlock<ShapeType::Sphere>(expr, mask, first, n, out) ||
+        computeBlock<ShapeType::Cube>(expr, mask, first, n, out))
+      return;
+    const ShapeType * __restrict t = type_col.data() + first;
+    const double * __restrict a = cols[unsigned(Column::A)].data() + first;
+    const double * __restrict b = cols[unsigned(Column::B)].data() + first;
+    double * __restrict o = out;
+#pragma omp simd
+    for (std::size_t i = 0; i < n; ++i)
+      o[i] = expr.eval(t[i], a[i], b[i]);
+  }
+
+  /**
+   * @brief Evaluates a metric expression for each shape
+   *
+   * The expression is evaluated block by block like by compute() of a block.
+   * @param e Metric expression (e.g. <code>area() / perimeter()</code>)
+   * @param out Output array for size() results in order of rows
+   */
+  template <class E>
+  void compute(const Metric::Expression<E> & e, double * out) const {
+    for (std::size_t blk = 0; blk < zones.size(); ++blk)
+      compute(e, blk, out + blk * block_size);
+  }
+
+  /**
+   * @brief Calculates measure of selected shapes
+   * @param m Measure
+   * @param sel Indexes of shapes (selection vector)
+   * @param n Number of indexes
+   * @param out Output array for n values
+   */
+  void measure(Measure m, const std::uint32_t * sel, std::size_t n, double * out) const {
+    const ShapeType * t = type_col.data();
+    const double * a = column(Column::A);
+    const double * b = column(Column::B);
+    for (std::size_t k = 0; k < n; ++k)
+      out[k] = Geo::measure(m, t[sel[k]], a[sel[k]], b[sel[k]]);
+  }
+};
+
+}
+
+#endif
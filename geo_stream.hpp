@@ -0,0 +1,494 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geo_stream.hpp
+ * Out-of-core processing of binary shape files. Files are read in chunks,
+ * which fit in a fixed memory budget, while the next chunk is read ahead by
+ * a background thread. Aggregates and queries are evaluated chunk by chunk
+ * and files are sorted by external merge sort, so files larger than memory
+ * could be processed.
+ */
+
+#ifndef GEO_STREAM_HPP
+#define GEO_STREAM_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "geo_aggregate.hpp"
+#include "geo_io.hpp"
+#include "geo_query.hpp"
+
+namespace Geo {
+
+/** @brief Bytes of a row in shape files and chunk buffers */
+constexpr std::size_t shape_row_bytes = sizeof(ShapeType) + ShapeStore::column_count * sizeof(double);
+
+/** @brief Chunk of rows of a shape file */
+struct ShapeChunk {
+  /** @brief Index of the first row in the file */
+  std::uint64_t first;
+  /** @brief Number of rows */
+  std::size_t size;
+  /** @brief Shape types */
+  const ShapeType * types;
+  /** @brief Values of the columns X, Y, Z, A and B */
+  const double * cols[ShapeStore::column_count];
+};
+
+/**
+ * @brief Sequential reader of shape file in chunks
+ *
+ * With read-ahead two buffers are used: one is read by a background thread
+ * while the other one is processed, and each takes half of the budget.
+ * Chunks returned by next() are valid until the following call.
+ */
+class ChunkReader {
+private:
+  struct Buffer {
+    std::vector<ShapeType> types;
+    std::vector<double> values;
+    ShapeChunk chunk;
+    bool ready = false;
+  };
+
+  const ShapeFile & file;
+  std::size_t rows;
+  bool ahead;
+  Buffer bufs[2];
+  std::uint64_t chunks;
+  std::uint64_t consumed;
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool stop;
+  std::exception_ptr error;
+  std::thread reader;
+
+  void fill(Buffer & b, std::uint64_t k) {
+    b.chunk.first = k * rows;
+    b.chunk.size = std::size_t(std::min<std::uint64_t>(rows, file.size() - b.chunk.first));
+    double * v[ShapeStore::column_count];
+    for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+      b.chunk.cols[c] = v[c] = b.values.data() + c * rows;
+    b.chunk.types = b.types.data();
+    file.read(b.chunk.first, b.chunk.size, b.types.data(), v);
+  }
+
+  void readAhead(void) {
+    for (std::uint64_t k = 0; k < chunks; ++k) {
+      Buffer & b = bufs[k % 2];
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return stop || !b.ready; });
+        if (stop)
+          return;
+      }
+      try {
+        fill(b, k);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = std::current_exception();
+        cv.notify_all();
+        return;
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      b.ready = true;
+      cv.notify_all();
+    }
+  }
+
+public:
+  /**
+   * @brief Construct reader
+   * @param f Shape file
+   * @param budget Memory for buffers in bytes
+   * @param read_ahead Whether to read next chunk in background
+   */
+  ChunkReader(const ShapeFile & f, std::size_t budget, bool read_ahead = true)
+    : file(f), rows(std::max<std::size_t>(1, budget / shape_row_bytes / (read_ahead ? 2 : 1))),
+      ahead(read_ahead), consumed(0), stop(false) {
+    rows = std::size_t(std::min<std::uint64_t>(rows, std::max<std::uint64_t>(f.size(), 1)));
+    chunks = (f.size() + rows - 1) / rows;
+    for (unsigned i = 0; i < (ahead ? 2u : 1u); ++i) {
+      bufs[i].types.resize(rows);
+      bufs[i].values.resize(rows * ShapeStore::column_count);
+    }
+    if (ahead)
+      reader = std::thread(&ChunkReader::readAhead, this);
+  }
+
+  ChunkReader(const ChunkReader &) = delete;
+  ChunkReader & operator=(const ChunkReader &) = delete;
+
+  /** @brief Stops reading ahead */
+  ~ChunkReader() {
+    if (reader.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+      }
+      cv.notify_all();
+      reader.join();
+    }
+  }
+
+  /** @brief Retrieves maximum number of rows in a chunk */
+  std::size_t chunkRows(void) const { return rows; }
+
+  /**
+   * @brief Retrieves next chunk
+   * @param out Chunk
+   * @return Whether there was a chunk (false at end of file)
+   */
+  bool next(ShapeChunk & out) {
+    if (consumed >= chunks)
+      return false;
+    if (!ahead) {
+      fill(bufs[0], consumed++);
+      out = bufs[0].chunk;
+      return true;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    /* The previous chunk is processed, so its buffer could be filled again */
+    if (consumed > 0) {
+      bufs[(consumed - 1) % 2].ready = false;
+      cv.notify_all();
+    }
+    Buffer & b = bufs[consumed % 2];
+    cv.wait(lock, [&] { return b.ready || error; });
+    if (!b.ready)
+      std::rethrow_exception(error);
+    ++consumed;
+    out = b.chunk;
+    return true;
+  }
+};
+
+/**
+ * @brief Processes shape file chunk by chunk
+ * @param path Shape file
+ * @param budget Memory for buffers in bytes
+ * @param f Function called with each ShapeChunk in order
+ */
+template <class F>
+void forEachChunk(const std::string & path, std::size_t budget, F f) {
+  const ShapeFile file = ShapeFile::open(path);
+  ChunkReader reader(file, budget);
+  ShapeChunk c;
+  while (reader.next(c))
+    f(c);
+}
+
+/**
+ * @brief Aggregates shape file
+ * @param path Shape file
+ * @param m Measure for ranking and quantiles
+ * @param top Number of largest shapes to keep
+ * @param budget Memory for buffers in bytes
+ */
+inline Aggregate aggregateFile(const std::string & path, Measure m = Measure::Area, std::size_t top = 10,
+                               std::size_t budget = std::size_t(64) << 20) {
+  Aggregate a(m, top);
+  forEachChunk(path, budget, [&a](const ShapeChunk & c) {
+    for (std::size_t i = 0; i < c.size; ++i) {
+      const double v[ShapeStore::column_count] = { c.cols[0][i], c.cols[1][i], c.cols[2][i],
+                                                   c.cols[3][i], c.cols[4][i] };
+      a.add(c.types[i], v);
+    }
+  });
+  return a;
+}
+
+/**
+ * @brief Runs query over shape file
+ *
+ * Each chunk is loaded in a store, so blocks are still skipped by zone
+ * maps. Rows and values are not collected.
+ * @param q Query
+ * @param path Shape file
+ * @param budget Memory for buffers and the store in bytes
+ * @return Result with count, sum and block statistics
+ */
+inline Query::Result queryFile(const Query & q, const std::string & path,
+                               std::size_t budget = std::size_t(64) << 20) {
+  Query::Result total;
+  ShapeStore store;
+  /* Half of the budget is for the reader and half for the store */
+  forEachChunk(path, budget / 2, [&](const ShapeChunk & c) {
+    store.clear();
+    store.append(c.size, c.types, c.cols);
+    const Query::Result r = q.run(store, false);
+    total.count += r.count;
+    total.sum += r.sum;
+    total.blocks_scanned += r.blocks_scanned;
+    total.blocks_skipped += r.blocks_skipped;
+  });
+  return total;
+}
+
+/** @brief Key for sorting shapes by a column or a measure */
+struct SortKey {
+  /** @brief Whether the key is a measure (or a column) */
+  bool is_measure;
+  /** @brief Index of the column or the measure */
+  unsigned index;
+
+  /** @brief Key by column */
+  static SortKey of(ShapeStore::Column c) { return SortKey { false, unsigned(c) }; }
+  /** @brief Key by measure */
+  static SortKey of(Measure m) { return SortKey { true, unsigned(m) }; }
+
+  /** @brief Retrieves key of a shape */
+  double operator()(ShapeType t, const double * v) const {
+    return is_measure ? Geo::measure(Measure(index), t, v[unsigned(ShapeStore::Column::A)],
+                                     v[unsigned(ShapeStore::Column::B)])
+                      : v[index];
+  }
+};
+
+/**
+ * @brief Sorts shape file by external merge sort
+ *
+ * Chunks fitting in the budget are sorted in memory and written as runs,
+ * which are then merged with a buffer for each run. Groups of as many runs
+ * as the budget and the limit of open files allow are merged into longer
+ * runs in several passes, if needed. The sort is stable and shapes with NaN
+ * keys come last in both orders.
+ * @param in Input shape file
+ * @param out Output shape file
+ * @param key Sort key
+ * @param descending Whether to sort in descending order
+ * @param budget Memory in bytes
+ * @param tmp_prefix Prefix of paths of temporary run files
+ * @return Number of runs
+ */
+inline std::size_t sortFile(const std::string & in, const std::string & out, SortKey key, bool descending = false,
+                            std::size_t budget = std::size_t(64) << 20,
+                            const std::string & tmp_prefix = "/tmp/geosort-") {
+  struct Row {
+    double key;
+    std::uint64_t seq;
+    ShapeType type;
+    double v[ShapeStore::column_count];
+  };
+  auto less = [descending](const Row & a, const Row & b) {
+    const bool an = std::isnan(a.key), bn = std::isnan(b.key);
+    if (an != bn)
+      return bn;
+    if (!an && a.key != b.key)
+      return descending ? a.key > b.key : a.key < b.key;
+    return a.seq < b.seq;
+  };
+  /* Run file with the index of its first row in the input */
+  struct RunFile {
+    std::string path;
+    std::uint64_t first;
+    std::uint64_t size;
+  };
+
+  const ShapeFile src = ShapeFile::open(in);
+  const std::uint64_t n = src.size();
+  std::vector<RunFile> runs;
+  std::vector<std::string> temps;
+  auto tempPath = [&] {
+    temps.push_back(tmp_prefix + std::to_string(::getpid()) + "-" + std::to_string(temps.size()) + ".geo");
+    return temps.back();
+  };
+  std::size_t initial = 0;
+  try {
+    /* Phase 1: sorted runs; the reader takes a third of the budget */
+    {
+      const std::size_t run_rows = std::max<std::size_t>(1, budget * 2 / 3 / sizeof(Row));
+      ChunkReader reader(src, std::min<std::size_t>(budget / 3, run_rows * shape_row_bytes * 2));
+      std::vector<Row> rows;
+      rows.reserve(std::size_t(std::min<std::uint64_t>(run_rows, n)));
+      std::uint64_t first = 0;
+      /* Rows are sorted in place, since sequence numbers make the order
+       * total and the sort stable, and written through a buffer of a
+       * small part of the run */
+      const std::size_t stage_rows = std::max<std::size_t>(1, std::min<std::size_t>(4096, run_rows / 32));
+      std::vector<ShapeType> t(stage_rows);
+      std::vector<double> cols(stage_rows * ShapeStore::column_count);
+      const double * v[ShapeStore::column_count];
+      for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+        v[c] = cols.data() + c * stage_rows;
+      auto flush = [&] {
+        std::sort(rows.begin(), rows.end(), less);
+        runs.push_back(RunFile { tempPath(), first, rows.size() });
+        first += rows.size();
+        const ShapeFile f = ShapeFile::create(runs.back().path, rows.size());
+        for (std::size_t lo = 0; lo < rows.size(); lo += stage_rows) {
+          const std::size_t k = std::min(stage_rows, rows.size() - lo);
+          for (std::size_t i = 0; i < k; ++i) {
+            t[i] = rows[lo + i].type;
+            for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+              cols[c * stage_rows + i] = rows[lo + i].v[c];
+          }
+          f.write(lo, k, t.data(), v);
+        }
+        rows.clear();
+      };
+      ShapeChunk c;
+      while (reader.next(c))
+        for (std::size_t i = 0; i < c.size; ++i) {
+          Row r;
+          r.type = c.types[i];
+          for (unsigned k = 0; k < ShapeStore::column_count; ++k)
+            r.v[k] = c.cols[k][i];
+          r.key = key(r.type, r.v);
+          r.seq = c.first + i;
+          rows.push_back(r);
+          if (rows.size() == run_rows)
+            flush();
+        }
+      if (!rows.empty())
+        flush();
+    }
+    initial = runs.size();
+
+    /* Phase 2: merge groups of runs; each run of a group, the output and
+     * the scratch of reading get an equal buffer, so the fan-in is limited
+     * by the budget and by half of the limit of open files */
+    static constexpr std::size_t min_buf_rows = 1024;
+    std::size_t fan_in = budget / (min_buf_rows * sizeof(Row));
+    fan_in = fan_in > 4 ? fan_in - 2 : 2;
+    struct rlimit rl;
+    if (::getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY)
+      fan_in = std::min<std::size_t>(fan_in, std::max<std::size_t>(std::size_t(rl.rlim_cur / 2), 2));
+
+    struct Run {
+      ShapeFile file;
+      std::uint64_t size;
+      std::uint64_t pos;
+      std::uint64_t first;
+      std::vector<Row> buf;
+      std::size_t next;
+    };
+    auto merge = [&](std::size_t lo, std::size_t hi, const ShapeFile & dst) {
+      const std::size_t buf_rows = std::max<std::size_t>(min_buf_rows, budget / (hi - lo + 2) / sizeof(Row));
+      std::vector<Run> rs;
+      for (std::size_t k = lo; k < hi; ++k)
+        rs.push_back(Run { ShapeFile::open(runs[k].path), runs[k].size, 0, runs[k].first, std::vector<Row>(), 0 });
+      std::vector<ShapeType> t;
+      std::vector<double> cols;
+      auto refill = [&](Run & r) {
+        const std::size_t m = std::size_t(std::min<std::uint64_t>(buf_rows, r.size - r.pos));
+        t.resize(m);
+        cols.resize(m * ShapeStore::column_count);
+        double * v[ShapeStore::column_count];
+        for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+          v[c] = cols.data() + c * m;
+        r.file.read(r.pos, m, t.data(), v);
+        r.buf.resize(m);
+        for (std::size_t i = 0; i < m; ++i) {
+          r.buf[i].type = t[i];
+          for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+            r.buf[i].v[c] = v[c][i];
+          r.buf[i].key = key(t[i], r.buf[i].v);
+          /* Runs are in order of input, so run and position keep the sort stable */
+          r.buf[i].seq = r.first + r.pos + i;
+        }
+        r.pos += m;
+        r.next = 0;
+      };
+
+      typedef std::pair<Row, std::size_t> Head;
+      auto greater = [&less](const Head & a, const Head & b) { return less(b.first, a.first); };
+      std::priority_queue<Head, std::vector<Head>, decltype(greater)> heap(greater);
+      for (std::size_t k = 0; k < rs.size(); ++k)
+        if (rs[k].size > 0) {
+          refill(rs[k]);
+          heap.push(Head(rs[k].buf[rs[k].next++], k));
+        }
+
+      std::vector<ShapeType> ot;
+      std::vector<double> ov[ShapeStore::column_count];
+      std::uint64_t written = 0;
+      auto write = [&] {
+        const double * v[ShapeStore::column_count];
+        for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+          v[c] = ov[c].data();
+        dst.write(written, ot.size(), ot.data(), v);
+        written += ot.size();
+        ot.clear();
+        for (auto & c : ov)
+          c.clear();
+      };
+      while (!heap.empty()) {
+        const Head h = heap.top();
+        heap.pop();
+        ot.push_back(h.first.type);
+        for (unsigned c = 0; c < ShapeStore::column_count; ++c)
+          ov[c].push_back(h.first.v[c]);
+        if (ot.size() == buf_rows)
+          write();
+        Run & r = rs[h.second];
+        if (r.next == r.buf.size() && r.pos < r.size)
+          refill(r);
+        if (r.next < r.buf.size())
+          heap.push(Head(r.buf[r.next++], h.second));
+      }
+      write();
+    };
+
+    while (runs.size() > fan_in) {
+      std::vector<RunFile> longer;
+      for (std::size_t lo = 0; lo < runs.size(); lo += fan_in) {
+        const std::size_t hi = std::min(lo + fan_in, runs.size());
+        if (hi - lo == 1) {
+          longer.push_back(runs[lo]);
+          continue;
+        }
+        std::uint64_t size = 0;
+        for (std::size_t k = lo; k < hi; ++k)
+          size += runs[k].size;
+        longer.push_back(RunFile { tempPath(), runs[lo].first, size });
+        merge(lo, hi, ShapeFile::create(longer.back().path, size));
+        for (std::size_t k = lo; k < hi; ++k)
+          std::remove(runs[k].path.c_str());
+      }
+      runs.swap(longer);
+    }
+    merge(0, runs.size(), ShapeFile::create(out, n));
+  } catch (...) {
+    for (const std::string & r : temps)
+      std::remove(r.c_str());
+    throw;
+  }
+  for (const std::string & r : temps)
+    std::remove(r.c_str());
+  return initial;
+}
+}
+
+#endif
@@ -0,0 +1,421 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geobench-compare.cpp
+ * Comparison of two sets of results written by geobench --json. For each
+ * benchmark outliers are rejected by Tukey's fences, speedup is computed as
+ * ratio of median times with a bootstrap confidence interval and the
+ * difference is tested with two-sided Mann-Whitney U test. Exits with 1 when
+ * any benchmark is significantly slower than the given threshold, so it
+ * could be used as regression gate.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <getopt.h>
+
+/** Samples of each benchmark by name (in order of appearance) */
+typedef std::vector<std::pair<std::string, std::vector<double> > > Results;
+
+/**
+ * Minimal JSON parser sufficient for geobench results. Values, which are
+ * not needed, are parsed and skipped.
+ */
+class Parser {
+private:
+  const std::string & text;
+  std::size_t pos;
+
+  [[noreturn]] void fail(const std::string & what) const {
+    throw std::runtime_error(what + " at offset " + std::to_string(pos));
+  }
+
+  void space(void) {
+    while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+      ++pos;
+  }
+
+  bool accept(char c) {
+    space();
+    if (pos < text.size() && text[pos] == c) {
+      ++pos;
+      return true;
+    }
+    return false;
+  }
+
+  void expect(char c) {
+    if (!accept(c))
+      fail(std::string("expected '") + c + "'");
+  }
+
+  std::string string(void) {
+    expect('"');
+    std::string s;
+    while (pos < text.size() && text[pos] != '"') {
+      char c = text[pos++];
+      if (c == '\\' && pos < text.size()) {
+        c = text[pos++];
+        switch (c) {
+        case 'n': c = '\n'; break;
+        case 't': c = '\t'; break;
+        case 'u': pos += 4; c = '?'; break;
+        default: break;
+        }
+      }
+      s += c;
+    }
+    expect('"');
+    return s;
+  }
+
+  double number(void) {
+    space();
+    const char * b = text.c_str() + pos;
+    char * e = nullptr;
+    const double v = std::strtod(b, &e);
+    if (e == b)
+      fail("expected number");
+    pos += std::size_t(e - b);
+    return v;
+  }
+
+  void skip(void) {
+    space();
+    if (pos >= text.size())
+      fail("unexpected end");
+    const char c = text[pos];
+    if (c == '"')
+      string();
+    else if (c == '{') {
+      ++pos;
+      if (!accept('}')) {
+        do {
+          string();
+          expect(':');
+          skip();
+        } while (accept(','));
+        expect('}');
+      }
+    } else if (c == '[') {
+      ++pos;
+      if (!accept(']')) {
+        do
+          skip();
+        while (accept(','));
+        expect(']');
+      }
+    } else if (text.compare(pos, 4, "true") == 0 || text.compare(pos, 4, "null") == 0)
+      pos += 4;
+    else if (text.compare(pos, 5, "false") == 0)
+      pos += 5;
+    else
+      number();
+  }
+
+  void benchmark(Results & r) {
+    std::string name;
+    std::vector<double> samples;
+    expect('{');
+    if (!accept('}')) {
+      do {
+        const std::string key = string();
+        expect(':');
+        if (key == "name")
+          name = string();
+        else if (key == "samples") {
+          expect('[');
+          if (!accept(']')) {
+            do
+              samples.push_back(number());
+            while (accept(','));
+            expect(']');
+          }
+        } else
+          skip();
+      } while (accept(','));
+      expect('}');
+    }
+    if (name.empty())
+      fail("benchmark without name");
+    r.emplace_back(name, samples);
+  }
+
+public:
+  explicit Parser(const std::string & t) : text(t), pos(0) {}
+
+  /** Parses results object */
+  Results results(void) {
+    Results r;
+    expect('{');
+    if (!accept('}')) {
+      do {
+        const std::string key = string();
+        expect(':');
+        if (key == "benchmarks") {
+          expect('[');
+          if (!accept(']')) {
+            do
+              benchmark(r);
+            while (accept(','));
+            expect(']');
+          }
+        } else
+          skip();
+      } while (accept(','));
+      expect('}');
+    }
+    return r;
+  }
+};
+
+static Results load(const char * path) {
+  std::ifstream in(path);
+  if (!in)
+    throw std::runtime_error(std::string("cannot open '") + path + "'");
+  std::stringstream ss;
+  ss << in.rdbuf();
+  const std::string text = ss.str();
+  try {
+    return Parser(text).results();
+  } catch (const std::runtime_error & e) {
+    throw std::runtime_error(std::string(path) + ": " + e.what());
+  }
+}
+
+/** Retrieves quantile of sorted samples with linear interpolation */
+static double quantile(const std::vector<double> & s, double q) {
+  if (s.empty())
+    return NAN;
+  const double h = q * double(s.size() - 1);
+  const std::size_t i = std::size_t(h);
+  if (i + 1 >= s.size())
+    return s.back();
+  return s[i] + (h - double(i)) * (s[i + 1] - s[i]);
+}
+
+/** Sorts samples and rejects outliers outside Tukey's fences (1.5 IQR) */
+static std::vector<double> rejectOutliers(std::vector<double> s) {
+  std::sort(s.begin(), s.end());
+  if (s.size() < 4)
+    return s;
+  const double q1 = quantile(s, 0.25), q3 = quantile(s, 0.75);
+  const double lo = q1 - 1.5 * (q3 - q1), hi = q3 + 1.5 * (q3 - q1);
+  std::vector<double> r;
+  for (double v : s)
+    if (v >= lo && v <= hi)
+      r.push_back(v);
+  return r;
+}
+
+static double median(std::vector<double> s) {
+  std::sort(s.begin(), s.end());
+  return quantile(s, 0.5);
+}
+
+/**
+ * Confidence interval of speedup (ratio of base to new median) by
+ * percentile bootstrap. Generator is seeded constantly, so results are
+ * reproducible.
+ */
+static void bootstrap(const std::vector<double> & base, const std::vector<double> & cur,
+                      double level, unsigned rounds, double & lo, double & hi) {
+  std::uint64_t state = 0x9e3779b97f4a7c15ULL;
+  auto next = [&state](std::size_t n) {
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return std::size_t((z ^ (z >> 31)) % n);
+  };
+  std::vector<double> ratios(rounds), a(base.size()), b(cur.size());
+  for (unsigned r = 0; r < rounds; ++r) {
+    for (double & v : a)
+      v = base[next(base.size())];
+    for (double & v : b)
+      v = cur[next(cur.size())];
+    ratios[r] = median(a) / median(b);
+  }
+  std::sort(ratios.begin(), ratios.end());
+  lo = quantile(ratios, (1 - level) / 2);
+  hi = quantile(ratios, (1 + level) / 2);
+}
+
+/**
+ * Two-sided Mann-Whitney U test. Exact distribution is used for small
+ * samples without ties, otherwise normal approximation with tie and
+ * continuity corrections.
+ * @return p-value
+ */
+static double mannWhitney(const std::vector<double> & x, const std::vector<double> & y) {
+  const std::size_t n1 = x.size(), n2 = y.size(), n = n1 + n2;
+  if (n1 == 0 || n2 == 0)
+    return 1;
+  std::vector<std::pair<double, int> > all;
+  for (double v : x)
+    all.emplace_back(v, 0);
+  for (double v : y)
+    all.emplace_back(v, 1);
+  std::sort(all.begin(), all.end());
+  double r1 = 0, ties = 0;
+  for (std::size_t i = 0; i < n; ) {
+    std::size_t j = i;
+    while (j < n && all[j].first == all[i].first)
+      ++j;
+    const double rank = double(i + j + 1) / 2;
+    for (std::size_t k = i; k < j; ++k)
+      if (all[k].second == 0)
+        r1 += rank;
+    const double t = double(j - i);
+    ties += t * t * t - t;
+    i = j;
+  }
+  const double u1 = r1 - double(n1 * (n1 + 1)) / 2;
+  const double u = std::min(u1, double(n1 * n2) - u1);
+
+  if (ties == 0 && n <= 40) {
+    /* Number of arrangements with each U by recurrence
+       f(u; m, k) = f(u - k; m - 1, k) + f(u; m, k - 1) */
+    const std::size_t umax = n1 * n2;
+    std::vector<std::vector<double> > f(n2 + 1, std::vector<double>(umax + 1, 0));
+    for (std::size_t k = 0; k <= n2; ++k)
+      f[k][0] = 1;
+    for (std::size_t m = 1; m <= n1; ++m) {
+      std::vector<std::vector<double> > g(n2 + 1, std::vector<double>(umax + 1, 0));
+      g[0][0] = 1;
+      for (std::size_t k = 1; k <= n2; ++k)
+        for (std::size_t v = 0; v <= m * k; ++v)
+          g[k][v] = (v >= k ? f[k][v - k] : 0) + g[k - 1][v];
+      f.swap(g);
+    }
+    double below = 0, total = 0;
+    for (std::size_t v = 0; v <= umax; ++v) {
+      total += f[n2][v];
+      if (double(v) <= u)
+        below += f[n2][v];
+    }
+    return std::min(1.0, 2 * below / total);
+  }
+
+  const double mean = double(n1 * n2) / 2;
+  const double var = double(n1 * n2) / 12 * (double(n + 1) - ties / double(n * (n - 1)));
+  if (var <= 0)
+    return 1;
+  const double z = (mean - u - 0.5) / std::sqrt(var);
+  return std::min(1.0, std::erfc(std::max(0.0, z) / std::sqrt(2.0)));
+}
+
+static void usage(const char * prog) {
+  std::fprintf(stderr,
+    "Usage: %s [options] BASE.json NEW.json\n"
+    "  -a, --alpha P          significance level (default 0.05)\n"
+    "  -t, --threshold F      tolerated slowdown as fraction (default 0.05)\n"
+    "  -c, --confidence L     level of speedup interval (default 0.95)\n"
+    "Exits with 1 when a benchmark is significantly slower than the threshold.\n", prog);
+}
+
+/**
+ * Benchmark comparison program
+ */
+int main(int argc, char * argv[]) {
+  double alpha = 0.05, threshold = 0.05, confidence = 0.95;
+  static const option longopts[] = {
+    { "alpha",      required_argument, nullptr, 'a' },
+    { "threshold",  required_argument, nullptr, 't' },
+    { "confidence", required_argument, nullptr, 'c' },
+    { "help",       no_argument,       nullptr, 'h' },
+    { nullptr, 0, nullptr, 0 }
+  };
+  int c;
+  while ((c = getopt_long(argc, argv, "a:t:c:h", longopts, nullptr)) != -1) {
+    switch (c) {
+    case 'a': alpha = std::atof(optarg); break;
+    case 't': threshold = std::atof(optarg); break;
+    case 'c': confidence = std::atof(optarg); break;
+    default:
+      usage(argv[0]);
+      return c == 'h' ? 0 : 2;
+    }
+  }
+  if (argc - optind != 2 || alpha <= 0 || alpha >= 1 || threshold < 0 || confidence <= 0 || confidence >= 1) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  Results base, cur;
+  try {
+    base = load(argv[optind]);
+    cur = load(argv[optind + 1]);
+  } catch (const std::exception & e) {
+    std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+    return 2;
+  }
+
+  std::map<std::string, const std::vector<double> *> by_name;
+  for (const auto & b : base)
+    by_name[b.first] = &b.second;
+
+  unsigned regressions = 0;
+  std::printf("%-28s %12s %12s %8s %19s %9s\n", "benchmark (ns/element)", "base", "new",
+              "speedup", "interval", "p-value");
+  for (const auto & b : cur) {
+    const auto it = by_name.find(b.first);
+    if (it == by_name.end()) {
+      std::printf("%-28s %12s %12.3f %8s %19s %9s  new\n", b.first.c_str(), "-", median(b.second), "", "", "");
+      continue;
+    }
+    const std::vector<double> x = rejectOutliers(*it->second), y = rejectOutliers(b.second);
+    by_name.erase(it);
+    if (x.empty() || y.empty()) {
+      std::printf("%-28s %12s %12s %8s %19s %9s  no samples\n", b.first.c_str(), "", "", "", "", "");
+      continue;
+    }
+    const double mx = median(x), my = median(y), speedup = mx / my;
+    double lo, hi;
+    bootstrap(x, y, confidence, 2000, lo, hi);
+    const double p = mannWhitney(x, y);
+    const char * verdict = "";
+    if (p < alpha && speedup < 1 / (1 + threshold)) {
+      verdict = "REGRESSION";
+      ++regressions;
+    } else if (p < alpha && speedup > 1 + threshold)
+      verdict = "faster";
+    std::printf("%-28s %12.3f %12.3f %7.3fx [%7.3fx, %7.3fx] %9.4f  %s\n", b.first.c_str(), mx, my,
+                speedup, lo, hi, p, verdict);
+  }
+  for (const auto & b : base)
+    if (by_name.count(b.first))
+      std::printf("%-28s %12.3f %12s %8s %19s %9s  removed\n", b.first.c_str(), median(b.second), "-", "", "", "");
+
+  if (regressions > 0) {
+    std::printf("%u significant regression(s)\n", regressions);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,507 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geobench.cpp
+ * Benchmark of operations over shapes with hardware performance counters.
+ * Compares the virtual Shape pointer path with the devirtualized and
+ * columnar ones by time, branch misses and cache misses per shape, and
+ * NUMA partitions processed on their own node against the next one. Each
+ * benchmark is repeated and the samples could be written in JSON for
+ * comparison by geobench-compare.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <getopt.h>
+#include <unistd.h>
+
+#include "geo.hpp"
+#include "geo_static.hpp"
+#include "geo_polycollection.hpp"
+#include "geo_expr.hpp"
+#include "geo_store.hpp"
+#include "geo_query.hpp"
+#include "geo_aggregate.hpp"
+#include "geo_bitmap.hpp"
+#include "geo_cache.hpp"
+#include "geo_csg.hpp"
+#include "geo_bounds.hpp"
+#include "geo_montecarlo.hpp"
+#include "geo_offset.hpp"
+#include "geo_overlap.hpp"
+#include "geo_quantized.hpp"
+#include "geo_ray.hpp"
+#include "geo_sdf.hpp"
+#include "geo_dispatch.hpp"
+#include "geo_numa.hpp"
+#include "geo_perf.hpp"
+
+/* Keeps results alive, so the measured work is not optimized away */
+static volatile double sink;
+
+/** Benchmarked operation */
+struct Benchmark {
+  std::string name;
+  std::size_t elements;
+  std::function<void()> run;
+};
+
+/* Size of the last level cache in bytes (32 MB when not known) */
+static std::size_t lastLevelCache(void) {
+  long size = -1;
+#ifdef _SC_LEVEL3_CACHE_SIZE
+  size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+  if (size <= 0)
+    size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+  return size > 0 ? std::size_t(size) : std::size_t(32) << 20;
+}
+
+static void usage(const char * prog) {
+  std::fprintf(stderr,
+    "Usage: %s [options] [number of shapes]\n"
+    "  -r, --repetitions N  repetitions of each benchmark (default 5)\n"
+    "  -j, --json FILE      write samples in JSON for geobench-compare\n"
+    "  -H, --huge-pages P   huge pages for the store: none, thp, 2m or 1g (default none)\n", prog);
+}
+
+/**
+ * Benchmark program
+ */
+int main(int argc, char * argv[]) {
+  std::size_t n = 1000000;
+  unsigned reps = 5;
+  std::string json;
+  Geo::HugePages hp = Geo::HugePages::None;
+  static const option longopts[] = {
+    { "repetitions", required_argument, nullptr, 'r' },
+    { "json",        required_argument, nullptr, 'j' },
+    { "huge-pages",  required_argument, nullptr, 'H' },
+    { "help",        no_argument,       nullptr, 'h' },
+    { nullptr, 0, nullptr, 0 }
+  };
+  int c;
+  while ((c = getopt_long(argc, argv, "r:j:H:h", longopts, nullptr)) != -1) {
+    switch (c) {
+    case 'r': reps = unsigned(std::max(1, std::atoi(optarg))); break;
+    case 'j': json = optarg; break;
+    case 'H': {
+      unsigned k = 0;
+      while (k < 4 && std::strcmp(optarg, Geo::hugePagesName(Geo::HugePages(k))) != 0)
+        ++k;
+      if (k == 4) {
+        usage(argv[0]);
+        return 1;
+      }
+      hp = Geo::HugePages(k);
+      break;
+    }
+    default:
+      usage(argv[0]);
+      return c == 'h' ? 0 : 1;
+    }
+  }
+  if (optind < argc)
+    n = std::strtoul(argv[optind], nullptr, 10);
+  if (n == 0) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  std::mt19937_64 rng(42);
+  std::uniform_real_distribution<double> coord(-1000, 1000);
+  std::uniform_real_distribution<double> size(0.1, 10);
+  std::uniform_int_distribution<int> kind(0, Geo::shape_type_count - 1);
+
+  std::vector<std::unique_ptr<Geo::Shape> > owned;
+  Geo::PolyCollection coll;
+  Geo::ShapeStore store(Geo::ShapeStore::default_block_size, hp);
+  owned.reserve(n);
+  store.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    const double x = coord(rng), y = coord(rng), z = coord(rng), a = size(rng), b = size(rng);
+    switch (Geo::ShapeType(kind(rng))) {
+    case Geo::ShapeType::Circle:
+      owned.emplace_back(new Geo::Circle(x, y, a));
+      coll.insert(Geo::Circle(x, y, a));
+      store.append(Geo::ShapeType::Circle, x, y, 0, a);
+      break;
+    case Geo::ShapeType::Rectangle:
+      owned.emplace_back(new Geo::Rectangle(x, y, a, b));
+      coll.insert(Geo::Rectangle(x, y, a, b));
+      store.append(Geo::ShapeType::Rectangle, x, y, 0, a, b);
+      break;
+    case Geo::ShapeType::Square:
+      owned.emplace_back(new Geo::Square(x, y, a));
+      coll.insert(Geo::Square(x, y, a));
+      store.append(Geo::ShapeType::Square, x, y, 0, a);
+      break;
+    case Geo::ShapeType::Sphere:
+      owned.emplace_back(new Geo::Sphere(Geo::Coord3D(x, y, z), a));
+      coll.insert(Geo::Sphere(Geo::Coord3D(x, y, z), a));
+      store.append(Geo::ShapeType::Sphere, x, y, z, a);
+      break;
+    case Geo::ShapeType::Cube:
+      owned.emplace_back(new Geo::Cube(Geo::Coord3D(x, y, z), a));
+      coll.insert(Geo::Cube(Geo::Coord3D(x, y, z), a));
+      store.append(Geo::ShapeType::Cube, x, y, z, a);
+      break;
+    }
+  }
+  std::vector<Geo::Shape *> shapes;
+  shapes.reserve(n);
+  for (auto & s : owned)
+    shapes.push_back(s.get());
+  std::shuffle(shapes.begin(), shapes.end(), rng);
+
+  std::vector<Geo::StaticSphere> spheres;
+  for (const Geo::Sphere & s : coll.segment<Geo::Sphere>()) {
+    Geo::Sphere c(s);
+    spheres.push_back(Geo::StaticSphere(c.getRefPoint(), c.getRadius()));
+  }
+
+  std::vector<double> dim_a(n / Geo::shape_type_count + 1), dim_b(dim_a.size()), out(dim_a.size());
+  for (std::size_t i = 0; i < dim_a.size(); ++i) {
+    dim_a[i] = size(rng);
+    dim_b[i] = size(rng);
+  }
+  // NUMA rows scan twice the last level cache of every node, so partitions
+  // are read from memory of their nodes instead of from cache
+  const Geo::PartitionedStore parts = [&] {
+    const std::size_t row = sizeof(Geo::ShapeType) + Geo::ShapeStore::column_count * sizeof(double);
+    const std::size_t rows = std::max(n, 2 * lastLevelCache() * Geo::numaNodes().size() / row);
+    Geo::ShapeStore big(Geo::ShapeStore::default_block_size, hp);
+    big.reserve(rows);
+    const double * v[Geo::ShapeStore::column_count];
+    for (unsigned c = 0; c < Geo::ShapeStore::column_count; ++c)
+      v[c] = store.column(Geo::ShapeStore::Column(c));
+    for (std::size_t first = 0; first < rows; first += n)
+      big.append(std::min(n, rows - first), store.types(), v);
+    return Geo::PartitionedStore(big);
+  }();
+  const Geo::Query q = Geo::Query::parse("select volume where type == Sphere and radius > 5 and z between 0 and 100");
+  const std::uint64_t aggregate_tag = Geo::hashBytes("aggregate", 9);
+  Geo::ResultCache<double> cache(64);
+  Geo::ShapeBounds bounds(store);
+  const Geo::QuantizedStore16 store16(store);
+  const Geo::QuantizedStore32 store32(store);
+  const Geo::RayScene scene(store);
+  std::uniform_real_distribution<double> dir(-1, 1);
+  std::vector<Geo::Ray3D> rays(4096);
+  for (std::size_t i = 0; i < rays.size(); i += 16) {
+    // Bundles of 16 nearly parallel rays from nearby origins, like tiles of a camera
+    const Geo::Coord3D o(coord(rng), coord(rng), coord(rng)), d(dir(rng), dir(rng), dir(rng));
+    for (std::size_t k = 0; k < 16; ++k)
+      rays[i + k] = Geo::Ray3D { Geo::Coord3D(o.getX() + k % 4, o.getY() + k / 4, o.getZ()),
+                                 Geo::Coord3D(d.getX() + dir(rng) / 100, d.getY() + dir(rng) / 100,
+                                              d.getZ() + dir(rng) / 100), 200 };
+  }
+  std::vector<Geo::RayHit> hits(rays.size());
+  std::uniform_int_distribution<std::uint32_t> row(0, std::uint32_t(n - 1));
+  std::vector<std::uint32_t> pair_first(n), pair_second(n), kind_first[Geo::overlap_kind_count],
+                             kind_second[Geo::overlap_kind_count];
+  std::vector<double> kind_first_height[Geo::overlap_kind_count], kind_second_height[Geo::overlap_kind_count];
+  std::vector<double> overlap(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    pair_first[i] = std::uint32_t(i);
+    pair_second[i] = row(rng);
+    Geo::OverlapKind k;
+    bool swap;
+    if (Geo::overlapKind(store.type(i), store.type(pair_second[i]), k, swap)) {
+      kind_first[unsigned(k)].push_back(swap ? pair_second[i] : pair_first[i]);
+      kind_second[unsigned(k)].push_back(swap ? pair_first[i] : pair_second[i]);
+      kind_first_height[unsigned(k)].push_back(Geo::rectangleHeight(store, kind_first[unsigned(k)].back()));
+      kind_second_height[unsigned(k)].push_back(Geo::rectangleHeight(store, kind_second[unsigned(k)].back()));
+    }
+  }
+  // A cluster of spheres with cubes cut out of it
+  std::uniform_real_distribution<double> near(-20, 20);
+  Geo::CompositeBody body;
+  for (std::size_t i = 0; i < 48; ++i)
+    body.unite(Geo::Sphere(Geo::Coord3D(near(rng), near(rng), near(rng)), size(rng)));
+  for (std::size_t i = 0; i < 16; ++i)
+    body.subtract(Geo::Cube(Geo::Coord3D(near(rng), near(rng), near(rng)), size(rng)));
+  Geo::EstimateOptions mc_volume;
+  mc_volume.tolerance = 0;
+  mc_volume.area = false;
+  mc_volume.max_points = std::uint64_t(1) << 22;
+  Geo::EstimateOptions mc_area = mc_volume;
+  mc_area.area = true;
+  mc_area.area_tolerance = 0;
+  const std::size_t mc_volume_points = std::size_t(Geo::estimateVolume(body, mc_volume).points);
+  const std::size_t mc_area_points = std::size_t(Geo::estimateVolume(body, mc_area).points);
+  // The same cluster as a tree, probed at points around it
+  const Geo::CsgTree3D tree = body.tree();
+  const Geo::CsgTape<3> tape = tree.compile();
+  std::vector<double> probe[3];
+  for (std::vector<double> & c : probe)
+    for (std::size_t i = 0; i < 65536; ++i)
+      c.push_back(near(rng) * 1.25);
+  const double * const probe_cols[3] = { probe[0].data(), probe[1].data(), probe[2].data() };
+  std::vector<double> probe_in(probe[0].size());
+  std::vector<double> probe_d(probe[0].size());
+  const Geo::SdfGrid3D grid(tree, 0.25, 1);
+
+  std::vector<double> ratio(store.size());
+
+  std::vector<Benchmark> benchmarks = {
+    { "Shape* single call area", 1, [&] { sink = shapes[0]->area(); } },
+    { "Shape* area", n, [&] {
+        double t = 0;
+        for (Geo::Shape * s : shapes)
+          t += s->area();
+        sink = t;
+      } },
+    { "Shape* perimeter", n, [&] {
+        double t = 0;
+        for (Geo::Shape * s : shapes)
+          t += s->perimeter();
+        sink = t;
+      } },
+    { "Shape* sphere volume", n, [&] {
+        double t = 0;
+        for (Geo::Shape * s : shapes)
+          if (Geo::Sphere * sp = dynamic_cast<Geo::Sphere *>(s))
+            t += sp->volume();
+        sink = t;
+      } },
+    { "PolyCollection area", n, [&] { sink = coll.totalArea(); } },
+    { "PolyCollection perimeter", n, [&] { sink = coll.totalPerimeter(); } },
+    { "PolyCollection volume", n, [&] { sink = coll.totalVolume(); } },
+    { "PolyCollection compute area/perimeter", n, [&] {
+        sink = coll.compute(Geo::Metric::area() / Geo::Metric::perimeter()).back();
+      } },
+    { "store compute area/perimeter", n, [&] {
+        store.compute(Geo::Metric::area() / Geo::Metric::perimeter(), ratio.data());
+        sink = ratio.back();
+      } },
+    { "StaticSphere volume", spheres.size(), [&] { sink = Geo::sum(spheres, Geo::VolumeOf()); } },
+    { "store query", n, [&] { sink = q.run(store, false).sum; } },
+    { "content hash", n, [&] { sink = double(Geo::batchHash(store).lo); } },
+    { "store aggregate", n, [&] {
+        Geo::Aggregate a(Geo::Measure::Volume);
+        a.add(store);
+        sink = a.quantile(0.5);
+      } },
+    { "cached store aggregate", n, [&] {
+        sink = *cache.getOrCompute(Geo::batchHash(store, aggregate_tag), [&] {
+          Geo::Aggregate a(Geo::Measure::Volume);
+          a.add(store);
+          return a.quantile(0.5);
+        });
+      } },
+    { "store bounds", n, [&] {
+        bounds.compute(store);
+        sink = bounds.radius()[0];
+      } },
+    { "quantized bounds", n, [&] {
+        const Geo::QuantizedBounds qb(bounds);
+        sink = qb.sphere(0).radius;
+      } },
+    { "Shape* bounding box", n, [&] {
+        double t = 0;
+        for (Geo::Shape * s : shapes)
+          if (Geo::Shape2D * s2 = dynamic_cast<Geo::Shape2D *>(s))
+            t += s2->boundingBox().max.getX();
+        sink = t;
+      } },
+    { "mixed kernel area double", n, [&] {
+        const Geo::QuantizedKernelFn<double> k = Geo::dispatchQuantizedKernel<double>(Geo::Measure::Area);
+        std::vector<double> buf(store.blockSize());
+        double t = 0;
+        for (std::size_t first = 0; first < store.size(); first += store.blockSize()) {
+          const Geo::QuantizedBatch<double> in = { store.types() + first,
+                                                   store.column(Geo::ShapeStore::Column::A) + first,
+                                                   store.column(Geo::ShapeStore::Column::B) + first,
+                                                   0, 1, 0, 1, std::min(store.blockSize(), store.size() - first) };
+          k(in, buf.data());
+#pragma omp simd reduction(+ : t)
+          for (std::size_t i = 0; i < in.n; ++i)
+            t += buf[i];
+        }
+        sink = t;
+      } },
+    { "quantized 32-bit area", n, [&] { sink = store32.sum(Geo::Measure::Area); } },
+    { "quantized 16-bit area", n, [&] { sink = store16.sum(Geo::Measure::Area); } },
+    { "Shape* ray intersect", n * 4, [&] {
+        double t = std::numeric_limits<double>::infinity();
+        for (std::size_t k = 0; k < 4; ++k)
+          for (Geo::Shape * s : shapes)
+            if (Geo::Sphere * sp = dynamic_cast<Geo::Sphere *>(s))
+              t = std::min(t, Geo::intersect(rays[k], *sp));
+            else if (Geo::Cube * cu = dynamic_cast<Geo::Cube *>(s))
+              t = std::min(t, Geo::intersect(rays[k], *cu));
+        sink = t;
+      } },
+    { "ray scene build", n, [&] { sink = double(Geo::RayScene(store).nodeCount()); } },
+    { "ray cast", rays.size(), [&] {
+        double t = 0;
+        for (const Geo::Ray3D & r : rays)
+          t += scene.cast(r).hit();
+        sink = t;
+      } },
+    { "ray packet 8", rays.size(), [&] {
+        for (std::size_t i = 0; i < rays.size(); i += 8)
+          scene.castPacket<8>(&rays[i], &hits[i]);
+        sink = hits.back().t;
+      } },
+    { "ray batch threads", rays.size(), [&] {
+        scene.cast(rays.data(), rays.size(), hits.data());
+        sink = hits.back().t;
+      } },
+    { "store offset area", n, [&] { sink = Geo::offsetSum(store, Geo::Measure::Area, 0.5); } },
+    { "store offset volume", n, [&] { sink = Geo::offsetSum(store, Geo::Measure::Volume, 0.5); } },
+    { "overlaps of mixed pairs", n, [&] {
+        Geo::overlaps(store, pair_first.data(), pair_second.data(), n, overlap.data());
+        sink = overlap.back();
+      } },
+    { "monte carlo volume", mc_volume_points, [&] { sink = Geo::estimateVolume(body, mc_volume).volume; } },
+    { "monte carlo volume and area", mc_area_points, [&] { sink = Geo::estimateVolume(body, mc_area).area; } },
+    { "CSG tree contains", probe_in.size(), [&] {
+        double t = 0;
+        for (std::size_t i = 0; i < probe_in.size(); ++i)
+          t += tree.contains(Geo::Coord3D(probe[0][i], probe[1][i], probe[2][i]));
+        sink = t;
+      } },
+    { "CSG tape contains", probe_in.size(), [&] {
+        tape.contains(probe_cols, probe_in.size(), probe_in.data());
+        sink = probe_in.back();
+      } },
+    { "CSG measure", 1, [&] { sink = tree.measure().value; } },
+    { "SDF per shape loop", probe_d.size(), [&] {
+        double t = 0;
+        for (std::size_t i = 0; i < probe_d.size(); ++i) {
+          const Geo::Coord3D p(probe[0][i], probe[1][i], probe[2][i]);
+          double d = std::numeric_limits<double>::infinity();
+          for (const Geo::CompositeBody::Term & u : body.terms())
+            if (u.op == Geo::CsgCode::Union)
+              d = std::min(d, Geo::signedDistance(Geo::Sphere(Geo::Coord3D(u.c[0], u.c[1], u.c[2]), u.r), p));
+          for (const Geo::CompositeBody::Term & u : body.terms())
+            if (u.op == Geo::CsgCode::Difference)
+              d = std::max(d, -Geo::signedDistance(Geo::Cube(Geo::Coord3D(u.lo[0], u.lo[1], u.lo[2]), u.hi[0] - u.lo[0]), p));
+          t += d;
+        }
+        sink = t;
+      } },
+    { "SDF tape batch", probe_d.size(), [&] {
+        Geo::signedDistance(tape, probe_cols, probe_d.size(), probe_d.data());
+        sink = probe_d.back();
+      } },
+    { "SDF grid build", 1, [&] { sink = double(Geo::SdfGrid3D(tree, 0.25, 1).bricks()); } },
+    { "SDF grid distance", probe_d.size(), [&] {
+        grid.distance(probe_cols, probe_d.size(), probe_d.data());
+        sink = probe_d.back();
+      } },
+    { "SDF grid clamped", probe_d.size(), [&] {
+        grid.clamped(probe_cols, probe_d.size(), probe_d.data());
+        sink = probe_d.back();
+      } },
+    { "bitmap index build", n, [&] {
+        Geo::ShapeIndex idx(store, 0.5, 32);
+        sink = double(idx.count(Geo::ShapeType::Square, 7));
+      } }
+  };
+  for (Geo::Measure m : { Geo::Measure::Area, Geo::Measure::Volume })
+    for (auto a : { Geo::PartitionedStore::Affinity::Local, Geo::PartitionedStore::Affinity::Remote })
+      benchmarks.push_back({ std::string("NUMA ") + (m == Geo::Measure::Area ? "area " : "volume ") +
+                             (a == Geo::PartitionedStore::Affinity::Local ? "local" : "remote"),
+                             parts.size(), [&, m, a] { sink = parts.sum(m, 0, a); } });
+  static const char * const kinds[Geo::overlap_kind_count] = {
+    "circles", "rectangles", "circle-rect", "spheres", "cubes", "sphere-cube"
+  };
+  for (unsigned k = 0; k < Geo::overlap_kind_count; ++k)
+    for (Geo::Isa isa : { Geo::Isa::Scalar, Geo::activeIsa() }) {
+      const Geo::OverlapKernelFn f = Geo::overlapKernel(Geo::OverlapKind(k), isa);
+      benchmarks.push_back({ std::string("overlap ") + kinds[k] + " " + Geo::isaName(isa),
+                             kind_first[k].size(), [&, f, k] {
+        Geo::PairBatch in;
+        for (unsigned c = 0; c < Geo::ShapeStore::column_count; ++c)
+          in.v[c] = store.column(Geo::ShapeStore::Column(c));
+        in.first = kind_first[k].data();
+        in.second = kind_second[k].data();
+        in.first_height = kind_first_height[k].data();
+        in.second_height = kind_second_height[k].data();
+        in.n = kind_first[k].size();
+        f(in, overlap.data());
+        sink = overlap[0];
+      } });
+    }
+  static const char * const measures[Geo::measure_count] = { "area", "perimeter", "volume" };
+  for (unsigned m = 0; m < Geo::measure_count; ++m)
+    for (unsigned t = 0; t < Geo::shape_type_count; ++t) {
+      Geo::KernelFn<double> k = Geo::dispatchKernel<double>(Geo::Measure(m), Geo::ShapeType(t), Geo::Layout::Columnar);
+      benchmarks.push_back({ std::string("kernel ") + Geo::typeName(Geo::ShapeType(t)) + " " + measures[m],
+                             dim_a.size(), [&, k] {
+        Geo::Batch<double> in = { dim_a.data(), dim_b.data(), dim_a.size() };
+        k(in, out.data());
+        sink = out.back();
+      } });
+    }
+
+  Geo::PerfCounters pc;
+  std::printf("%zu shapes, %u repetitions, batch kernels for %s, %zu MB of store in huge pages (%s)\n",
+              n, reps, Geo::isaName(Geo::activeIsa()), store.hugePageBytes() >> 20, Geo::hugePagesName(hp));
+  Geo::printPerElementHeader(stdout);
+  std::vector<std::vector<double> > samples;
+  for (const Benchmark & b : benchmarks) {
+    std::vector<Geo::PerfSample> runs;
+    for (unsigned r = 0; r < reps; ++r)
+      runs.push_back(pc.measure(b.elements, b.run));
+    std::sort(runs.begin(), runs.end(), [](const Geo::PerfSample & x, const Geo::PerfSample & y) {
+      return x.nanoseconds < y.nanoseconds;
+    });
+    Geo::printPerElement(stdout, b.name, runs[runs.size() / 2]);
+    samples.emplace_back();
+    for (const Geo::PerfSample & r : runs)
+      samples.back().push_back(r.nsPerElement());
+  }
+
+  if (!json.empty()) {
+    std::FILE * f = std::fopen(json.c_str(), "w");
+    if (!f) {
+      std::perror(json.c_str());
+      return 1;
+    }
+    std::fprintf(f, "{\n  \"context\": { \"shapes\": %zu, \"repetitions\": %u, \"isa\": \"%s\" },\n",
+                 n, reps, Geo::isaName(Geo::activeIsa()));
+    std::fprintf(f, "  \"benchmarks\": [\n");
+    for (std::size_t i = 0; i < benchmarks.size(); ++i) {
+      std::fprintf(f, "    { \"name\": \"%s\", \"unit\": \"ns/element\", \"samples\": [",
+                   benchmarks[i].name.c_str());
+      for (std::size_t k = 0; k < samples[i].size(); ++k)
+        std::fprintf(f, "%s%.17g", k ? ", " : "", samples[i][k]);
+      std::fprintf(f, "] }%s\n", i + 1 < benchmarks.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    std::fclose(f);
+  }
+  const Geo::CacheStats cs = cache.stats();
+  std::printf("result cache: %llu hits, %llu misses, hit rate %.3f\n", (unsigned long long)cs.hits,
+              (unsigned long long)cs.misses, cs.hitRate());
+  return 0;
+}
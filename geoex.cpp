@@ -21,13 +21,97 @@
  * Test module for the class hierarchy from Geo namespace
  */
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
 
 #include "geo.hpp"
+#include "geo_static.hpp"
+#include "geo_polycollection.hpp"
+#include "geo_expr.hpp"
+#include "geo_query.hpp"
+#include "geo_sdf.hpp"
+#include "geo_ray.hpp"
+#include "geo_dispatch.hpp"
+#include "geo_overlap.hpp"
+#include "geo_offset.hpp"
+#include "geo_quantized.hpp"
+#include "geo_io.hpp"
+#include "geo_stream.hpp"
 
 using std::cout;
 using std::endl;
 
+/** Number of failed checks */
+static int failures = 0;
+
+/**
+ * Reports a failed check
+ * @param ok Whether the check passed
+ * @param what Description of the check
+ */
+static void check(bool ok, const std::string & what) {
+  if (!ok) {
+    std::cerr << "Check failed: " << what << endl;
+    ++failures;
+  }
+}
+
+/**
+ * Compares calculated value with expected one
+ * @param v Calculated value
+ * @param e Expected value
+ * @param rel Relative tolerance
+ */
+static bool near(double v, double e, double rel) {
+  return std::fabs(v - e) <= rel * std::fabs(e);
+}
+
+/** Closed interval, empty when the ends are equal */
+typedef std::pair<double, double> Span;
+
+/** Span of a disk at a distance from its center */
+static Span chord(double c, double r, double d) {
+  const double h = d * d < r * r ? std::sqrt(r * r - d * d) : 0;
+  return Span(c - h, c + h);
+}
+
+/** Span of a rectangle at a coordinate, if within the rectangle */
+static Span slab(double x0, double w, double y0, double h, double x) {
+  return x >= x0 && x <= x0 + w ? Span(y0, y0 + h) : Span(y0, y0);
+}
+
+/** Length of the common part of two spans */
+static double common(Span s, Span t) {
+  return std::max(0.0, std::min(s.second, t.second) - std::max(s.first, t.first));
+}
+
+/**
+ * Integrates function by midpoint rule
+ * @param f Function
+ * @param x0 Lower end of the interval
+ * @param x1 Upper end of the interval
+ * @param n Number of steps
+ */
+template <class F>
+static double integrate(F f, double x0, double x1, int n) {
+  const double h = (x1 - x0) / n;
+  double s = 0;
+  for (int i = 0; i < n; ++i)
+    s += f(x0 + (i + 0.5) * h);
+  return s * h;
+}
+
 /**
  * Main test program
  */
@@ -57,9 +141,247 @@ int main(int argc, char * argv[]) {
   cout << " Cube's perimeter is " << pCube->perimeter() << endl;
   cout << " Cube's volume is " << pCube->volume() << endl;
 
+  Geo::StaticCube cubes[] = { Geo::StaticCube(Geo::Coord3D(0, 0, 0), 1),
+                              Geo::StaticCube(Geo::Coord3D(0, 0, 0), 2),
+                              Geo::StaticCube(Geo::Coord3D(0, 0, 0), 3) };
+  cout << "Static cubes with edges 1, 2 and 3" << endl;
+  cout << " Total volume is " << Geo::sum(cubes, Geo::VolumeOf()) << endl;
+
+  Geo::PolyCollection coll;
+  coll.insert(*pCircle);
+  coll.insert(*pSquare);
+  coll.insert(*pSphere);
+  coll.insert(*pCube);
+  cout << "A collection of " << coll.size() << " shapes" << endl;
+  cout << " Total area is " << coll.totalArea() << endl;
+  cout << " Total volume is " << coll.totalVolume() << endl;
+  std::vector<double> ratio = coll.compute(Geo::Metric::volume() / Geo::Metric::area());
+  cout << " Volume to area ratio of the sphere is " << ratio[2] << endl;
+
+  Geo::ShapeStore store;
+  for (int i = 1; i <= 10; ++i) {
+    store.add(Geo::Sphere(Geo::Coord3D(i, i, i), i));
+    store.add(Geo::Cube(Geo::Coord3D(i, i, i), i));
+  }
+  Geo::Query qry = Geo::Query::parse("select volume where type == Sphere and radius > 2.0 and z between 0 and 5");
+  Geo::Query::Result res = qry.run(store);
+  cout << "A store of " << store.size() << " shapes" << endl;
+  cout << " Volume of " << res.count << " spheres with radius over 2 is " << res.sum << endl;
+  std::vector<double> ratios(store.size());
+  store.compute(Geo::Metric::volume() / Geo::Metric::area(), ratios.data());
+  cout << " Volume to area ratio of the largest sphere is " << ratios[18] << endl;
+
+  double radii[] = { 1, 2, 3 };
+  double volumes[3];
+  Geo::Batch<double> batch = { radii, nullptr, 3 };
+  Geo::dispatchKernel<double>(Geo::Measure::Volume, Geo::ShapeType::Sphere, Geo::Layout::Columnar)(batch, volumes);
+  cout << "Batch of spheres with radii 1, 2 and 3 (" << Geo::isaName(Geo::activeIsa()) << ")" << endl;
+  cout << " Volumes are " << volumes[0] << ", " << volumes[1] << " and " << volumes[2] << endl;
+
+  Geo::CsgTree2D lens;
+  lens.intersect(lens.add(Geo::Circle(Geo::Coord2D(0, 0), 1)), lens.add(Geo::Circle(Geo::Coord2D(1.9, 1.9), 1)));
+  Geo::SdfGrid2D grid(lens, 0.001, 0.01);
+  double xs[] = { 0.95, 0.5 };
+  double ys[] = { 0.95, 0.5 };
+  const double * cols[] = { xs, ys };
+  double margins[2];
+  grid.clamped(cols, 2, margins);
+  cout << "Distance grid of disjoint circles' intersection with " << grid.bricks() << " bricks" << endl;
+  cout << " Clamped distances are " << margins[0] << " and " << margins[1] << endl;
+
+  Geo::ShapeStore targets;
+  for (int i = 1; i <= 16; ++i)
+    targets.add(Geo::Circle(Geo::Coord2D(0.1 * i, 0.3 * i), 0.07 * i));
+  const Geo::RayScene scene(targets);
+  Geo::Ray2D rays[8];
+  Geo::RayHit hits[8];
+  for (int k = 0; k < 8; ++k)
+    rays[k] = Geo::Ray2D { Geo::Coord2D(-5, 0.37 * k - 1), Geo::Coord2D(1, 0.55 + 0.01 * k) };
+  scene.castPacket<8>(rays, hits);
+  int agree = 0;
+  for (int k = 0; k < 8; ++k) {
+    double t = std::numeric_limits<double>::infinity();
+    for (int i = 1; i <= 16; ++i)
+      t = std::min(t, Geo::intersect(rays[k], Geo::Circle(Geo::Coord2D(0.1 * i, 0.3 * i), 0.07 * i)));
+    agree += scene.cast(rays[k]).t == t && hits[k].t == t;
+  }
+  cout << "Scene and shapes agree on hits of " << agree << " of 8 rays" << endl;
+  check(agree == 8, "hits of scene and shapes");
+
+  Geo::ShapeStore pairs;
+  pairs.add(Geo::Circle(Geo::Coord2D(0, 0), 1));
+  pairs.add(Geo::Circle(Geo::Coord2D(1.2, 0.5), 0.8));
+  pairs.add(Geo::Rectangle(Geo::Coord2D(-0.3, 0.2), 2, 0.6));
+  pairs.add(Geo::Sphere(Geo::Coord3D(0, 0, 0), 1));
+  pairs.add(Geo::Sphere(Geo::Coord3D(0.7, -0.6, 0.4), 0.9));
+  pairs.add(Geo::Cube(Geo::Coord3D(0.3, -0.4, 0.5), 1.2));
+  pairs.add(Geo::Cube(Geo::Coord3D(-0.5, -0.5, 0.6), 1));
+  const std::uint32_t first[] = { 0, 0, 3, 3, 3 };
+  const std::uint32_t second[] = { 1, 2, 4, 5, 6 };
+  double overlaps[5];
+  Geo::overlaps(pairs, first, second, 5, overlaps);
+  /* Slices of planar shapes are spans of Y at X and of solids spans of Z
+   * at X and Y, which common parts are integrated */
+  auto solid = [](auto f, double x0, double x1, double y0, double y1) {
+    return integrate([&](double x) { return integrate([&](double y) { return f(x, y); }, y0, y1, 2000); },
+                     x0, x1, 2000);
+  };
+  const double brute[] = {
+    integrate([](double x) { return common(chord(0, 1, x), chord(0.5, 0.8, x - 1.2)); }, -1, 1, 200000),
+    integrate([](double x) { return common(chord(0, 1, x), slab(-0.3, 2, 0.2, 0.6, x)); }, -1, 1, 200000),
+    solid([](double x, double y) {
+            return common(chord(0, 1, std::hypot(x, y)), chord(0.4, 0.9, std::hypot(x - 0.7, y + 0.6)));
+          }, -1, 1, -1, 1),
+    solid([](double x, double y) { return common(chord(0, 1, std::hypot(x, y)), Span(0.5, 1.7)); },
+          0.3, 1.5, -0.4, 0.8),
+    solid([](double x, double y) { return common(chord(0, 1, std::hypot(x, y)), Span(0.6, 1.6)); },
+          -0.5, 0.5, -0.5, 0.5)
+  };
+  cout << "Overlaps of circles, circle and rectangle, spheres and sphere and cubes" << endl;
+  cout << " Kernels give " << overlaps[0] << ", " << overlaps[1] << ", " << overlaps[2] << ", "
+       << overlaps[3] << " and " << overlaps[4] << endl;
+  for (int k = 0; k < 5; ++k)
+    check(near(overlaps[k], brute[k], 2e-4), "overlap of pair " + std::to_string(k) + " and its integral");
+  check(Geo::overlapArea(Geo::Circle(Geo::Coord2D(0, 0), 1), Geo::Circle(Geo::Coord2D(1.2, 0.5), 0.8)) ==
+        overlaps[0], "overlap of circles and of the kernel");
+
+  Geo::ShapeStore shapes;
+  shapes.add(Geo::Circle(Geo::Coord2D(0, 0), 2));
+  shapes.add(Geo::Rectangle(Geo::Coord2D(0, 0), 3, 1.5));
+  shapes.add(Geo::Square(Geo::Coord2D(0, 0), 2));
+  shapes.add(Geo::Sphere(Geo::Coord3D(0, 0, 0), 1.5));
+  shapes.add(Geo::Cube(Geo::Coord3D(0, 0, 0), 2));
+  /* Growing rounds the corners and shrinking keeps them sharp */
+  auto offsetMeasure = [](Geo::Measure m, Geo::ShapeType t, double a, double b, double d) {
+    const double pi = M_PI;
+    const bool area = m == Geo::Measure::Area, perimeter = m == Geo::Measure::Perimeter;
+    if (t == Geo::ShapeType::Circle || t == Geo::ShapeType::Sphere) {
+      const double r = std::max(a + d, 0.0);
+      if (t == Geo::ShapeType::Circle)
+        return area ? pi * r * r : perimeter ? 2 * pi * r : 0.0;
+      return area ? 4 * pi * r * r : perimeter ? 2 * pi * r : 4 * pi * r * r * r / 3;
+    }
+    const double w = a, h = t == Geo::ShapeType::Rectangle ? b : a;
+    if (d < 0) {
+      const double u = std::max(w + 2 * d, 0.0), v = std::max(h + 2 * d, 0.0);
+      if (t == Geo::ShapeType::Cube)
+        return area ? 6 * u * u : perimeter ? 0.0 : u * u * u;
+      return area ? u * v : perimeter ? 2 * (u + v) : 0.0;
+    }
+    if (t == Geo::ShapeType::Cube)
+      return area ? 6 * a * a + 6 * pi * a * d + 4 * pi * d * d
+                  : perimeter ? 0.0 : a * a * a + 6 * a * a * d + 3 * pi * a * d * d + 4 * pi * d * d * d / 3;
+    return area ? w * h + 2 * d * (w + h) + pi * d * d : perimeter ? 2 * (w + h) + 2 * pi * d : 0.0;
+  };
+  cout << "Shapes offset by 0.5, -0.25 and -2" << endl;
+  for (double d : { 0.5, -0.25, -2.0 }) {
+    for (Geo::Measure m : { Geo::Measure::Area, Geo::Measure::Perimeter, Geo::Measure::Volume }) {
+      double out[5], total = 0;
+      Geo::offsetMeasure(shapes, m, d, out);
+      for (std::size_t i = 0; i < shapes.size(); ++i) {
+        const double e = offsetMeasure(m, shapes.type(i), shapes.value(Geo::ShapeStore::Column::A, i),
+                                       shapes.value(Geo::ShapeStore::Column::B, i), d);
+        check(near(out[i], e, 1e-12), "offset measure " + std::to_string(int(m)) + " of shape " +
+              std::to_string(i) + " by " + std::to_string(d));
+        total += e;
+      }
+      check(near(Geo::offsetSum(shapes, m, d), total, 1e-12), "sum of offset measure " + std::to_string(int(m)));
+      if (m == Geo::Measure::Area)
+        cout << " Total area by " << d << " is " << total << endl;
+    }
+  }
+
+  /* Shapes of every type spread over a large area with small sizes */
+  std::mt19937_64 rng(1);
+  std::uniform_real_distribution<double> coord(-1000, 1000), size(0.1, 10);
+  Geo::ShapeStore many;
+  for (int i = 0; i < 20000; ++i) {
+    const Geo::Coord3D c(coord(rng), coord(rng), coord(rng));
+    switch (i % 5) {
+    case 0: many.add(Geo::Circle(c.getXY(), size(rng))); break;
+    case 1: many.add(Geo::Rectangle(c.getXY(), size(rng), size(rng))); break;
+    case 2: many.add(Geo::Square(c.getXY(), size(rng))); break;
+    case 3: many.add(Geo::Sphere(c, size(rng))); break;
+    default: many.add(Geo::Cube(c, size(rng))); break;
+    }
+  }
+  /* Values are within the maximal error and measures within measures of
+   * dimensions off by the error, since they grow with the dimensions */
+  auto checkQuantized = [&many](const auto & q, const std::string & name) {
+    for (unsigned c = 0; c < Geo::ShapeStore::column_count; ++c) {
+      const Geo::ShapeStore::Column col = Geo::ShapeStore::Column(c);
+      const double e = q.maxError(col) * (1 + 1e-9);
+      bool within = true;
+      for (std::size_t i = 0; i < many.size(); ++i)
+        within = within && std::fabs(q.value(col, i) - many.value(col, i)) <= e + 1e-12 * std::fabs(many.value(col, i));
+      check(within, name + " values of column " + std::to_string(c) + " within maximal error");
+    }
+    const double ea = q.maxError(Geo::ShapeStore::Column::A), eb = q.maxError(Geo::ShapeStore::Column::B);
+    for (Geo::Measure m : { Geo::Measure::Area, Geo::Measure::Perimeter, Geo::Measure::Volume }) {
+      std::vector<double> out(q.size());
+      q.measure(m, out.data());
+      bool within = true;
+      for (std::size_t i = 0; i < many.size(); ++i) {
+        const Geo::ShapeType t = many.type(i);
+        const double a = many.value(Geo::ShapeStore::Column::A, i), b = many.value(Geo::ShapeStore::Column::B, i);
+        const double lo = Geo::measure(m, t, std::max(a - ea, 0.0), std::max(b - eb, 0.0));
+        const double hi = Geo::measure(m, t, a + ea, b + eb);
+        within = within && out[i] >= lo * (1 - 1e-12) && out[i] <= hi * (1 + 1e-12) && near(out[i], q.measure(m, i), 1e-12);
+      }
+      check(within, name + " measure " + std::to_string(int(m)) + " within bounds of maximal error");
+    }
+  };
+  Geo::QuantizedStore16 q16(many);
+  Geo::QuantizedStore32 q32(many);
+  checkQuantized(q16, "16 bit");
+  checkQuantized(q32, "32 bit");
+  cout << "A store of " << many.size() << " shapes quantized to 16 and 32 bits" << endl;
+  cout << " Maximal errors of X are " << q16.maxError(Geo::ShapeStore::Column::X) << " and "
+       << q32.maxError(Geo::ShapeStore::Column::X) << endl;
+
+  const std::string path = "/tmp/geoex-" + std::to_string(::getpid());
+  Geo::saveStore(many, path + ".geo");
+  const Geo::ShapeStore loaded = Geo::loadStore(path + ".geo");
+  bool same = loaded.size() == many.size();
+  for (std::size_t i = 0; same && i < many.size(); ++i) {
+    same = loaded.type(i) == many.type(i);
+    for (unsigned c = 0; c < Geo::ShapeStore::column_count; ++c)
+      same = same && loaded.value(Geo::ShapeStore::Column(c), i) == many.value(Geo::ShapeStore::Column(c), i);
+  }
+  check(same, "saved and loaded stores are equal");
+  /* Budget of a quarter of megabyte makes several runs to merge */
+  const std::size_t runs = Geo::sortFile(path + ".geo", path + "-sorted.geo", Geo::SortKey::of(Geo::Measure::Area),
+                                         false, std::size_t(256) << 10);
+  const Geo::ShapeStore sorted = Geo::loadStore(path + "-sorted.geo");
+  std::remove((path + ".geo").c_str());
+  std::remove((path + "-sorted.geo").c_str());
+  auto rows = [](const Geo::ShapeStore & s) {
+    std::vector<std::tuple<int, double, double, double, double, double> > r;
+    for (std::size_t i = 0; i < s.size(); ++i)
+      r.emplace_back(int(s.type(i)), s.value(Geo::ShapeStore::Column::X, i), s.value(Geo::ShapeStore::Column::Y, i),
+                     s.value(Geo::ShapeStore::Column::Z, i), s.value(Geo::ShapeStore::Column::A, i),
+                     s.value(Geo::ShapeStore::Column::B, i));
+    std::sort(r.begin(), r.end());
+    return r;
+  };
+  bool ordered = true;
+  for (std::size_t i = 1; i < sorted.size(); ++i)
+    ordered = ordered && Geo::measure(Geo::Measure::Area, sorted.type(i - 1),
+                                      sorted.value(Geo::ShapeStore::Column::A, i - 1),
+                                      sorted.value(Geo::ShapeStore::Column::B, i - 1)) <=
+                         Geo::measure(Geo::Measure::Area, sorted.type(i), sorted.value(Geo::ShapeStore::Column::A, i),
+                                      sorted.value(Geo::ShapeStore::Column::B, i));
+  check(ordered, "sorted file is in order of areas");
+  check(rows(sorted) == rows(many), "sorted file has the shapes of the input");
+  cout << "Shape file of " << many.size() << " shapes saved, loaded and sorted by area in " << runs << " runs" << endl;
+
   delete pCube;
   delete pSphere;
   delete pSquare;
   delete pCircle;
+
+  if (failures > 0)
+    std::cerr << failures << " checks failed" << endl;
+  return failures > 0 ? 1 : 0;
 }
 
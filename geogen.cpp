@@ -0,0 +1,348 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geogen.cpp
+ * Generator of synthetic shape datasets in the binary columnar format from
+ * geo_io.hpp. Rows are generated in chunks by several threads, each chunk
+ * with its own random generator seeded from the chunk number, so output
+ * does not depend on the number of threads.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <getopt.h>
+
+#include "geo_io.hpp"
+
+/** Size distributions */
+enum class SizeDist { Uniform, LogNormal, Zipf };
+
+/** Spatial distributions */
+enum class SpaceDist { Uniform, Clustered, Roads };
+
+/** Generator options */
+struct Options {
+  std::uint64_t count = 1000000;
+  std::string output = "shapes.geo";
+  double mix[Geo::shape_type_count] = { 1, 1, 1, 1, 1 };
+  SizeDist size = SizeDist::Uniform;
+  double size_min = 0.1;
+  double size_max = 10;
+  SpaceDist space = SpaceDist::Uniform;
+  double extent = 10000;
+  unsigned clusters = 32;
+  unsigned roads = 64;
+  double dup = 0;
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  std::uint64_t seed = 1;
+};
+
+/** Fast random generator (xoshiro256**) seeded by splitmix64 */
+struct Rng {
+  std::uint64_t s[4];
+
+  explicit Rng(std::uint64_t seed) {
+    for (auto & v : s) {
+      std::uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      v = z ^ (z >> 31);
+    }
+  }
+
+  static std::uint64_t rotl(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+  std::uint64_t next(void) {
+    const std::uint64_t r = rotl(s[1] * 5, 7) * 9;
+    const std::uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return r;
+  }
+
+  /* Uniform in [0, 1) */
+  double uniform(void) { return double(next() >> 11) * 0x1.0p-53; }
+
+  /* Standard normal by Box-Muller transform */
+  double normal(void) {
+    const double u = 1 - uniform(), v = uniform();
+    return std::sqrt(-2 * std::log(u)) * std::cos(2 * M_PI * v);
+  }
+};
+
+/** Road network-like polyline */
+struct Road {
+  std::vector<double> x;
+  std::vector<double> y;
+};
+
+/** Shared state for generating chunks */
+struct Generator {
+  const Options & opt;
+  double type_cdf[Geo::shape_type_count];
+  std::vector<double> cx, cy;
+  std::vector<Road> roads;
+  std::vector<double> zipf_cdf;
+
+  explicit Generator(const Options & o)
+    : opt(o)
+  {
+    double total = 0;
+    for (unsigned t = 0; t < Geo::shape_type_count; ++t)
+      type_cdf[t] = (total += o.mix[t]);
+    for (double & c : type_cdf)
+      c /= total;
+
+    Rng rng(o.seed);
+    for (unsigned i = 0; i < o.clusters; ++i) {
+      cx.push_back(o.extent * rng.uniform());
+      cy.push_back(o.extent * rng.uniform());
+    }
+    /* Roads are random walks with gentle turns and fixed step */
+    const double step = o.extent / 100;
+    for (unsigned i = 0; i < o.roads; ++i) {
+      Road r;
+      double x = o.extent * rng.uniform(), y = o.extent * rng.uniform(), a = 2 * M_PI * rng.uniform();
+      for (int k = 0; k < 100; ++k) {
+        r.x.push_back(x);
+        r.y.push_back(y);
+        a += 0.2 * rng.normal();
+        x = std::min(std::max(x + step * std::cos(a), 0.0), o.extent);
+        y = std::min(std::max(y + step * std::sin(a), 0.0), o.extent);
+      }
+      roads.push_back(r);
+    }
+    /* Zipf over 1000 size ranks with exponent 1 */
+    total = 0;
+    for (int k = 1; k <= 1000; ++k) {
+      total += 1.0 / k;
+      zipf_cdf.push_back(total);
+    }
+    for (double & c : zipf_cdf)
+      c /= total;
+  }
+
+  double size(Rng & rng) const {
+    const double lo = opt.size_min, hi = opt.size_max;
+    switch (opt.size) {
+    case SizeDist::LogNormal: {
+      /* Median in the geometric middle of the range, most values within it */
+      const double mu = 0.5 * (std::log(lo) + std::log(hi));
+      const double sigma = 0.25 * (std::log(hi) - std::log(lo));
+      return std::min(std::max(std::exp(mu + sigma * rng.normal()), lo), hi);
+    }
+    case SizeDist::Zipf: {
+      const std::size_t rank = std::lower_bound(zipf_cdf.begin(), zipf_cdf.end(), rng.uniform()) - zipf_cdf.begin();
+      return lo + (hi - lo) * double(rank) / double(zipf_cdf.size() - 1);
+    }
+    default:
+      return lo + (hi - lo) * rng.uniform();
+    }
+  }
+
+  void position(Rng & rng, double & x, double & y) const {
+    switch (opt.space) {
+    case SpaceDist::Clustered: {
+      const std::size_t c = std::size_t(rng.uniform() * double(cx.size()));
+      const double sigma = opt.extent / 50;
+      x = cx[c] + sigma * rng.normal();
+      y = cy[c] + sigma * rng.normal();
+      break;
+    }
+    case SpaceDist::Roads: {
+      const Road & r = roads[std::size_t(rng.uniform() * double(roads.size()))];
+      const std::size_t k = std::size_t(rng.uniform() * double(r.x.size() - 1));
+      const double t = rng.uniform();
+      const double sigma = opt.extent / 2000;
+      x = r.x[k] + t * (r.x[k + 1] - r.x[k]) + sigma * rng.normal();
+      y = r.y[k] + t * (r.y[k + 1] - r.y[k]) + sigma * rng.normal();
+      break;
+    }
+    default:
+      x = opt.extent * rng.uniform();
+      y = opt.extent * rng.uniform();
+    }
+  }
+
+  /* Generates rows of a chunk into the buffers */
+  void chunk(std::uint64_t id, std::size_t n, Geo::ShapeType * t, double * const * v) const {
+    Rng rng(opt.seed ^ (0xd1b54a32d192ed03ULL * (id + 1)));
+    for (std::size_t i = 0; i < n; ++i) {
+      if (i > 0 && rng.uniform() < opt.dup) {
+        const std::size_t j = std::size_t(rng.uniform() * double(i));
+        t[i] = t[j];
+        for (unsigned c = 0; c < Geo::ShapeStore::column_count; ++c)
+          v[c][i] = v[c][j];
+        continue;
+      }
+      const double p = rng.uniform();
+      unsigned ty = 0;
+      while (ty + 1 < Geo::shape_type_count && p >= type_cdf[ty])
+        ++ty;
+      t[i] = Geo::ShapeType(ty);
+      position(rng, v[0][i], v[1][i]);
+      const bool is3d = t[i] == Geo::ShapeType::Sphere || t[i] == Geo::ShapeType::Cube;
+      v[2][i] = is3d ? opt.extent * rng.uniform() / 100 : 0;
+      v[3][i] = size(rng);
+      v[4][i] = t[i] == Geo::ShapeType::Rectangle ? size(rng) : 0;
+    }
+  }
+};
+
+static void usage(const char * prog) {
+  std::fprintf(stderr,
+    "Usage: %s [options]\n"
+    "  -n, --count N        number of shapes (default 1000000)\n"
+    "  -o, --output FILE    output file (default shapes.geo)\n"
+    "  -m, --mix C:R:S:P:U  weights of circles, rectangles, squares, spheres and cubes\n"
+    "  -s, --size DIST      uniform, lognormal or zipf (default uniform)\n"
+    "      --size-min X     minimum size (default 0.1)\n"
+    "      --size-max X     maximum size (default 10)\n"
+    "  -p, --space DIST     uniform, clustered or roads (default uniform)\n"
+    "  -e, --extent X       side of the generated area (default 10000)\n"
+    "  -d, --dup RATE       rate of duplicated shapes in [0, 1] (default 0)\n"
+    "  -t, --threads N      number of threads (default all processors)\n"
+    "      --seed N         random seed (default 1)\n", prog);
+}
+
+/**
+ * Generator program
+ */
+int main(int argc, char * argv[]) {
+  Options opt;
+  static const option longopts[] = {
+    { "count",    required_argument, nullptr, 'n' },
+    { "output",   required_argument, nullptr, 'o' },
+    { "mix",      required_argument, nullptr, 'm' },
+    { "size",     required_argument, nullptr, 's' },
+    { "size-min", required_argument, nullptr, 1 },
+    { "size-max", required_argument, nullptr, 2 },
+    { "space",    required_argument, nullptr, 'p' },
+    { "extent",   required_argument, nullptr, 'e' },
+    { "dup",      required_argument, nullptr, 'd' },
+    { "threads",  required_argument, nullptr, 't' },
+    { "seed",     required_argument, nullptr, 3 },
+    { "help",     no_argument,       nullptr, 'h' },
+    { nullptr, 0, nullptr, 0 }
+  };
+  int c;
+  while ((c = getopt_long(argc, argv, "n:o:m:s:p:e:d:t:h", longopts, nullptr)) != -1) {
+    switch (c) {
+    case 'n': opt.count = std::strtoull(optarg, nullptr, 10); break;
+    case 'o': opt.output = optarg; break;
+    case 'm':
+      if (std::sscanf(optarg, "%lf:%lf:%lf:%lf:%lf", &opt.mix[0], &opt.mix[1], &opt.mix[2],
+                      &opt.mix[3], &opt.mix[4]) != 5 ||
+          !std::all_of(std::begin(opt.mix), std::end(opt.mix), [](double w) { return w >= 0; }) ||
+          !(opt.mix[0] + opt.mix[1] + opt.mix[2] + opt.mix[3] + opt.mix[4] > 0)) {
+        std::fprintf(stderr, "%s: mix weights must be non-negative with a positive sum\n", argv[0]);
+        usage(argv[0]);
+        return 1;
+      }
+      break;
+    case 's':
+      if (!std::strcmp(optarg, "uniform")) opt.size = SizeDist::Uniform;
+      else if (!std::strcmp(optarg, "lognormal")) opt.size = SizeDist::LogNormal;
+      else if (!std::strcmp(optarg, "zipf")) opt.size = SizeDist::Zipf;
+      else { usage(argv[0]); return 1; }
+      break;
+    case 1: opt.size_min = std::atof(optarg); break;
+    case 2: opt.size_max = std::atof(optarg); break;
+    case 'p':
+      if (!std::strcmp(optarg, "uniform")) opt.space = SpaceDist::Uniform;
+      else if (!std::strcmp(optarg, "clustered")) opt.space = SpaceDist::Clustered;
+      else if (!std::strcmp(optarg, "roads")) opt.space = SpaceDist::Roads;
+      else { usage(argv[0]); return 1; }
+      break;
+    case 'e': opt.extent = std::atof(optarg); break;
+    case 'd': opt.dup = std::atof(optarg); break;
+    case 't': opt.threads = unsigned(std::max(1, std::atoi(optarg))); break;
+    case 3: opt.seed = std::strtoull(optarg, nullptr, 10); break;
+    default:
+      usage(argv[0]);
+      return c == 'h' ? 0 : 1;
+    }
+  }
+  if (!(opt.size_min > 0 && opt.size_min <= opt.size_max) || opt.dup < 0 || opt.dup > 1 ||
+      !(opt.extent > 0)) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  try {
+    const auto start = std::chrono::steady_clock::now();
+    Geo::ShapeFile file = Geo::ShapeFile::create(opt.output, opt.count);
+    Generator gen(opt);
+    const std::size_t chunk = 1 << 16;
+    const std::uint64_t chunks = (opt.count + chunk - 1) / chunk;
+    std::atomic<std::uint64_t> next(0);
+    std::exception_ptr error;
+    std::atomic<bool> failed(false);
+
+    std::vector<std::thread> workers;
+    for (unsigned w = 0; w < opt.threads; ++w) {
+      workers.emplace_back([&] {
+        std::vector<Geo::ShapeType> t(chunk);
+        std::vector<double> buf(chunk * Geo::ShapeStore::column_count);
+        double * v[Geo::ShapeStore::column_count];
+        for (unsigned k = 0; k < Geo::ShapeStore::column_count; ++k)
+          v[k] = buf.data() + k * chunk;
+        try {
+          for (std::uint64_t id; !failed && (id = next++) < chunks; ) {
+            const std::size_t n = std::size_t(std::min<std::uint64_t>(chunk, opt.count - id * chunk));
+            gen.chunk(id, n, t.data(), v);
+            file.write(id * chunk, n, t.data(), v);
+          }
+        } catch (...) {
+          if (!failed.exchange(true))
+            error = std::current_exception();
+        }
+      });
+    }
+    for (auto & w : workers)
+      w.join();
+    if (error)
+      std::rethrow_exception(error);
+
+    const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double bytes = double(Geo::ShapeFile::fileSize(opt.count));
+    std::printf("Generated %llu shapes in '%s' (%.1f MB) in %.3f s (%.2f GB/s)\n",
+                (unsigned long long)opt.count, opt.output.c_str(), bytes / 1e6, secs,
+                bytes / 1e9 / (secs > 0 ? secs : 1));
+  } catch (const std::exception & e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,156 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geoshard.cpp
+ * Coordinator of sharded execution over a binary shape file. Splits the
+ * file into shards, runs a worker process for each one and prints the
+ * merged aggregate.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include <getopt.h>
+#include <unistd.h>
+
+#include "geo_shard.hpp"
+
+static void usage(const char * prog) {
+  std::fprintf(stderr,
+    "Usage: %s [options] FILE\n"
+    "  -w, --workers N      number of worker processes (default 4)\n"
+    "  -s, --strategy S     range, hash or spatial (default range)\n"
+    "  -c, --cell X         grid cell size for spatial shards (default 100)\n"
+    "  -m, --measure M      area, perimeter or volume for top-K and quantiles (default area)\n"
+    "  -k, --top K          number of largest shapes to print (default 10)\n"
+    "  -q, --query TEXT     query run on every shard, e.g. \"select area where type == Circle\"\n"
+    "  -t, --transport T    pipe or socket (default pipe)\n"
+    "  -d, --dir DIR        directory for shard files (default /tmp)\n", prog);
+}
+
+/**
+ * Sharded execution program
+ */
+int main(int argc, char * argv[]) {
+  std::size_t workers = 4;
+  Geo::ShardStrategy strategy = Geo::ShardStrategy::Range;
+  double cell = 100;
+  Geo::Measure measure = Geo::Measure::Area;
+  std::uint64_t top = 10;
+  std::string query, dir = "/tmp";
+  Geo::TransportKind transport = Geo::TransportKind::Pipe;
+  static const option longopts[] = {
+    { "workers",   required_argument, nullptr, 'w' },
+    { "strategy",  required_argument, nullptr, 's' },
+    { "cell",      required_argument, nullptr, 'c' },
+    { "measure",   required_argument, nullptr, 'm' },
+    { "top",       required_argument, nullptr, 'k' },
+    { "query",     required_argument, nullptr, 'q' },
+    { "transport", required_argument, nullptr, 't' },
+    { "dir",       required_argument, nullptr, 'd' },
+    { "help",      no_argument,       nullptr, 'h' },
+    { nullptr, 0, nullptr, 0 }
+  };
+  int c;
+  while ((c = getopt_long(argc, argv, "w:s:c:m:k:q:t:d:h", longopts, nullptr)) != -1) {
+    switch (c) {
+    case 'w': workers = std::size_t(std::max(1, std::atoi(optarg))); break;
+    case 's':
+      if (!std::strcmp(optarg, "range")) strategy = Geo::ShardStrategy::Range;
+      else if (!std::strcmp(optarg, "hash")) strategy = Geo::ShardStrategy::Hash;
+      else if (!std::strcmp(optarg, "spatial")) strategy = Geo::ShardStrategy::Spatial;
+      else { usage(argv[0]); return 1; }
+      break;
+    case 'c': cell = std::atof(optarg); break;
+    case 'm':
+      if (!std::strcmp(optarg, "area")) measure = Geo::Measure::Area;
+      else if (!std::strcmp(optarg, "perimeter")) measure = Geo::Measure::Perimeter;
+      else if (!std::strcmp(optarg, "volume")) measure = Geo::Measure::Volume;
+      else { usage(argv[0]); return 1; }
+      break;
+    case 'k': top = std::strtoull(optarg, nullptr, 10); break;
+    case 'q': query = optarg; break;
+    case 't':
+      if (!std::strcmp(optarg, "pipe")) transport = Geo::TransportKind::Pipe;
+      else if (!std::strcmp(optarg, "socket")) transport = Geo::TransportKind::Socket;
+      else { usage(argv[0]); return 1; }
+      break;
+    case 'd': dir = optarg; break;
+    default:
+      usage(argv[0]);
+      return c == 'h' ? 0 : 1;
+    }
+  }
+  if (argc - optind != 1 || !(cell > 0)) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  std::vector<Geo::ShardTask> tasks;
+  try {
+    if (!query.empty())
+      Geo::Query::parse(query);
+    const auto start = std::chrono::steady_clock::now();
+    tasks = Geo::splitShapeFile(argv[optind], strategy, workers,
+                                dir + "/geoshard-" + std::to_string(::getpid()) + "-", cell);
+    const auto split = std::chrono::steady_clock::now();
+    for (Geo::ShardTask & t : tasks) {
+      t.measure = measure;
+      t.top = top;
+      t.query = query;
+    }
+    const Geo::ShardResult r = Geo::runSharded(tasks, transport);
+    const auto done = std::chrono::steady_clock::now();
+
+    const Geo::Aggregate & a = r.aggregate;
+    static const char * const measures[Geo::measure_count] = { "area", "perimeter", "volume" };
+    std::printf("%llu shapes in %zu shards (split %.3f s, compute %.3f s)\n",
+                (unsigned long long)a.count(), tasks.size(),
+                std::chrono::duration<double>(split - start).count(),
+                std::chrono::duration<double>(done - split).count());
+    for (unsigned t = 0; t < Geo::shape_type_count; ++t)
+      std::printf("  %-10s %llu\n", Geo::typeName(Geo::ShapeType(t)),
+                  (unsigned long long)a.count(Geo::ShapeType(t)));
+    for (unsigned m = 0; m < Geo::measure_count; ++m)
+      std::printf("  %-10s sum %.6g min %.6g max %.6g\n", measures[m], a.sum(Geo::Measure(m)),
+                  a.min(Geo::Measure(m)), a.max(Geo::Measure(m)));
+    std::printf("%s quantiles: p50 %.6g p90 %.6g p99 %.6g\n", measures[unsigned(measure)],
+                a.quantile(0.5), a.quantile(0.9), a.quantile(0.99));
+    for (const Geo::RankedShape & s : a.top())
+      std::printf("  %-10s %.6g at (%g, %g, %g) a=%g b=%g\n", Geo::typeName(s.type), s.value,
+                  s.v[0], s.v[1], s.v[2], s.v[3], s.v[4]);
+    if (!query.empty())
+      std::printf("query: count %llu sum %.6g\n", (unsigned long long)r.query_count, r.query_sum);
+  } catch (const std::exception & e) {
+    std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+    if (strategy != Geo::ShardStrategy::Range)
+      for (const Geo::ShardTask & t : tasks)
+        ::unlink(t.path.c_str());
+    return 1;
+  }
+  if (strategy != Geo::ShardStrategy::Range)
+    for (const Geo::ShardTask & t : tasks)
+      ::unlink(t.path.c_str());
+  return 0;
+}
@@ -0,0 +1,149 @@
+/* Copyright (C) 2026 Georgi D. Sotirov <gdsotirov@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ */
+
+/**
+ * @file geostream.cpp
+ * Out-of-core evaluation over a binary shape file within a memory budget:
+ * aggregate of all shapes, a query or sorting of the file.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+
+#include <getopt.h>
+
+#include "geo_stream.hpp"
+
+static void usage(const char * prog) {
+  std::fprintf(stderr,
+    "Usage: %s [options] FILE\n"
+    "  -b, --budget MB      memory budget in megabytes (default 64)\n"
+    "  -m, --measure M      area, perimeter or volume for top-K and quantiles (default area)\n"
+    "  -k, --top K          number of largest shapes to print (default 10)\n"
+    "  -q, --query TEXT     run query instead of aggregation\n"
+    "  -s, --sort-by KEY    sort by x, y, z, a, b, area, perimeter or volume\n"
+    "  -r, --reverse        sort in descending order\n"
+    "  -o, --output FILE    output of sorting (default sorted.geo)\n", prog);
+}
+
+static bool parseMeasure(const char * s, Geo::Measure & m) {
+  static const char * const names[Geo::measure_count] = { "area", "perimeter", "volume" };
+  for (unsigned i = 0; i < Geo::measure_count; ++i)
+    if (!std::strcmp(s, names[i])) {
+      m = Geo::Measure(i);
+      return true;
+    }
+  return false;
+}
+
+/**
+ * Out-of-core processing program
+ */
+int main(int argc, char * argv[]) {
+  std::size_t budget = std::size_t(64) << 20;
+  Geo::Measure measure = Geo::Measure::Area;
+  std::size_t top = 10;
+  std::string query, sort_by, output = "sorted.geo";
+  bool reverse = false;
+  static const option longopts[] = {
+    { "budget",  required_argument, nullptr, 'b' },
+    { "measure", required_argument, nullptr, 'm' },
+    { "top",     required_argument, nullptr, 'k' },
+    { "query",   required_argument, nullptr, 'q' },
+    { "sort-by", required_argument, nullptr, 's' },
+    { "reverse", no_argument,       nullptr, 'r' },
+    { "output",  required_argument, nullptr, 'o' },
+    { "help",    no_argument,       nullptr, 'h' },
+    { nullptr, 0, nullptr, 0 }
+  };
+  int c;
+  while ((c = getopt_long(argc, argv, "b:m:k:q:s:ro:h", longopts, nullptr)) != -1) {
+    switch (c) {
+    case 'b': budget = std::size_t(std::max(1, std::atoi(optarg))) << 20; break;
+    case 'm':
+      if (!parseMeasure(optarg, measure)) {
+        usage(argv[0]);
+        return 1;
+      }
+      break;
+    case 'k': top = std::size_t(std::strtoull(optarg, nullptr, 10)); break;
+    case 'q': query = optarg; break;
+    case 's': sort_by = optarg; break;
+    case 'r': reverse = true; break;
+    case 'o': output = optarg; break;
+    default:
+      usage(argv[0]);
+      return c == 'h' ? 0 : 1;
+    }
+  }
+  if (argc - optind != 1) {
+    usage(argv[0]);
+    return 1;
+  }
+  const std::string path = argv[optind];
+
+  try {
+    const auto start = std::chrono::steady_clock::now();
+    if (!sort_by.empty()) {
+      static const char * const columns[Geo::ShapeStore::column_count] = { "x", "y", "z", "a", "b" };
+      Geo::SortKey key = Geo::SortKey::of(Geo::Measure::Area);
+      Geo::Measure m;
+      if (parseMeasure(sort_by.c_str(), m))
+        key = Geo::SortKey::of(m);
+      else {
+        unsigned i = 0;
+        while (i < Geo::ShapeStore::column_count && sort_by != columns[i])
+          ++i;
+        if (i == Geo::ShapeStore::column_count) {
+          usage(argv[0]);
+          return 1;
+        }
+        key = Geo::SortKey::of(Geo::ShapeStore::Column(i));
+      }
+      const std::size_t runs = Geo::sortFile(path, output, key, reverse, budget);
+      std::printf("sorted into %s from %zu runs in %.3f s\n", output.c_str(), runs,
+                  std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    } else if (!query.empty()) {
+      const Geo::Query::Result r = Geo::queryFile(Geo::Query::parse(query), path, budget);
+      std::printf("count %zu sum %.6g (blocks scanned %zu, skipped %zu) in %.3f s\n", r.count, r.sum,
+                  r.blocks_scanned, r.blocks_skipped,
+                  std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    } else {
+      static const char * const measures[Geo::measure_count] = { "area", "perimeter", "volume" };
+      const Geo::Aggregate a = Geo::aggregateFile(path, measure, top, budget);
+      std::printf("%llu shapes in %.3f s\n", (unsigned long long)a.count(),
+                  std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+      for (unsigned m = 0; m < Geo::measure_count; ++m)
+        std::printf("  %-10s sum %.6g min %.6g max %.6g\n", measures[m], a.sum(Geo::Measure(m)),
+                    a.min(Geo::Measure(m)), a.max(Geo::Measure(m)));
+      std::printf("%s quantiles: p50 %.6g p90 %.6g p99 %.6g\n", measures[unsigned(measure)],
+                  a.quantile(0.5), a.quantile(0.9), a.quantile(0.99));
+      for (const Geo::RankedShape & s : a.top())
+        std::printf("  %-10s %.6g at (%g, %g, %g) a=%g b=%g\n", Geo::typeName(s.type), s.value,
+                    s.v[0], s.v[1], s.v[2], s.v[3], s.v[4]);
+    }
+  } catch (const std::exception & e) {
+    std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+    return 1;
+  }
+  return 0;
+}